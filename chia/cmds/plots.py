@@ -1,6 +1,7 @@
 import logging
 import sys
 from pathlib import Path
+from typing import Optional
 
 import click
 
@@ -147,13 +148,41 @@ def create_cmd(
 @click.option("-l", "--list_duplicates", help="List plots with duplicate IDs", default=False, is_flag=True)
 @click.option("--debug-show-memo", help="Shows memo to recreate the same exact plot", default=False, is_flag=True)
 @click.option("--challenge-start", help="Begins at a different [start] for -n [challenges]", type=int, default=None)
+@click.option(
+    "-w", "--workers", help="Number of processes checking plots, defaults to one per disk", type=int, default=None
+)
+@click.option(
+    "--checkpoint",
+    help="File to record results in, running again with it continues an interrupted check",
+    type=click.Path(),
+    default=None,
+)
+@click.option("--json-output", help="Writes the results of all plots to this file as json", type=click.Path())
 @click.pass_context
 def check_cmd(
-    ctx: click.Context, num: int, grep_string: str, list_duplicates: bool, debug_show_memo: bool, challenge_start: int
+    ctx: click.Context,
+    num: int,
+    grep_string: str,
+    list_duplicates: bool,
+    debug_show_memo: bool,
+    challenge_start: int,
+    workers: Optional[int],
+    checkpoint: Optional[str],
+    json_output: Optional[str],
 ):
     from chia.plotting.check_plots import check_plots
 
-    check_plots(ctx.obj["root_path"], num, challenge_start, grep_string, list_duplicates, debug_show_memo)
+    check_plots(
+        ctx.obj["root_path"],
+        num,
+        challenge_start,
+        grep_string,
+        list_duplicates,
+        debug_show_memo,
+        workers,
+        checkpoint,
+        json_output,
+    )
 
 
 @plots_cmd.command("add", short_help="Adds a directory of plots")
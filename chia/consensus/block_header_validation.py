@@ -1,7 +1,7 @@
 import dataclasses
 import logging
 import time
-from typing import Optional, Tuple
+from typing import List, Optional, Tuple
 
 from blspy import AugSchemeMPL
 
@@ -23,7 +23,7 @@ from chia.consensus.vdf_info_computation import get_signage_point_vdf_info
 from chia.types.blockchain_format.classgroup import ClassgroupElement
 from chia.types.blockchain_format.sized_bytes import bytes32
 from chia.types.blockchain_format.slots import ChallengeChainSubSlot, RewardChainSubSlot, SubSlotProofs
-from chia.types.blockchain_format.vdf import VDFInfo, VDFProof
+from chia.types.blockchain_format.vdf import VDFInfo, VDFProof, batch_verify_vdfs
 from chia.types.end_of_slot_bundle import EndOfSubSlotBundle
 from chia.types.header_block import HeaderBlock
 from chia.types.unfinished_header_block import UnfinishedHeaderBlock
@@ -34,6 +34,47 @@ from chia.util.ints import uint8, uint32, uint64, uint128
 log = logging.getLogger(__name__)
 
 
+class BlockVDFs:
+    """
+    Collects the VDF proofs of a block during validation, so that they are verified together at the end. The VDF
+    infos are still compared with the expected ones right away.
+    """
+
+    def __init__(self) -> None:
+        self.proofs: List[Tuple[VDFProof, ClassgroupElement, VDFInfo]] = []
+        self.errors: List[ValidationError] = []
+
+    def add(
+        self,
+        proof: VDFProof,
+        input_el: ClassgroupElement,
+        info: VDFInfo,
+        target_vdf_info: Optional[VDFInfo],
+        error: ValidationError,
+    ) -> bool:
+        """
+        Returns False if info does not match target_vdf_info, otherwise queues the proof, to fail with error
+        """
+        if target_vdf_info is not None and info != target_vdf_info:
+            log.error(f"INVALID VDF INFO. Have: {info} Expected: {target_vdf_info}")
+            return False
+        self.proofs.append((proof, input_el, info))
+        self.errors.append(error)
+        return True
+
+    def verify(self, constants: ConsensusConstants) -> Optional[ValidationError]:
+        """
+        Verifies all queued proofs, and returns the error of the first invalid one
+        """
+        proofs, errors = self.proofs, self.errors
+        self.proofs, self.errors = [], []
+        for (_, _, info), valid, error in zip(proofs, batch_verify_vdfs(constants, proofs), errors):
+            if not valid:
+                log.error(f"Did not validate vdf {info}")
+                return error
+        return None
+
+
 # noinspection PyCallByClass
 def validate_unfinished_header_block(
     constants: ConsensusConstants,
@@ -45,6 +86,7 @@ def validate_unfinished_header_block(
     skip_overflow_last_ss_validation: bool = False,
     skip_vdf_is_valid: bool = False,
     check_sub_epoch_summary=True,
+    block_vdfs: Optional[BlockVDFs] = None,
 ) -> Tuple[Optional[uint64], Optional[ValidationError]]:
     """
     Validates an unfinished header block. This is a block without the infusion VDFs (unfinished)
@@ -56,7 +98,10 @@ def validate_unfinished_header_block(
     released, header_block.finished_sub_slots will be missing one sub-slot. In this case,
     skip_overflow_last_ss_validation must be set to True. This will skip validation of end of slots, sub-epochs,
     and lead to other small tweaks in validation.
+
+    If block_vdfs is passed in, the VDF proofs are added to it and left for the caller to verify.
     """
+    vdfs = block_vdfs if block_vdfs is not None else BlockVDFs()
     # 1. Check that the previous block exists in the blockchain, or that it is correct
 
     prev_b = blocks.try_block_record(header_block.prev_header_hash)
@@ -196,22 +241,22 @@ def validate_unfinished_header_block(
                     ):
                         return None, ValidationError(Err.INVALID_ICC_EOS_VDF)
                     if not skip_vdf_is_valid:
-                        if (
-                            not sub_slot.proofs.infused_challenge_chain_slot_proof.normalized_to_identity
-                            and not sub_slot.proofs.infused_challenge_chain_slot_proof.is_valid(
-                                constants, icc_vdf_input, target_vdf_info, None
+                        if not sub_slot.proofs.infused_challenge_chain_slot_proof.normalized_to_identity:
+                            vdfs.add(
+                                sub_slot.proofs.infused_challenge_chain_slot_proof,
+                                icc_vdf_input,
+                                target_vdf_info,
+                                None,
+                                ValidationError(Err.INVALID_ICC_EOS_VDF),
                             )
-                        ):
-                            return None, ValidationError(Err.INVALID_ICC_EOS_VDF)
-                        if (
-                            sub_slot.proofs.infused_challenge_chain_slot_proof.normalized_to_identity
-                            and not sub_slot.proofs.infused_challenge_chain_slot_proof.is_valid(
-                                constants,
+                        else:
+                            vdfs.add(
+                                sub_slot.proofs.infused_challenge_chain_slot_proof,
                                 ClassgroupElement.get_default_element(),
                                 sub_slot.infused_challenge_chain.infused_challenge_chain_end_of_slot_vdf,
+                                None,
+                                ValidationError(Err.INVALID_ICC_EOS_VDF),
                             )
-                        ):
-                            return None, ValidationError(Err.INVALID_ICC_EOS_VDF)
 
                     if sub_slot.reward_chain.deficit == constants.MIN_BLOCKS_PER_CHALLENGE_BLOCK:
                         # 2g. Check infused challenge sub-slot hash in challenge chain, deficit 16
@@ -305,11 +350,12 @@ def validate_unfinished_header_block(
                 eos_vdf_iters,
                 sub_slot.reward_chain.end_of_slot_vdf.output,
             )
-            if not skip_vdf_is_valid and not sub_slot.proofs.reward_chain_slot_proof.is_valid(
-                constants,
+            if not skip_vdf_is_valid and not vdfs.add(
+                sub_slot.proofs.reward_chain_slot_proof,
                 ClassgroupElement.get_default_element(),
                 sub_slot.reward_chain.end_of_slot_vdf,
                 target_vdf_info,
+                ValidationError(Err.INVALID_RC_EOS_VDF),
             ):
                 return None, ValidationError(Err.INVALID_RC_EOS_VDF)
 
@@ -337,22 +383,22 @@ def validate_unfinished_header_block(
             if not skip_vdf_is_valid:
                 # Pass in None for target info since we are only checking the proof from the temporary point,
                 # but the challenge_chain_end_of_slot_vdf actually starts from the start of slot (for light clients)
-                if (
-                    not sub_slot.proofs.challenge_chain_slot_proof.normalized_to_identity
-                    and not sub_slot.proofs.challenge_chain_slot_proof.is_valid(
-                        constants, cc_start_element, partial_cc_vdf_info, None
+                if not sub_slot.proofs.challenge_chain_slot_proof.normalized_to_identity:
+                    vdfs.add(
+                        sub_slot.proofs.challenge_chain_slot_proof,
+                        cc_start_element,
+                        partial_cc_vdf_info,
+                        None,
+                        ValidationError(Err.INVALID_CC_EOS_VDF),
                     )
-                ):
-                    return None, ValidationError(Err.INVALID_CC_EOS_VDF)
-                if (
-                    sub_slot.proofs.challenge_chain_slot_proof.normalized_to_identity
-                    and not sub_slot.proofs.challenge_chain_slot_proof.is_valid(
-                        constants,
+                else:
+                    vdfs.add(
+                        sub_slot.proofs.challenge_chain_slot_proof,
                         ClassgroupElement.get_default_element(),
                         sub_slot.challenge_chain.challenge_chain_end_of_slot_vdf,
+                        None,
+                        ValidationError(Err.INVALID_CC_EOS_VDF),
                     )
-                ):
-                    return None, ValidationError(Err.INVALID_CC_EOS_VDF)
 
             if genesis_block:
                 # 2r. Check deficit (MIN_SUB.. deficit edge case for genesis block)
@@ -609,11 +655,12 @@ def validate_unfinished_header_block(
             rc_vdf_iters,
             header_block.reward_chain_block.reward_chain_sp_vdf.output,
         )
-        if not skip_vdf_is_valid and not header_block.reward_chain_sp_proof.is_valid(
-            constants,
+        if not skip_vdf_is_valid and not vdfs.add(
+            header_block.reward_chain_sp_proof,
             rc_vdf_input,
             header_block.reward_chain_block.reward_chain_sp_vdf,
             target_vdf_info,
+            ValidationError(Err.INVALID_RC_SP_VDF),
         ):
             return None, ValidationError(Err.INVALID_RC_SP_VDF)
         rc_sp_hash = header_block.reward_chain_block.reward_chain_sp_vdf.output.get_hash()
@@ -659,20 +706,22 @@ def validate_unfinished_header_block(
         ):
             return None, ValidationError(Err.INVALID_CC_SP_VDF)
         if not skip_vdf_is_valid:
-            if (
-                not header_block.challenge_chain_sp_proof.normalized_to_identity
-                and not header_block.challenge_chain_sp_proof.is_valid(constants, cc_vdf_input, target_vdf_info, None)
-            ):
-                return None, ValidationError(Err.INVALID_CC_SP_VDF)
-            if (
-                header_block.challenge_chain_sp_proof.normalized_to_identity
-                and not header_block.challenge_chain_sp_proof.is_valid(
-                    constants,
+            if not header_block.challenge_chain_sp_proof.normalized_to_identity:
+                vdfs.add(
+                    header_block.challenge_chain_sp_proof,
+                    cc_vdf_input,
+                    target_vdf_info,
+                    None,
+                    ValidationError(Err.INVALID_CC_SP_VDF),
+                )
+            else:
+                vdfs.add(
+                    header_block.challenge_chain_sp_proof,
                     ClassgroupElement.get_default_element(),
                     header_block.reward_chain_block.challenge_chain_sp_vdf,
+                    None,
+                    ValidationError(Err.INVALID_CC_SP_VDF),
                 )
-            ):
-                return None, ValidationError(Err.INVALID_CC_SP_VDF)
     else:
         assert overflow is not None
         if header_block.reward_chain_block.challenge_chain_sp_vdf is not None:
@@ -821,6 +870,11 @@ def validate_unfinished_header_block(
             assert prev_transaction_b.timestamp is not None
             if header_block.foliage_transaction_block.timestamp <= prev_transaction_b.timestamp:
                 return None, ValidationError(Err.TIMESTAMP_TOO_FAR_IN_PAST)
+
+    if block_vdfs is None:
+        vdf_error = vdfs.verify(constants)
+        if vdf_error is not None:
+            return None, vdf_error
     return required_iters, None  # Valid unfinished header block
 
 
@@ -836,7 +890,9 @@ def validate_finished_header_block(
     """
     Fully validates the header of a block. A header block is the same  as a full block, but
     without transactions and transaction info. Returns (required_iters, error).
+    All of the block's VDF proofs are verified together, after the other checks passed.
     """
+    vdfs = BlockVDFs()
     unfinished_header_block = UnfinishedHeaderBlock(
         header_block.finished_sub_slots,
         header_block.reward_chain_block.get_unfinished(),
@@ -856,6 +912,7 @@ def validate_finished_header_block(
         expected_sub_slot_iters,
         False,
         check_sub_epoch_summary=check_sub_epoch_summary,
+        block_vdfs=vdfs,
     )
 
     genesis_block = False
@@ -950,27 +1007,22 @@ def validate_finished_header_block(
         log.error(f"{header_block.reward_chain_block.challenge_chain_ip_vdf }. expected {expected}")
         log.error(f"Block: {header_block}")
         return None, ValidationError(Err.INVALID_CC_IP_VDF)
-    if (
-        not header_block.challenge_chain_ip_proof.normalized_to_identity
-        and not header_block.challenge_chain_ip_proof.is_valid(
-            constants,
+    if not header_block.challenge_chain_ip_proof.normalized_to_identity:
+        vdfs.add(
+            header_block.challenge_chain_ip_proof,
             cc_vdf_output,
             cc_target_vdf_info,
             None,
+            ValidationError(Err.INVALID_CC_IP_VDF),
         )
-    ):
-        log.error(f"Did not validate, output {cc_vdf_output}")
-        log.error(f"Block: {header_block}")
-        return None, ValidationError(Err.INVALID_CC_IP_VDF)
-    if (
-        header_block.challenge_chain_ip_proof.normalized_to_identity
-        and not header_block.challenge_chain_ip_proof.is_valid(
-            constants,
+    else:
+        vdfs.add(
+            header_block.challenge_chain_ip_proof,
             ClassgroupElement.get_default_element(),
             header_block.reward_chain_block.challenge_chain_ip_vdf,
+            None,
+            ValidationError(Err.INVALID_CC_IP_VDF),
         )
-    ):
-        return None, ValidationError(Err.INVALID_CC_IP_VDF)
 
     # 30. Check reward chain infusion point VDF
     rc_target_vdf_info = VDFInfo(
@@ -978,11 +1030,12 @@ def validate_finished_header_block(
         ip_vdf_iters,
         header_block.reward_chain_block.reward_chain_ip_vdf.output,
     )
-    if not header_block.reward_chain_ip_proof.is_valid(
-        constants,
+    if not vdfs.add(
+        header_block.reward_chain_ip_proof,
         ClassgroupElement.get_default_element(),
         header_block.reward_chain_block.reward_chain_ip_vdf,
         rc_target_vdf_info,
+        ValidationError(Err.INVALID_RC_IP_VDF),
     ):
         return None, ValidationError(Err.INVALID_RC_IP_VDF)
 
@@ -1039,11 +1092,12 @@ def validate_finished_header_block(
                 header_block.reward_chain_block.infused_challenge_chain_ip_vdf.output,
             )
 
-            if icc_vdf_input is None or not header_block.infused_challenge_chain_ip_proof.is_valid(
-                constants,
+            if icc_vdf_input is None or not vdfs.add(
+                header_block.infused_challenge_chain_ip_proof,
                 icc_vdf_input,
                 header_block.reward_chain_block.infused_challenge_chain_ip_vdf,
                 icc_target_vdf_info,
+                ValidationError(Err.INVALID_ICC_VDF, "invalid icc proof"),
             ):
                 return None, ValidationError(Err.INVALID_ICC_VDF, "invalid icc proof")
     else:
@@ -1060,4 +1114,7 @@ def validate_finished_header_block(
     ) != header_block.reward_chain_block.is_transaction_block:
         return None, ValidationError(Err.INVALID_FOLIAGE_BLOCK_PRESENCE)
 
+    vdf_error = vdfs.verify(constants)
+    if vdf_error is not None:
+        return None, vdf_error
     return required_iters, None
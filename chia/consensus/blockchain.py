@@ -32,12 +32,15 @@ from chia.types.unfinished_block import UnfinishedBlock
 from chia.types.unfinished_header_block import UnfinishedHeaderBlock
 from chia.types.weight_proof import SubEpochChallengeSegment
 from chia.util.errors import Err
-from chia.util.generator_tools import get_block_header, tx_removals_and_additions
+from chia.util.generator_tools import batch_get_block_headers, get_block_header, tx_removals_and_additions
 from chia.util.ints import uint16, uint32, uint64, uint128
 from chia.util.streamable import recurse_jsonify
 
 log = logging.getLogger(__name__)
 
+# Number of header blocks that each validation process builds at a time in get_header_blocks_in_range
+HEADER_BLOCKS_BATCH_SIZE = 32
+
 
 class ReceiveBlockResult(Enum):
     """
@@ -638,34 +641,46 @@ class Blockchain(BlockchainInterface):
         return await self.block_store.get_block_records_in_range(start, stop)
 
     async def get_header_blocks_in_range(self, start: int, stop: int) -> Dict[bytes32, HeaderBlock]:
-        hashes = []
+        heights: List[uint32] = []
+        hashes: List[bytes32] = []
         for height in range(start, stop + 1):
             if self.contains_height(uint32(height)):
-                header_hash: bytes32 = self.height_to_hash(uint32(height))
-                hashes.append(header_hash)
-
-        blocks: List[FullBlock] = []
-        for hash in hashes.copy():
-            block = self.block_store.block_cache.get(hash)
-            if block is not None:
-                blocks.append(block)
-                hashes.remove(hash)
-        blocks_on_disk: List[FullBlock] = await self.block_store.get_blocks_by_hash(hashes)
-        blocks.extend(blocks_on_disk)
-        header_blocks: Dict[bytes32, HeaderBlock] = {}
-
-        for block in blocks:
-            if self.height_to_hash(block.height) != block.header_hash:
-                raise ValueError(f"Block at {block.header_hash} is no longer in the blockchain (it's in a fork)")
-            tx_additions: List[CoinRecord] = [
-                c for c in (await self.coin_store.get_coins_added_at_height(block.height)) if not c.coinbase
-            ]
-            removed: List[CoinRecord] = await self.coin_store.get_coins_removed_at_height(block.height)
-            header = get_block_header(
-                block, [record.coin for record in tx_additions], [record.coin.name() for record in removed]
+                heights.append(uint32(height))
+                hashes.append(self.height_to_hash(uint32(height)))
+        if len(hashes) == 0:
+            return {}
+
+        blocks_bytes: Dict[bytes32, bytes] = await self.block_store.get_blocks_bytes_by_hash(hashes)
+        additions: Dict[uint32, List[CoinRecord]] = await self.coin_store.get_coins_added_in_range(
+            heights[0], heights[-1]
+        )
+        removals: Dict[uint32, List[CoinRecord]] = await self.coin_store.get_coins_removed_in_range(
+            heights[0], heights[-1]
+        )
+        for height, header_hash in zip(heights, hashes):
+            if not self.contains_height(height) or self.height_to_hash(height) != header_hash:
+                raise ValueError(f"Block at {header_hash} is no longer in the blockchain (it's in a fork)")
+
+        # The filters are built in the block validation processes, since that is most of the work
+        futures = []
+        for i in range(0, len(hashes), HEADER_BLOCKS_BATCH_SIZE):
+            batch_heights = heights[i : i + HEADER_BLOCKS_BATCH_SIZE]
+            batch_hashes = hashes[i : i + HEADER_BLOCKS_BATCH_SIZE]
+            futures.append(
+                asyncio.get_running_loop().run_in_executor(
+                    self.pool,
+                    batch_get_block_headers,
+                    [blocks_bytes[header_hash] for header_hash in batch_hashes],
+                    [[r.coin for r in additions.get(height, []) if not r.coinbase] for height in batch_heights],
+                    [[r.coin.name() for r in removals.get(height, [])] for height in batch_heights],
+                )
             )
-            header_blocks[header.header_hash] = header
 
+        header_blocks: Dict[bytes32, HeaderBlock] = {}
+        for batch in await asyncio.gather(*futures):
+            for header_bytes in batch:
+                header = HeaderBlock.from_bytes(header_bytes)
+                header_blocks[header.header_hash] = header
         return header_blocks
 
     async def get_header_block_by_height(self, height: int, header_hash: bytes32) -> Optional[HeaderBlock]:
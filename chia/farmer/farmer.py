@@ -9,20 +9,25 @@ from blspy import G1Element
 import chia.server.ws_connection as ws  # lgtm [py/import-and-import-from]
 from chia.consensus.coinbase import create_puzzlehash_for_pk
 from chia.consensus.constants import ConsensusConstants
-from chia.protocols import farmer_protocol, harvester_protocol
+from chia.farmer.signage_point_store import SignagePointStore
+from chia.protocols import harvester_protocol
 from chia.protocols.protocol_message_types import ProtocolMessageTypes
+from chia.protocols.shared_protocol import Capability
 from chia.server.outbound_message import NodeType, make_msg
 from chia.server.ws_connection import WSChiaConnection
-from chia.types.blockchain_format.proof_of_space import ProofOfSpace
 from chia.types.blockchain_format.sized_bytes import bytes32
 from chia.util.bech32m import decode_puzzle_hash
 from chia.util.config import load_config, save_config
+from chia.util.histogram import Histogram
 from chia.util.ints import uint32, uint64
 from chia.util.keychain import Keychain
 from chia.wallet.derive_keys import master_sk_to_farmer_sk, master_sk_to_pool_sk, master_sk_to_wallet_sk
 
 log = logging.getLogger(__name__)
 
+# Signature requests for harvesters with Capability.BATCH_SIGNATURES are held back this long (in seconds), so that the
+# ones for the same signage point go out in one message
+SIGNATURE_BATCH_DELAY = 0.02
 
 """
 HARVESTER PROTOCOL (FARMER <-> HARVESTER)
@@ -40,21 +45,18 @@ class Farmer:
     ):
         self._root_path = root_path
         self.config = farmer_config
-        # Keep track of all sps, keyed on challenge chain signage point hash
-        self.sps: Dict[bytes32, List[farmer_protocol.NewSignagePoint]] = {}
-
-        # Keep track of harvester plot identifier (str), target sp index, and PoSpace for each challenge
-        self.proofs_of_space: Dict[bytes32, List[Tuple[str, ProofOfSpace]]] = {}
-
-        # Quality string to plot identifier and challenge_hash, for use with harvester.RequestSignatures
-        self.quality_str_to_identifiers: Dict[bytes32, Tuple[str, bytes32, bytes32, bytes32]] = {}
-
-        # number of responses to each signage point
-        self.number_of_responses: Dict[bytes32, int] = {}
+        # Keep track of all sps, the proofs found for them and their quality strings, keyed on challenge chain
+        # signage point hash. Signage points older than two sub slots are removed
+        self.sp_store = SignagePointStore(
+            expiry_seconds=consensus_constants.SUB_SLOT_TIME_TARGET * 2,
+            bucket_seconds=consensus_constants.SUB_SLOT_TIME_TARGET / 10,
+            max_signage_points=consensus_constants.NUM_SPS_SUB_SLOT * 8,
+        )
 
-        # A dictionary of keys to time added. These keys refer to keys in the above 4 dictionaries. This is used
-        # to periodically clear the memory
-        self.cache_add_time: Dict[bytes32, uint64] = {}
+        # Signature requests waiting to be sent, per harvester node id and signage point hash
+        self.pending_signature_requests: Dict[Tuple[bytes32, bytes32], List[harvester_protocol.RequestSignatures]] = {}
+        # Time from receiving a signage point to declaring a proof of space for it
+        self.declare_proof_latency = Histogram()
 
         self.cache_clear_task: asyncio.Task
         self.constants = consensus_constants
@@ -130,6 +132,52 @@ class Farmer:
     def get_private_keys(self):
         return self._private_keys
 
+    async def request_signatures(
+        self, node_id: bytes32, request: harvester_protocol.RequestSignatures, batch: bool = True
+    ) -> None:
+        """
+        Set batch to False for requests that have nothing to be batched with, like the signatures of a block, so that
+        they do not wait SIGNATURE_BATCH_DELAY
+        """
+        connection = self.server.all_connections.get(node_id)
+        if connection is None:
+            self.log.warning(f"Cannot request signatures, harvester {node_id} is not connected")
+            return
+        if not batch or not connection.has_capability(Capability.BATCH_SIGNATURES):
+            await connection.send_message(make_msg(ProtocolMessageTypes.request_signatures, request))
+            return
+
+        key = (node_id, request.sp_hash)
+        pending = self.pending_signature_requests.get(key)
+        if pending is not None:
+            pending.append(request)
+            return
+        self.pending_signature_requests[key] = [request]
+        asyncio.create_task(self._send_signature_requests(key))
+
+    async def _send_signature_requests(self, key: Tuple[bytes32, bytes32]) -> None:
+        await asyncio.sleep(SIGNATURE_BATCH_DELAY)
+        requests = self.pending_signature_requests.pop(key)
+        node_id, sp_hash = key
+        connection = self.server.all_connections.get(node_id)
+        if connection is None:
+            self.log.warning(f"Dropping {len(requests)} signature requests, harvester {node_id} disconnected")
+            return
+        self.log.debug(f"Requesting {len(requests)} signatures for {sp_hash} from {node_id}")
+        msg = make_msg(
+            ProtocolMessageTypes.request_signatures_batch, harvester_protocol.RequestSignaturesBatch(requests)
+        )
+        # This runs as its own task, so nobody else would see the error
+        try:
+            await connection.send_message(msg)
+        except Exception as e:
+            self.log.error(f"Error sending {len(requests)} signature requests to {node_id}: {e}")
+
+    def add_declare_proof_latency(self, received_time: float) -> None:
+        latency = time.time() - received_time
+        self.declare_proof_latency.add(latency)
+        self.log.info(f"Declaring proof of space {latency:.3f} seconds after the signage point")
+
     def get_reward_targets(self, search_for_private_key: bool) -> Dict:
         if search_for_private_key:
             all_sks = self.keychain.get_all_private_keys()
@@ -170,22 +218,12 @@ class Farmer:
     async def _periodically_clear_cache_task(self):
         time_slept: uint64 = uint64(0)
         while not self._shut_down:
-            if time_slept > self.constants.SUB_SLOT_TIME_TARGET:
-                now = time.time()
-                removed_keys: List[bytes32] = []
-                for key, add_time in self.cache_add_time.items():
-                    if now - float(add_time) > self.constants.SUB_SLOT_TIME_TARGET * 2:
-                        self.sps.pop(key, None)
-                        self.proofs_of_space.pop(key, None)
-                        self.quality_str_to_identifiers.pop(key, None)
-                        self.number_of_responses.pop(key, None)
-                        removed_keys.append(key)
-                for key in removed_keys:
-                    self.cache_add_time.pop(key, None)
+            if time_slept > self.sp_store.bucket_seconds:
+                removed = self.sp_store.expire()
                 time_slept = uint64(0)
                 log.debug(
-                    f"Cleared farmer cache. Num sps: {len(self.sps)} {len(self.proofs_of_space)} "
-                    f"{len(self.quality_str_to_identifiers)} {len(self.number_of_responses)}"
+                    f"Cleared farmer cache, removed {removed} sps. Num sps: {len(self.sp_store.states)} "
+                    f"{len(self.sp_store.quality_str_to_identifiers)}"
                 )
             time_slept += 1
             await asyncio.sleep(1)
@@ -1,4 +1,3 @@
-import time
 from typing import Callable, Optional
 
 from blspy import AugSchemeMPL, G2Element
@@ -14,6 +13,10 @@ from chia.types.blockchain_format.proof_of_space import ProofOfSpace
 from chia.util.api_decorators import api_request, peer_required
 from chia.util.ints import uint32, uint64
 
+# This will likely never be reached by any farmer with less than 10% of global space
+# It's meant to make testnets more stable
+MAX_POS_PER_SP = 5
+
 
 class FarmerAPI:
     farmer: Farmer
@@ -33,28 +36,21 @@ class FarmerAPI:
         This is a response from the harvester, for a NewChallenge. Here we check if the proof
         of space is sufficiently good, and if so, we ask for the whole proof.
         """
-        if new_proof_of_space.sp_hash not in self.farmer.number_of_responses:
-            self.farmer.number_of_responses[new_proof_of_space.sp_hash] = 0
-            self.farmer.cache_add_time[new_proof_of_space.sp_hash] = uint64(int(time.time()))
-
-        max_pos_per_sp = 5
-        if self.farmer.number_of_responses[new_proof_of_space.sp_hash] > max_pos_per_sp:
-            # This will likely never happen for any farmer with less than 10% of global space
-            # It's meant to make testnets more stable
-            self.farmer.log.info(
-                f"Surpassed {max_pos_per_sp} PoSpace for one SP, no longer submitting PoSpace for signage point "
-                f"{new_proof_of_space.sp_hash}"
+        sp_state = self.farmer.sp_store.get(new_proof_of_space.sp_hash)
+        if sp_state is None:
+            self.farmer.log.warning(
+                f"Received response for a signage point that we do not have {new_proof_of_space.sp_hash}"
             )
             return
 
-        if new_proof_of_space.sp_hash not in self.farmer.sps:
-            self.farmer.log.warning(
-                f"Received response for a signage point that we do not have {new_proof_of_space.sp_hash}"
+        if sp_state.number_of_responses > MAX_POS_PER_SP:
+            self.farmer.log.info(
+                f"Surpassed {MAX_POS_PER_SP} PoSpace for one SP, no longer submitting PoSpace for signage point "
+                f"{new_proof_of_space.sp_hash}"
             )
             return
 
-        sps = self.farmer.sps[new_proof_of_space.sp_hash]
-        for sp in sps:
+        for sp in sp_state.sps:
             computed_quality_string = new_proof_of_space.proof.verify_and_get_quality_string(
                 self.farmer.constants,
                 new_proof_of_space.challenge_hash,
@@ -64,7 +60,7 @@ class FarmerAPI:
                 self.farmer.log.error(f"Invalid proof of space {new_proof_of_space.proof}")
                 return
 
-            self.farmer.number_of_responses[new_proof_of_space.sp_hash] += 1
+            sp_state.number_of_responses += 1
 
             required_iters: uint64 = calculate_iterations_quality(
                 self.farmer.constants.DIFFICULTY_CONSTANT_FACTOR,
@@ -84,41 +80,67 @@ class FarmerAPI:
                 [sp.challenge_chain_sp, sp.reward_chain_sp],
             )
 
-            if new_proof_of_space.sp_hash not in self.farmer.proofs_of_space:
-                self.farmer.proofs_of_space[new_proof_of_space.sp_hash] = [
-                    (
-                        new_proof_of_space.plot_identifier,
-                        new_proof_of_space.proof,
-                    )
-                ]
-            else:
-                self.farmer.proofs_of_space[new_proof_of_space.sp_hash].append(
-                    (
-                        new_proof_of_space.plot_identifier,
-                        new_proof_of_space.proof,
-                    )
-                )
-            self.farmer.cache_add_time[new_proof_of_space.sp_hash] = uint64(int(time.time()))
-            self.farmer.quality_str_to_identifiers[computed_quality_string] = (
+            self.farmer.sp_store.add_proof(
+                sp_state,
                 new_proof_of_space.plot_identifier,
-                new_proof_of_space.challenge_hash,
-                new_proof_of_space.sp_hash,
-                peer.peer_node_id,
+                new_proof_of_space.proof,
+                computed_quality_string,
+                (
+                    new_proof_of_space.plot_identifier,
+                    new_proof_of_space.challenge_hash,
+                    new_proof_of_space.sp_hash,
+                    peer.peer_node_id,
+                ),
             )
-            self.farmer.cache_add_time[computed_quality_string] = uint64(int(time.time()))
 
-            return make_msg(ProtocolMessageTypes.request_signatures, request)
+            await self.farmer.request_signatures(peer.peer_node_id, request)
+            return
+
+    @api_request
+    async def new_quality_harvester(self, new_quality: harvester_protocol.NewQualityHarvester):
+        """
+        The harvester found a quality for a signage point, and only reads the full proof from disk if we ask for it.
+        We do, unless the quality is not good enough, or we already asked for enough proofs for this signage point.
+        """
+        sp_state = self.farmer.sp_store.get(new_quality.sp_hash)
+        if sp_state is None:
+            self.farmer.log.warning(f"Received quality for a signage point that we do not have {new_quality.sp_hash}")
+            return
+
+        if new_quality.required_iters >= calculate_sp_interval_iters(
+            self.farmer.constants, sp_state.sps[0].sub_slot_iters
+        ):
+            self.farmer.log.warning(f"Received quality that is not good enough for {new_quality.sp_hash}")
+            return
+
+        if sp_state.number_of_requested_proofs >= MAX_POS_PER_SP:
+            self.farmer.log.info(
+                f"Already requested {sp_state.number_of_requested_proofs} proofs for signage point "
+                f"{new_quality.sp_hash}"
+            )
+            return
+        sp_state.number_of_requested_proofs += 1
+
+        request = harvester_protocol.RequestProofOfSpace(
+            new_quality.challenge_hash,
+            new_quality.sp_hash,
+            new_quality.plot_identifier,
+            new_quality.quality_index,
+            new_quality.signage_point_index,
+        )
+        return make_msg(ProtocolMessageTypes.request_proof_of_space, request)
 
     @api_request
     async def respond_signatures(self, response: harvester_protocol.RespondSignatures):
         """
         There are two cases: receiving signatures for sps, or receiving signatures for the block.
         """
-        if response.sp_hash not in self.farmer.sps:
+        sp_state = self.farmer.sp_store.get(response.sp_hash)
+        if sp_state is None:
             self.farmer.log.warning(f"Do not have challenge hash {response.challenge_hash}")
             return
         is_sp_signatures: bool = False
-        sps = self.farmer.sps[response.sp_hash]
+        sps = sp_state.sps
         signage_point_index = sps[0].signage_point_index
         found_sp_hash_debug = False
         for sp_candidate in sps:
@@ -130,7 +152,7 @@ class FarmerAPI:
             assert is_sp_signatures
 
         pospace = None
-        for plot_identifier, candidate_pospace in self.farmer.proofs_of_space[response.sp_hash]:
+        for plot_identifier, candidate_pospace in sp_state.proofs_of_space:
             if plot_identifier == response.plot_identifier:
                 pospace = candidate_pospace
         assert pospace is not None
@@ -193,6 +215,7 @@ class FarmerAPI:
                         pool_target,
                         pool_target_signature,
                     )
+                    self.farmer.add_declare_proof_latency(sp_state.received_time)
                     self.farmer.state_changed("proof", {"proof": request, "passed_filter": True})
                     msg = make_msg(ProtocolMessageTypes.declare_proof_of_space, request)
                     await self.farmer.server.send_to_all([msg], NodeType.FULL_NODE)
@@ -231,6 +254,15 @@ class FarmerAPI:
                     msg = make_msg(ProtocolMessageTypes.signed_values, request_to_nodes)
                     await self.farmer.server.send_to_all([msg], NodeType.FULL_NODE)
 
+    @api_request
+    async def respond_signatures_batch(self, response: harvester_protocol.RespondSignaturesBatch):
+        for signatures in response.responses:
+            # One bad response should not lose the signatures of the other proofs
+            try:
+                await self.respond_signatures(signatures)
+            except Exception as e:
+                self.farmer.log.error(f"Error handling signatures for {signatures.plot_identifier}: {e}")
+
     """
     FARMER PROTOCOL (FARMER <-> FULL NODE)
     """
@@ -247,30 +279,25 @@ class FarmerAPI:
 
         msg = make_msg(ProtocolMessageTypes.new_signage_point_harvester, message)
         await self.farmer.server.send_to_all([msg], NodeType.HARVESTER)
-        if new_signage_point.challenge_chain_sp not in self.farmer.sps:
-            self.farmer.sps[new_signage_point.challenge_chain_sp] = []
-        self.farmer.sps[new_signage_point.challenge_chain_sp].append(new_signage_point)
-        self.farmer.cache_add_time[new_signage_point.challenge_chain_sp] = uint64(int(time.time()))
+        self.farmer.sp_store.add_signage_point(new_signage_point)
         self.farmer.state_changed("new_signage_point", {"sp_hash": new_signage_point.challenge_chain_sp})
 
     @api_request
     async def request_signed_values(self, full_node_request: farmer_protocol.RequestSignedValues):
-        if full_node_request.quality_string not in self.farmer.quality_str_to_identifiers:
+        identifiers = self.farmer.sp_store.quality_str_to_identifiers.get(full_node_request.quality_string)
+        if identifiers is None:
             self.farmer.log.error(f"Do not have quality string {full_node_request.quality_string}")
             return
 
-        (plot_identifier, challenge_hash, sp_hash, node_id) = self.farmer.quality_str_to_identifiers[
-            full_node_request.quality_string
-        ]
+        (plot_identifier, challenge_hash, sp_hash, node_id) = identifiers
         request = harvester_protocol.RequestSignatures(
             plot_identifier,
             challenge_hash,
             sp_hash,
             [full_node_request.foliage_block_data_hash, full_node_request.foliage_transaction_block_hash],
         )
-
-        msg = make_msg(ProtocolMessageTypes.request_signatures, request)
-        await self.farmer.server.send_to_specific([msg], node_id)
+        # A block is signed on its own, so this is sent right away instead of waiting to be batched
+        await self.farmer.request_signatures(node_id, request, batch=False)
 
     @api_request
     async def farming_info(self, request: farmer_protocol.FarmingInfo):
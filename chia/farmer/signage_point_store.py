@@ -0,0 +1,115 @@
+import time
+from collections import OrderedDict
+from dataclasses import dataclass, field
+from typing import Dict, List, Optional, Tuple
+
+from chia.protocols import farmer_protocol
+from chia.types.blockchain_format.proof_of_space import ProofOfSpace
+from chia.types.blockchain_format.sized_bytes import bytes32
+
+
+@dataclass
+class SignagePointState:
+    # All sps with this challenge chain sp hash
+    sps: List[farmer_protocol.NewSignagePoint] = field(default_factory=list)
+    # Harvester plot identifier (str) and PoSpace of each proof found for the signage point
+    proofs_of_space: List[Tuple[str, ProofOfSpace]] = field(default_factory=list)
+    # Quality strings of the proofs, so that they are removed with the signage point
+    quality_strings: List[bytes32] = field(default_factory=list)
+    number_of_responses: int = 0
+    number_of_requested_proofs: int = 0
+    # When the first sp with this hash was received
+    received_time: float = 0
+
+
+class SignagePointStore:
+    """
+    The farmer's state for each signage point, keyed on challenge chain signage point hash. Signage points are put in
+    buckets of bucket_seconds by the time they are first seen, and expire a whole bucket at a time, instead of by
+    scanning every key. At most max_signage_points are kept, the oldest are dropped first.
+    """
+
+    def __init__(self, expiry_seconds: float, bucket_seconds: float, max_signage_points: int):
+        self.expiry_seconds = expiry_seconds
+        self.bucket_seconds = bucket_seconds
+        self.max_signage_points = max_signage_points
+        self.states: Dict[bytes32, SignagePointState] = {}
+        # Bucket number to the sp hashes first seen in it, oldest bucket first
+        self.buckets: "OrderedDict[int, List[bytes32]]" = OrderedDict()
+        # Quality string to plot identifier, challenge_hash, sp_hash and harvester node id, for RequestSignatures
+        self.quality_str_to_identifiers: Dict[bytes32, Tuple[str, bytes32, bytes32, bytes32]] = {}
+
+    def get(self, sp_hash: bytes32) -> Optional[SignagePointState]:
+        return self.states.get(sp_hash)
+
+    def add_signage_point(self, sp: farmer_protocol.NewSignagePoint, now: Optional[float] = None) -> None:
+        state = self.states.get(sp.challenge_chain_sp)
+        if state is None:
+            if now is None:
+                now = time.time()
+            state = SignagePointState(received_time=now)
+            self.states[sp.challenge_chain_sp] = state
+            bucket = int(now // self.bucket_seconds)
+            if bucket not in self.buckets:
+                self.buckets[bucket] = []
+            self.buckets[bucket].append(sp.challenge_chain_sp)
+            self._drop_oldest()
+        state.sps.append(sp)
+
+    def add_proof(
+        self,
+        state: SignagePointState,
+        plot_identifier: str,
+        proof: ProofOfSpace,
+        quality_string: bytes32,
+        identifiers: Tuple[str, bytes32, bytes32, bytes32],
+    ) -> None:
+        state.proofs_of_space.append((plot_identifier, proof))
+        state.quality_strings.append(quality_string)
+        self.quality_str_to_identifiers[quality_string] = identifiers
+
+    def expire(self, now: Optional[float] = None) -> int:
+        """
+        Removes the buckets that are completely older than expiry_seconds, returns the number of signage points removed
+        """
+        oldest_kept = int(((time.time() if now is None else now) - self.expiry_seconds) // self.bucket_seconds)
+        removed = 0
+        while len(self.buckets) > 0:
+            bucket, sp_hashes = next(iter(self.buckets.items()))
+            if bucket >= oldest_kept:
+                break
+            self.buckets.popitem(last=False)
+            for sp_hash in sp_hashes:
+                self._remove(sp_hash)
+            removed += len(sp_hashes)
+        return removed
+
+    def _drop_oldest(self) -> None:
+        while len(self.states) > self.max_signage_points:
+            bucket, sp_hashes = next(iter(self.buckets.items()))
+            self._remove(sp_hashes.pop(0))
+            if len(sp_hashes) == 0:
+                del self.buckets[bucket]
+
+    def _remove(self, sp_hash: bytes32) -> None:
+        state = self.states.pop(sp_hash, None)
+        if state is None:
+            return
+        for quality_string in state.quality_strings:
+            self.quality_str_to_identifiers.pop(quality_string, None)
+
+    def get_counters(self) -> Dict:
+        return {
+            "signage_points": len(self.states),
+            "buckets": len(self.buckets),
+            "qualities": len(self.quality_str_to_identifiers),
+            "entries": {
+                sp_hash.hex(): {
+                    "sps": len(state.sps),
+                    "proofs": len(state.proofs_of_space),
+                    "responses": state.number_of_responses,
+                    "requested_proofs": state.number_of_requested_proofs,
+                }
+                for sp_hash, state in self.states.items()
+            },
+        }
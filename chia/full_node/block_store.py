@@ -1,3 +1,4 @@
+import asyncio
 import logging
 from typing import Dict, List, Optional, Tuple
 
@@ -6,6 +7,7 @@ import aiosqlite
 from chia.consensus.block_record import BlockRecord
 from chia.types.blockchain_format.sized_bytes import bytes32
 from chia.types.blockchain_format.sub_epoch_summary import SubEpochSummary
+from chia.types.blockchain_format.vdf import CompressibleVDFField, VDFInfo
 from chia.types.full_block import FullBlock
 from chia.types.weight_proof import SubEpochChallengeSegment, SubEpochSegments
 from chia.util.db_wrapper import DBWrapper
@@ -15,6 +17,20 @@ from chia.util.lru_cache import LRUCache
 log = logging.getLogger(__name__)
 
 
+def _uncompact_vdf_rows(block: FullBlock, deficit: int) -> List[Tuple[str, int, int, bytes, int]]:
+    return [
+        (block.header_hash.hex(), block.height, int(field_vdf), bytes(vdf_info), deficit)
+        for field_vdf, vdf_info in block.get_uncompact_vdfs()
+    ]
+
+
+def _parse_uncompact_vdf_rows(blocks: List[Tuple[bytes, bytes]]) -> List[List[Tuple[str, int, int, bytes, int]]]:
+    return [
+        _uncompact_vdf_rows(FullBlock.from_bytes(block_bytes), BlockRecord.from_bytes(record_bytes).deficit)
+        for block_bytes, record_bytes in blocks
+    ]
+
+
 class BlockStore:
     db: aiosqlite.Connection
     block_cache: LRUCache
@@ -55,9 +71,23 @@ class BlockStore:
         await self.db.execute("CREATE INDEX IF NOT EXISTS is_block on full_blocks(is_block)")
         await self.db.execute("CREATE INDEX IF NOT EXISTS is_fully_compactified on full_blocks(is_fully_compactified)")
 
+        # Uncompact VDFs of each block, for finding bluebox work without reading the blocks. Blocks stored before this
+        # table existed are added by backfill_uncompact_vdfs, starting from the height in uncompact_vdfs_backfill
+        cursor = await self.db.execute("SELECT name FROM sqlite_master WHERE type='table' AND name='uncompact_vdfs'")
+        uncompact_vdfs_exists = await cursor.fetchone() is not None
+        await cursor.close()
+        await self.db.execute(
+            "CREATE TABLE IF NOT EXISTS uncompact_vdfs(header_hash text, height bigint, field_vdf tinyint,"
+            " vdf_info blob, deficit tinyint, PRIMARY KEY(header_hash, field_vdf, vdf_info))"
+        )
+        await self.db.execute("CREATE TABLE IF NOT EXISTS uncompact_vdfs_backfill(next_height bigint)")
+        if not uncompact_vdfs_exists:
+            await self.db.execute("INSERT INTO uncompact_vdfs_backfill VALUES(0)")
+
         await self.db.execute("CREATE INDEX IF NOT EXISTS height on block_records(height)")
 
         await self.db.execute("CREATE INDEX IF NOT EXISTS hh on block_records(header_hash)")
+        await self.db.execute("CREATE INDEX IF NOT EXISTS uncompact_vdf_height on uncompact_vdfs(height)")
         await self.db.execute("CREATE INDEX IF NOT EXISTS peak on block_records(is_peak)")
         await self.db.execute("CREATE INDEX IF NOT EXISTS is_block on block_records(is_block)")
 
@@ -100,6 +130,18 @@ class BlockStore:
             ),
         )
         await cursor_2.close()
+        await self._set_uncompact_vdfs(block, block_record)
+
+    async def _set_uncompact_vdfs(self, block: FullBlock, block_record: BlockRecord) -> None:
+        await self._replace_uncompact_vdfs(block.header_hash, _uncompact_vdf_rows(block, block_record.deficit))
+
+    async def _replace_uncompact_vdfs(self, header_hash: bytes32, rows: List[Tuple[str, int, int, bytes, int]]) -> None:
+        cursor_1 = await self.db.execute("DELETE FROM uncompact_vdfs WHERE header_hash=?", (header_hash.hex(),))
+        await cursor_1.close()
+        if len(rows) == 0:
+            return
+        cursor_2 = await self.db.executemany("INSERT OR REPLACE INTO uncompact_vdfs VALUES(?, ?, ?, ?, ?)", rows)
+        await cursor_2.close()
 
     async def persist_sub_epoch_challenge_segments(
         self, ses_block_hash: bytes32, segments: List[SubEpochChallengeSegment]
@@ -218,6 +260,35 @@ class BlockStore:
             ret.append(all_blocks[hh])
         return ret
 
+    async def get_blocks_bytes_by_hash(self, header_hashes: List[bytes32]) -> Dict[bytes32, bytes]:
+        """
+        Returns the serialized full blocks by header hash, without parsing the ones that are read from disk.
+        Throws an exception if the blocks are not present
+        """
+        ret: Dict[bytes32, bytes] = {}
+        to_fetch: List[str] = []
+        for hh in header_hashes:
+            cached = self.block_cache.get(hh)
+            if cached is not None:
+                ret[hh] = bytes(cached)
+            else:
+                to_fetch.append(hh.hex())
+
+        if len(to_fetch) > 0:
+            formatted_str = (
+                f'SELECT header_hash, block from full_blocks WHERE header_hash in ({"?," * (len(to_fetch) - 1)}?)'
+            )
+            cursor = await self.db.execute(formatted_str, tuple(to_fetch))
+            rows = await cursor.fetchall()
+            await cursor.close()
+            for row in rows:
+                ret[bytes32(bytes.fromhex(row[0]))] = row[1]
+
+        for hh in header_hashes:
+            if hh not in ret:
+                raise ValueError(f"Header hash {hh} not in the blockchain")
+        return ret
+
     async def get_block_record(self, header_hash: bytes32) -> Optional[BlockRecord]:
         cursor = await self.db.execute(
             "SELECT block from block_records WHERE header_hash=?",
@@ -357,12 +428,95 @@ class BlockStore:
             return None
         return bool(row[0])
 
-    async def get_first_not_compactified(self, min_height: int) -> Optional[int]:
-        cursor = await self.db.execute(
-            "SELECT MIN(height) from full_blocks WHERE is_fully_compactified=0 AND height>=?", (min_height,)
-        )
+    async def get_uncompact_vdfs(
+        self, max_height: uint32, limit: int, challenge_block_deficit: Optional[int] = None
+    ) -> List[Tuple[bytes32, uint32, CompressibleVDFField, VDFInfo]]:
+        """
+        Returns up to limit uncompact VDFs at or below max_height, lowest first, as header hash, height, field and
+        VDF info. These can include blocks that are no longer in the main chain. If challenge_block_deficit is given,
+        signage point and infusion point VDFs are only returned for blocks with that deficit (challenge blocks).
+        """
+        if challenge_block_deficit is None:
+            cursor = await self.db.execute(
+                "SELECT header_hash, height, field_vdf, vdf_info from uncompact_vdfs WHERE height<=? "
+                "ORDER BY height LIMIT ?",
+                (max_height, limit),
+            )
+        else:
+            cursor = await self.db.execute(
+                "SELECT header_hash, height, field_vdf, vdf_info from uncompact_vdfs WHERE height<=? "
+                "AND (field_vdf IN (?, ?) OR deficit=?) ORDER BY height LIMIT ?",
+                (
+                    max_height,
+                    int(CompressibleVDFField.CC_EOS_VDF),
+                    int(CompressibleVDFField.ICC_EOS_VDF),
+                    challenge_block_deficit,
+                    limit,
+                ),
+            )
+        rows = await cursor.fetchall()
+        await cursor.close()
+        return [
+            (bytes32(bytes.fromhex(row[0])), uint32(row[1]), CompressibleVDFField(row[2]), VDFInfo.from_bytes(row[3]))
+            for row in rows
+        ]
+
+    async def remove_uncompact_vdfs(self, header_hashes: List[bytes32]) -> None:
+        async with self.db_wrapper.lock:
+            cursor = await self.db.executemany(
+                "DELETE FROM uncompact_vdfs WHERE header_hash=?", [(hh.hex(),) for hh in header_hashes]
+            )
+            await cursor.close()
+            await self.db.commit()
+
+    async def get_uncompact_vdfs_backfill_height(self) -> Optional[uint32]:
+        """
+        Returns the height to continue backfill_uncompact_vdfs from, or None if it is done
+        """
+        cursor = await self.db.execute("SELECT next_height from uncompact_vdfs_backfill")
         row = await cursor.fetchone()
         await cursor.close()
         if row is None:
             return None
-        return int(row[0])
+        return uint32(row[0])
+
+    async def backfill_uncompact_vdfs(self, start: uint32, count: int) -> Optional[uint32]:
+        """
+        Adds the uncompact VDFs of the stored blocks with heights from start to start + count - 1, and returns the next
+        height to backfill, or None if there are no higher blocks. The blocks are parsed in a thread, without holding
+        the database lock.
+        """
+        cursor = await self.db.execute(
+            "SELECT full_blocks.header_hash, full_blocks.block, block_records.block from full_blocks "
+            "INNER JOIN block_records ON full_blocks.header_hash=block_records.header_hash "
+            "WHERE full_blocks.height>=? AND full_blocks.height<? AND full_blocks.is_fully_compactified=0",
+            (start, start + count),
+        )
+        blocks = await cursor.fetchall()
+        await cursor.close()
+        vdf_rows: List[List[Tuple[str, int, int, bytes, int]]] = await asyncio.get_running_loop().run_in_executor(
+            None, _parse_uncompact_vdf_rows, [(block_bytes, record_bytes) for _, block_bytes, record_bytes in blocks]
+        )
+
+        async with self.db_wrapper.lock:
+            for (header_hash_hex, block_bytes, _), rows in zip(blocks, vdf_rows):
+                # Skip blocks that were replaced by a compact version since they were read, they are already indexed
+                cursor = await self.db.execute("SELECT block from full_blocks WHERE header_hash=?", (header_hash_hex,))
+                row = await cursor.fetchone()
+                await cursor.close()
+                if row is None or row[0] != block_bytes:
+                    continue
+                await self._replace_uncompact_vdfs(bytes32(bytes.fromhex(header_hash_hex)), rows)
+
+            cursor = await self.db.execute("SELECT MAX(height) from full_blocks")
+            row = await cursor.fetchone()
+            await cursor.close()
+            next_height: Optional[uint32] = uint32(start + count)
+            if row is None or row[0] is None or row[0] < start + count:
+                next_height = None
+                cursor = await self.db.execute("DELETE FROM uncompact_vdfs_backfill")
+            else:
+                cursor = await self.db.execute("UPDATE uncompact_vdfs_backfill SET next_height=?", (next_height,))
+            await cursor.close()
+            await self.db.commit()
+            return next_height
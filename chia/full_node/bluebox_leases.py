@@ -0,0 +1,147 @@
+import random
+import time
+from collections import deque
+from dataclasses import dataclass, field
+from typing import Deque, Dict, List, Optional, Tuple
+
+from chia.protocols.timelord_protocol import RequestCompactProofOfTime
+from chia.types.blockchain_format.sized_bytes import bytes32
+from chia.types.blockchain_format.vdf import VDFInfo
+
+# Throughput of each timelord is measured over the last hour
+THROUGHPUT_WINDOW_SECONDS = 3600
+
+# Header hash, field_vdf and VDF info of an uncompact VDF
+WorkKey = Tuple[bytes32, int, VDFInfo]
+
+
+def work_key(header_hash: bytes32, field_vdf: int, vdf_info: VDFInfo) -> WorkKey:
+    return header_hash, int(field_vdf), vdf_info
+
+
+@dataclass
+class BlueboxLease:
+    node_id: bytes32
+    expires: float
+
+
+@dataclass
+class TimelordCompactionStats:
+    leased: int = 0
+    completed: int = 0
+    expired: int = 0
+    recent_completions: Deque[float] = field(default_factory=deque)
+
+    def throughput(self, now: float) -> float:
+        """
+        Compact proofs per hour over the last THROUGHPUT_WINDOW_SECONDS
+        """
+        while len(self.recent_completions) > 0 and self.recent_completions[0] < now - THROUGHPUT_WINDOW_SECONDS:
+            self.recent_completions.popleft()
+        return len(self.recent_completions) * 3600 / THROUGHPUT_WINDOW_SECONDS
+
+
+class BlueboxLeases:
+    """
+    Hands out disjoint sets of uncompact VDFs to the connected blueboxes, so that two of them do not compact the same
+    VDF. A lease that is not completed within lease_seconds, or whose bluebox disconnects, can be given to another.
+    """
+
+    def __init__(self, lease_seconds: float):
+        self.lease_seconds = lease_seconds
+        self.leases: Dict[WorkKey, BlueboxLease] = {}
+        self.stats: Dict[bytes32, TimelordCompactionStats] = {}
+
+    def _expire(self, now: float) -> None:
+        for key, lease in list(self.leases.items()):
+            if lease.expires <= now:
+                del self.leases[key]
+                self.stats.setdefault(lease.node_id, TimelordCompactionStats()).expired += 1
+
+    def active_leases(self, node_id: bytes32) -> int:
+        return sum(1 for lease in self.leases.values() if lease.node_id == node_id)
+
+    def unleased(self, work: List[RequestCompactProofOfTime]) -> List[RequestCompactProofOfTime]:
+        return [w for w in work if work_key(w.header_hash, w.field_vdf, w.new_proof_of_time) not in self.leases]
+
+    def assign(
+        self,
+        work: List[RequestCompactProofOfTime],
+        node_ids: List[bytes32],
+        max_per_timelord: int,
+        now: Optional[float] = None,
+    ) -> Dict[bytes32, List[RequestCompactProofOfTime]]:
+        """
+        Leases work that is not leased yet to the given timelords, until each holds max_per_timelord leases
+        """
+        if now is None:
+            now = time.time()
+        self._expire(now)
+        assignments: Dict[bytes32, List[RequestCompactProofOfTime]] = {node_id: [] for node_id in node_ids}
+        capacity: Dict[bytes32, int] = {node_id: max_per_timelord - self.active_leases(node_id) for node_id in node_ids}
+        open_node_ids = [node_id for node_id in node_ids if capacity[node_id] > 0]
+        free = self.unleased(work)
+        random.shuffle(free)
+        for w in free:
+            if len(open_node_ids) == 0:
+                break
+            # Round robin over the timelords that can still take work
+            node_id = open_node_ids.pop(0)
+            self.leases[work_key(w.header_hash, w.field_vdf, w.new_proof_of_time)] = BlueboxLease(
+                node_id, now + self.lease_seconds
+            )
+            self.stats.setdefault(node_id, TimelordCompactionStats()).leased += 1
+            assignments[node_id].append(w)
+            capacity[node_id] -= 1
+            if capacity[node_id] > 0:
+                open_node_ids.append(node_id)
+        return assignments
+
+    def complete(
+        self,
+        header_hash: bytes32,
+        field_vdf: int,
+        vdf_info: VDFInfo,
+        node_id: Optional[bytes32],
+        now: Optional[float] = None,
+    ) -> None:
+        """
+        Called for a new compact proof. It is credited to the timelord that sent it, or else to the lease holder.
+        """
+        lease = self.leases.pop(work_key(header_hash, field_vdf, vdf_info), None)
+        if node_id is None and lease is not None:
+            node_id = lease.node_id
+        if node_id is None:
+            return
+        stats = self.stats.setdefault(node_id, TimelordCompactionStats())
+        stats.completed += 1
+        stats.recent_completions.append(time.time() if now is None else now)
+
+    def release(self, header_hash: bytes32, field_vdf: int, vdf_info: VDFInfo) -> None:
+        """
+        Called for a compact proof from another full node, the lease holder does not get credit for it
+        """
+        self.leases.pop(work_key(header_hash, field_vdf, vdf_info), None)
+
+    def remove_timelord(self, node_id: bytes32) -> None:
+        for key, lease in list(self.leases.items()):
+            if lease.node_id == node_id:
+                del self.leases[key]
+
+    def to_json_dict(self, now: Optional[float] = None) -> Dict:
+        if now is None:
+            now = time.time()
+        return {
+            "lease_seconds": self.lease_seconds,
+            "active_leases": len(self.leases),
+            "timelords": {
+                node_id.hex(): {
+                    "active_leases": self.active_leases(node_id),
+                    "leased": stats.leased,
+                    "completed": stats.completed,
+                    "expired": stats.expired,
+                    "proofs_per_hour": stats.throughput(now),
+                }
+                for node_id, stats in self.stats.items()
+            },
+        }
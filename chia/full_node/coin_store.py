@@ -1,4 +1,4 @@
-from typing import List, Optional
+from typing import Dict, List, Optional
 
 import aiosqlite
 
@@ -141,6 +141,36 @@ class CoinStore:
             coins.append(CoinRecord(coin, row[1], row[2], row[3], row[4], row[8]))
         return coins
 
+    async def get_coins_added_in_range(self, start: uint32, stop: uint32) -> Dict[uint32, List[CoinRecord]]:
+        """
+        Returns the coins added at each height from start to stop (inclusive), in one query
+        """
+        cursor = await self.coin_record_db.execute(
+            "SELECT * from coin_record WHERE confirmed_index>=? AND confirmed_index<=?", (start, stop)
+        )
+        rows = await cursor.fetchall()
+        await cursor.close()
+        coins: Dict[uint32, List[CoinRecord]] = {}
+        for row in rows:
+            coin = Coin(bytes32(bytes.fromhex(row[6])), bytes32(bytes.fromhex(row[5])), uint64.from_bytes(row[7]))
+            coins.setdefault(uint32(row[1]), []).append(CoinRecord(coin, row[1], row[2], row[3], row[4], row[8]))
+        return coins
+
+    async def get_coins_removed_in_range(self, start: uint32, stop: uint32) -> Dict[uint32, List[CoinRecord]]:
+        """
+        Returns the coins removed at each height from start to stop (inclusive), in one query
+        """
+        cursor = await self.coin_record_db.execute(
+            "SELECT * from coin_record WHERE spent_index>=? AND spent_index<=? and spent=1", (start, stop)
+        )
+        rows = await cursor.fetchall()
+        await cursor.close()
+        coins: Dict[uint32, List[CoinRecord]] = {}
+        for row in rows:
+            coin = Coin(bytes32(bytes.fromhex(row[6])), bytes32(bytes.fromhex(row[5])), uint64.from_bytes(row[7]))
+            coins.setdefault(uint32(row[2]), []).append(CoinRecord(coin, row[1], row[2], row[3], row[4], row[8]))
+        return coins
+
     # Checks DB and DiffStores for CoinRecords with puzzle_hash and returns them
     async def get_coin_records_by_puzzle_hash(
         self,
@@ -0,0 +1,113 @@
+import dataclasses
+import itertools
+from dataclasses import dataclass
+from typing import Any, Dict, Optional, Tuple
+
+from chia.types.blockchain_format.sized_bytes import bytes32
+from chia.types.blockchain_format.vdf import CompressibleVDFField, VDFInfo, VDFProof
+from chia.types.full_block import FullBlock
+from chia.util.ints import uint32
+
+# Blocks rewritten in one batch, the blockchain lock is held while they are written. Proofs for more blocks are left
+# for the next batch.
+MAX_BLOCKS_PER_BATCH = 100
+
+
+@dataclass(frozen=True)
+class PendingCompactProof:
+    vdf_proof: VDFProof
+    height: uint32
+    # Full node that sent us the proof, None if it came from a timelord
+    peer_node_id: Optional[bytes32]
+
+
+class CompactProofQueue:
+    """
+    Verified compact proofs that are not written to their blocks yet, by header hash. They are taken out in batches,
+    so that each block is rewritten once for all of its new proofs, and each batch is written in one transaction.
+    """
+
+    def __init__(self):
+        self.pending: Dict[bytes32, Dict[Tuple[CompressibleVDFField, VDFInfo], PendingCompactProof]] = {}
+
+    def add(
+        self,
+        header_hash: bytes32,
+        field_vdf: CompressibleVDFField,
+        vdf_info: VDFInfo,
+        proof: PendingCompactProof,
+    ) -> bool:
+        """
+        Returns False if a proof for this VDF is already queued
+        """
+        proofs = self.pending.setdefault(header_hash, {})
+        if (field_vdf, vdf_info) in proofs:
+            return False
+        proofs[(field_vdf, vdf_info)] = proof
+        return True
+
+    def get(self, header_hash: bytes32, field_vdf: CompressibleVDFField, vdf_info: VDFInfo) -> Optional[VDFProof]:
+        proof = self.pending.get(header_hash, {}).get((field_vdf, vdf_info))
+        return None if proof is None else proof.vdf_proof
+
+    def pop_batch(
+        self, max_blocks: int = MAX_BLOCKS_PER_BATCH
+    ) -> Dict[bytes32, Dict[Tuple[CompressibleVDFField, VDFInfo], PendingCompactProof]]:
+        """
+        Takes out the proofs of at most max_blocks blocks, the ones queued first
+        """
+        header_hashes = list(itertools.islice(self.pending.keys(), max_blocks))
+        return {header_hash: self.pending.pop(header_hash) for header_hash in header_hashes}
+
+    def requeue(self, pending: Dict[bytes32, Dict[Tuple[CompressibleVDFField, VDFInfo], PendingCompactProof]]) -> None:
+        """
+        Puts back proofs taken out with pop_batch that could not be written
+        """
+        for header_hash, proofs in pending.items():
+            for (field_vdf, vdf_info), proof in proofs.items():
+                self.add(header_hash, field_vdf, vdf_info, proof)
+
+    def __len__(self) -> int:
+        return sum(len(proofs) for proofs in self.pending.values())
+
+
+def replace_compact_proofs(
+    block: FullBlock, proofs: Dict[Tuple[CompressibleVDFField, VDFInfo], PendingCompactProof]
+) -> Tuple[FullBlock, int]:
+    """
+    Returns the block with the given proofs replaced, and how many of them matched a VDF of the block
+    """
+    replaced = 0
+    finished_sub_slots = list(block.finished_sub_slots)
+    for index, sub_slot in enumerate(finished_sub_slots):
+        new_proofs = sub_slot.proofs
+        cc_proof = proofs.get(
+            (CompressibleVDFField.CC_EOS_VDF, sub_slot.challenge_chain.challenge_chain_end_of_slot_vdf)
+        )
+        if cc_proof is not None:
+            new_proofs = dataclasses.replace(new_proofs, challenge_chain_slot_proof=cc_proof.vdf_proof)
+            replaced += 1
+        if sub_slot.infused_challenge_chain is not None:
+            icc_proof = proofs.get(
+                (
+                    CompressibleVDFField.ICC_EOS_VDF,
+                    sub_slot.infused_challenge_chain.infused_challenge_chain_end_of_slot_vdf,
+                )
+            )
+            if icc_proof is not None:
+                new_proofs = dataclasses.replace(new_proofs, infused_challenge_chain_slot_proof=icc_proof.vdf_proof)
+                replaced += 1
+        if new_proofs is not sub_slot.proofs:
+            finished_sub_slots[index] = dataclasses.replace(sub_slot, proofs=new_proofs)
+
+    changes: Dict[str, Any] = {"finished_sub_slots": finished_sub_slots}
+    if block.reward_chain_block.challenge_chain_sp_vdf is not None:
+        sp_proof = proofs.get((CompressibleVDFField.CC_SP_VDF, block.reward_chain_block.challenge_chain_sp_vdf))
+        if sp_proof is not None and block.challenge_chain_sp_proof is not None:
+            changes["challenge_chain_sp_proof"] = sp_proof.vdf_proof
+            replaced += 1
+    ip_proof = proofs.get((CompressibleVDFField.CC_IP_VDF, block.reward_chain_block.challenge_chain_ip_vdf))
+    if ip_proof is not None:
+        changes["challenge_chain_ip_proof"] = ip_proof.vdf_proof
+        replaced += 1
+    return dataclasses.replace(block, **changes), replaced
@@ -20,9 +20,12 @@ from chia.consensus.make_sub_epoch_summary import next_sub_epoch_summary
 from chia.consensus.multiprocess_validation import PreValidationResult
 from chia.consensus.pot_iterations import calculate_sp_iters
 from chia.full_node.block_store import BlockStore
+from chia.full_node.bluebox_leases import BlueboxLeases
 from chia.full_node.bundle_tools import detect_potential_template_generator
 from chia.full_node.coin_store import CoinStore
+from chia.full_node.compact_proof_queue import CompactProofQueue, PendingCompactProof, replace_compact_proofs
 from chia.full_node.full_node_store import FullNodeStore
+from chia.full_node.header_block_store import HeaderBlockStore
 from chia.full_node.mempool_manager import MempoolManager
 from chia.full_node.signage_point import SignagePoint
 from chia.full_node.sync_store import SyncStore
@@ -38,6 +41,7 @@ from chia.protocols.full_node_protocol import (
 from chia.protocols.protocol_message_types import ProtocolMessageTypes
 from chia.server.node_discovery import FullNodePeers
 from chia.server.outbound_message import Message, NodeType, make_msg
+from chia.protocols.shared_protocol import Capability
 from chia.server.server import ChiaServer
 from chia.types.blockchain_format.classgroup import ClassgroupElement
 from chia.types.blockchain_format.pool_target import PoolTarget
@@ -98,6 +102,7 @@ class FullNode:
         self.sync_store = None
         self.signage_point_times = [time.time() for _ in range(self.constants.NUM_SPS_SUB_SLOT)]
         self.full_node_store = FullNodeStore(self.constants)
+        self.bluebox_leases = BlueboxLeases(config.get("bluebox_lease_seconds", 1800))
 
         if name:
             self.log = logging.getLogger(name)
@@ -121,6 +126,7 @@ class FullNode:
         self.block_store = await BlockStore.create(self.db_wrapper)
         self.sync_store = await SyncStore.create()
         self.coin_store = await CoinStore.create(self.db_wrapper)
+        self.header_block_store = await HeaderBlockStore.create(self.db_wrapper)
         self.log.info("Initializing blockchain from disk")
         start_time = time.time()
         self.blockchain = await Blockchain.create(self.coin_store, self.block_store, self.constants)
@@ -129,6 +135,7 @@ class FullNode:
         asyncio.create_task(self.initialize_weight_proof())
         self._sync_task = None
         self._segment_task = None
+        self._weight_proof_task: Optional[asyncio.Task] = None
         time_taken = time.time() - start_time
         if self.blockchain.get_peak() is None:
             self.log.info(f"Initialized with empty blockchain time taken: {int(time_taken)}s")
@@ -143,6 +150,14 @@ class FullNode:
 
         peak: Optional[BlockRecord] = self.blockchain.get_peak()
         self.uncompact_task = None
+        self.uncompact_backfill_task = None
+        self.compact_proof_queue = CompactProofQueue()
+        # Incremented before and after compact proofs are written to blocks, so it is odd while they are written.
+        # Header blocks built from blocks that might have changed meanwhile are not stored.
+        self.compact_proof_writes = 0
+        self.compact_proof_task = asyncio.create_task(
+            self._apply_compact_proofs_periodically(self.config.get("compact_proof_apply_interval", 10))
+        )
         if peak is not None:
             full_peak = await self.blockchain.get_full_peak()
             await self.peak_post_processing(full_peak, peak, max(peak.height - 1, 0), None)
@@ -151,6 +166,7 @@ class FullNode:
             if "sanitize_weight_proof_only" in self.config:
                 sanitize_weight_proof_only = self.config["sanitize_weight_proof_only"]
             assert self.config["target_uncompact_proofs"] != 0
+            self.uncompact_backfill_task = asyncio.create_task(self._backfill_uncompact_vdfs())
             self.uncompact_task = asyncio.create_task(
                 self.broadcast_uncompact_blocks(
                     self.config["send_uncompact_interval"],
@@ -163,10 +179,46 @@ class FullNode:
             asyncio.create_task(self.full_node_peers.start())
 
     async def initialize_weight_proof(self):
-        self.weight_proof_handler = WeightProofHandler(self.constants, self.blockchain)
+        self.weight_proof_handler = WeightProofHandler(self.constants, self.blockchain, self.blockchain.pool)
         peak = self.blockchain.get_peak()
         if peak is not None:
             await self.weight_proof_handler.create_sub_epoch_segments()
+        self._schedule_weight_proof_precompute()
+
+    def _schedule_weight_proof_precompute(self):
+        if self.weight_proof_handler is None or not self.config.get("precompute_weight_proof", True):
+            return
+        if self._weight_proof_task is None or self._weight_proof_task.done():
+            self._weight_proof_task = asyncio.create_task(self._precompute_weight_proof())
+
+    async def _precompute_weight_proof(self):
+        """
+        Keeps a serialized weight proof for the current peak ready, so that syncing peers are answered without
+        building one on request. Peaks that arrive while a proof is being built are picked up on the next iteration.
+        """
+        while not self._shut_down:
+            peak: Optional[BlockRecord] = self.blockchain.get_peak()
+            if peak is None or self.sync_store.get_sync_mode():
+                return
+            if self.full_node_store.serialized_wp_message_tip == peak.header_hash:
+                return
+            try:
+                wp = await self.weight_proof_handler.get_proof_of_weight(peak.header_hash)
+            except Exception as e:
+                self.log.warning(f"failed precomputing weight proof for peak {peak.header_hash}: {e}")
+                return
+            if wp is None:
+                return
+            # Serialization of wp is slow, let the event loop keep running in between
+            message = await asyncio.get_running_loop().run_in_executor(
+                None,
+                make_msg,
+                ProtocolMessageTypes.respond_proof_of_weight,
+                full_node_protocol.RespondProofOfWeight(wp, peak.header_hash),
+            )
+            self.full_node_store.serialized_wp_message_tip = peak.header_hash
+            self.full_node_store.serialized_wp_message = message
+            self.log.debug(f"weight proof ready for peak {peak.height} {peak.header_hash}")
 
     def set_server(self, server: ChiaServer):
         self.server = server
@@ -510,6 +562,8 @@ class FullNode:
         self._state_changed("sync_mode")
         if self.sync_store is not None:
             self.sync_store.peer_disconnected(connection.peer_node_id)
+        if connection.connection_type == NodeType.TIMELORD:
+            self.bluebox_leases.remove_timelord(connection.peer_node_id)
 
     def _num_needed_peers(self) -> int:
         assert self.server is not None
@@ -527,9 +581,16 @@ class FullNode:
             asyncio.create_task(self.full_node_peers.close())
         if self.uncompact_task is not None:
             self.uncompact_task.cancel()
+        if self.uncompact_backfill_task is not None:
+            self.uncompact_backfill_task.cancel()
+        if self.compact_proof_task is not None:
+            self.compact_proof_task.cancel()
+        if self.weight_proof_handler is not None:
+            self.weight_proof_handler.shut_down()
 
     async def _await_closed(self):
         cancel_task_safe(self._sync_task, self.log)
+        cancel_task_safe(self._weight_proof_task, self.log)
         for task_id, task in list(self.full_node_store.tx_fetch_tasks.items()):
             cancel_task_safe(task, self.log)
         await self.connection.close()
@@ -914,6 +975,37 @@ class FullNode:
         msg = make_msg(ProtocolMessageTypes.new_signage_point, broadcast_farmer)
         await self.server.send_to_all([msg], NodeType.FARMER)
 
+    async def get_header_blocks_bytes(self, start: uint32, end: uint32) -> Optional[List[bytes]]:
+        """
+        Returns the serialized header blocks of the main chain from start to end (inclusive), or None if some height
+        is not in the chain. Header blocks that are not in the header block store yet are built and stored.
+        """
+        header_hashes: List[bytes32] = []
+        for height in range(start, end + 1):
+            if not self.blockchain.contains_height(uint32(height)):
+                return None
+            header_hashes.append(self.blockchain.height_to_hash(uint32(height)))
+
+        stored: Dict[bytes32, bytes] = await self.header_block_store.get_header_blocks_bytes(header_hashes)
+        missing: List[int] = [i for i, header_hash in enumerate(header_hashes) if header_hash not in stored]
+        if len(missing) > 0:
+            compact_proof_writes = self.compact_proof_writes
+            try:
+                built = await self.blockchain.get_header_blocks_in_range(start + missing[0], start + missing[-1])
+            except ValueError:
+                # Reorg while building them
+                return None
+            new_header_blocks: List[Tuple[bytes32, uint32, bytes]] = []
+            for i in missing:
+                header_block = built.get(header_hashes[i])
+                if header_block is None:
+                    return None
+                stored[header_hashes[i]] = bytes(header_block)
+                new_header_blocks.append((header_hashes[i], uint32(start + i), stored[header_hashes[i]]))
+            if compact_proof_writes % 2 == 0 and compact_proof_writes == self.compact_proof_writes:
+                await self.header_block_store.add_header_blocks(new_header_blocks)
+        return [stored[header_hash] for header_hash in header_hashes]
+
     async def peak_post_processing(
         self, block: FullBlock, record: BlockRecord, fork_height: uint32, peer: Optional[ws.WSChiaConnection]
     ):
@@ -1018,6 +1110,7 @@ class FullNode:
 
         if self.sync_store.get_sync_mode() is False:
             await self.send_peak_to_timelords(block)
+            self._schedule_weight_proof_precompute()
 
             # Tell full nodes about the new peak
             msg = make_msg(
@@ -1035,6 +1128,15 @@ class FullNode:
             else:
                 await self.server.send_to_all([msg], NodeType.FULL_NODE)
 
+        # Store the header block of the new peak before telling wallets about it, since they will ask for it
+        if fork_height < block.height - 1:
+            await self.header_block_store.rollback_to_height(fork_height)
+        if self.sync_store.get_sync_mode() is False:
+            header_blocks = await self.blockchain.get_header_blocks_in_range(block.height, block.height)
+            await self.header_block_store.add_header_blocks(
+                [(record.header_hash, record.height, bytes(header_blocks[record.header_hash]))]
+            )
+
         # Tell wallets about the new peak
         msg = make_msg(
             ProtocolMessageTypes.new_peak_wallet,
@@ -1654,6 +1756,9 @@ class FullNode:
         if is_fully_compactified is None or is_fully_compactified:
             self.log.info(f"Already compactified block: {header_hash}. Ignoring.")
             return False
+        if self.compact_proof_queue.get(header_hash, field_vdf, vdf_info) is not None:
+            self.log.info(f"Duplicate compact proof, waiting to be written. Height: {height}.")
+            return False
         if vdf_proof.witness_type > 0 or not vdf_proof.normalized_to_identity:
             self.log.error(f"Received vdf proof is not compact: {vdf_proof}.")
             return False
@@ -1669,65 +1774,95 @@ class FullNode:
             self.log.info(f"Duplicate compact proof. Height: {height}. Header hash: {header_hash}.")
         return is_new_proof
 
-    async def _replace_proof(
-        self,
-        vdf_info: VDFInfo,
-        vdf_proof: VDFProof,
-        height: uint32,
-        field_vdf: CompressibleVDFField,
+    async def _apply_compact_proofs_periodically(self, interval: float):
+        while not self._shut_down:
+            await asyncio.sleep(interval)
+            try:
+                await self._apply_compact_proofs()
+            except Exception as e:
+                error_stack = traceback.format_exc()
+                self.log.error(f"Exception applying compact proofs: {e}")
+                self.log.error(f"Exception Stack: {error_stack}")
+
+    async def _apply_compact_proofs(self):
+        """
+        Writes a batch of the queued compact proofs to their blocks, each block once, in a single transaction, and then
+        tells the other full nodes about them.
+        """
+        pending = self.compact_proof_queue.pop_batch()
+        if len(pending) == 0:
+            return
+        start = time.time()
+        committed = False
+        self.compact_proof_writes += 1
+        try:
+            async with self.blockchain.lock:
+                blocks: List[FullBlock] = await self.block_store.get_blocks_by_hash(list(pending.keys()))
+                new_blocks: List[Tuple[FullBlock, BlockRecord]] = []
+                for block in blocks:
+                    new_block, replaced = replace_compact_proofs(block, pending[block.header_hash])
+                    if replaced != len(pending[block.header_hash]):
+                        self.log.warning(f"Only {replaced} of the compact proofs match block {block.header_hash}")
+                    block_record = await self.blockchain.get_block_record_from_db(block.header_hash)
+                    assert block_record is not None
+                    new_blocks.append((new_block, block_record))
+                async with self.db_wrapper.lock:
+                    try:
+                        await self.block_store.db_wrapper.begin_transaction()
+                        for new_block, block_record in new_blocks:
+                            await self.block_store.add_full_block(new_block, block_record)
+                        await self.block_store.db_wrapper.commit_transaction()
+                        committed = True
+                    except BaseException:
+                        await self.block_store.db_wrapper.rollback_transaction()
+                        raise
+            await self.header_block_store.remove_header_blocks(list(pending.keys()))
+        except BaseException:
+            # The proofs are verified already, they are tried again with the next batch
+            if not committed:
+                self.compact_proof_queue.requeue(pending)
+            raise
+        finally:
+            self.compact_proof_writes += 1
+        # Also covers VDFs that were leased again while their proof was queued
+        for header_hash, proofs in pending.items():
+            for field_vdf, vdf_info in proofs.keys():
+                self.bluebox_leases.release(header_hash, field_vdf, vdf_info)
+        self.log.info(
+            f"Applied {sum(len(proofs) for proofs in pending.values())} compact proofs to {len(new_blocks)} blocks "
+            f"in {time.time() - start:.2f}s"
+        )
+
+        if self.server is None:
+            return
+        for header_hash, proofs in pending.items():
+            for (field_vdf, vdf_info), proof in proofs.items():
+                msg = make_msg(
+                    ProtocolMessageTypes.new_compact_vdf,
+                    full_node_protocol.NewCompactVDF(proof.height, header_hash, uint8(field_vdf), vdf_info),
+                )
+                if proof.peer_node_id is None:
+                    await self.server.send_to_all([msg], NodeType.FULL_NODE)
+                else:
+                    await self.server.send_to_all_except([msg], NodeType.FULL_NODE, proof.peer_node_id)
+
+    async def respond_compact_proof_of_time(
+        self, request: timelord_protocol.RespondCompactProofOfTime, peer: Optional[ws.WSChiaConnection] = None
     ):
-        full_blocks = await self.block_store.get_full_blocks_at([height])
-        assert len(full_blocks) > 0
-        for block in full_blocks:
-            new_block = None
-            block_record = await self.blockchain.get_block_record_from_db(self.blockchain.height_to_hash(height))
-            assert block_record is not None
-
-            if field_vdf == CompressibleVDFField.CC_EOS_VDF:
-                for index, sub_slot in enumerate(block.finished_sub_slots):
-                    if sub_slot.challenge_chain.challenge_chain_end_of_slot_vdf == vdf_info:
-                        new_proofs = dataclasses.replace(sub_slot.proofs, challenge_chain_slot_proof=vdf_proof)
-                        new_subslot = dataclasses.replace(sub_slot, proofs=new_proofs)
-                        new_finished_subslots = block.finished_sub_slots
-                        new_finished_subslots[index] = new_subslot
-                        new_block = dataclasses.replace(block, finished_sub_slots=new_finished_subslots)
-                        break
-            if field_vdf == CompressibleVDFField.ICC_EOS_VDF:
-                for index, sub_slot in enumerate(block.finished_sub_slots):
-                    if (
-                        sub_slot.infused_challenge_chain is not None
-                        and sub_slot.infused_challenge_chain.infused_challenge_chain_end_of_slot_vdf == vdf_info
-                    ):
-                        new_proofs = dataclasses.replace(sub_slot.proofs, infused_challenge_chain_slot_proof=vdf_proof)
-                        new_subslot = dataclasses.replace(sub_slot, proofs=new_proofs)
-                        new_finished_subslots = block.finished_sub_slots
-                        new_finished_subslots[index] = new_subslot
-                        new_block = dataclasses.replace(block, finished_sub_slots=new_finished_subslots)
-                        break
-            if field_vdf == CompressibleVDFField.CC_SP_VDF:
-                assert block.challenge_chain_sp_proof is not None
-                new_block = dataclasses.replace(block, challenge_chain_sp_proof=vdf_proof)
-            if field_vdf == CompressibleVDFField.CC_IP_VDF:
-                new_block = dataclasses.replace(block, challenge_chain_ip_proof=vdf_proof)
-            assert new_block is not None
-            async with self.db_wrapper.lock:
-                await self.block_store.add_full_block(new_block, block_record)
-                await self.block_store.db_wrapper.commit_transaction()
-
-    async def respond_compact_proof_of_time(self, request: timelord_protocol.RespondCompactProofOfTime):
         field_vdf = CompressibleVDFField(int(request.field_vdf))
         if not await self._can_accept_compact_proof(
             request.vdf_info, request.vdf_proof, request.height, request.header_hash, field_vdf
         ):
             return
-        async with self.blockchain.lock:
-            await self._replace_proof(request.vdf_info, request.vdf_proof, request.height, field_vdf)
-        msg = make_msg(
-            ProtocolMessageTypes.new_compact_vdf,
-            full_node_protocol.NewCompactVDF(request.height, request.header_hash, request.field_vdf, request.vdf_info),
+        self.bluebox_leases.complete(
+            request.header_hash, field_vdf, request.vdf_info, None if peer is None else peer.peer_node_id
+        )
+        self.compact_proof_queue.add(
+            request.header_hash,
+            field_vdf,
+            request.vdf_info,
+            PendingCompactProof(request.vdf_proof, request.height, None),
         )
-        if self.server is not None:
-            await self.server.send_to_all([msg], NodeType.FULL_NODE)
 
     async def new_compact_vdf(self, request: full_node_protocol.NewCompactVDF, peer: ws.WSChiaConnection):
         is_fully_compactified = await self.block_store.is_fully_compactified(request.header_hash)
@@ -1793,21 +1928,72 @@ class FullNode:
             request.vdf_info, request.vdf_proof, request.height, request.header_hash, field_vdf
         ):
             return
-        async with self.blockchain.lock:
-            if self.blockchain.seen_compact_proofs(request.vdf_info, request.height):
-                return
-            await self._replace_proof(request.vdf_info, request.vdf_proof, request.height, field_vdf)
-        msg = make_msg(
-            ProtocolMessageTypes.new_compact_vdf,
-            full_node_protocol.NewCompactVDF(request.height, request.header_hash, request.field_vdf, request.vdf_info),
+        if self.blockchain.seen_compact_proofs(request.vdf_info, request.height):
+            return
+        # The bluebox that leased this VDF does not need to finish it
+        self.bluebox_leases.release(request.header_hash, field_vdf, request.vdf_info)
+        self.compact_proof_queue.add(
+            request.header_hash,
+            field_vdf,
+            request.vdf_info,
+            PendingCompactProof(request.vdf_proof, request.height, peer.peer_node_id),
         )
-        if self.server is not None:
-            await self.server.send_to_all_except([msg], NodeType.FULL_NODE, peer.peer_node_id)
+
+    async def _backfill_uncompact_vdfs(self):
+        """
+        Indexes the uncompact VDFs of blocks that were stored before the index existed. This runs next to
+        broadcast_uncompact_blocks, which sends work from the part that is indexed already, and waits while syncing.
+        """
+        try:
+            next_height = await self.block_store.get_uncompact_vdfs_backfill_height()
+            if next_height is not None:
+                self.log.info(f"Indexing uncompact VDFs of stored blocks, starting at height {next_height}")
+            while next_height is not None and not self._shut_down:
+                if self.sync_store.get_sync_mode():
+                    await asyncio.sleep(30)
+                    continue
+                next_height = await self.block_store.backfill_uncompact_vdfs(next_height, 100)
+                await asyncio.sleep(0.1)
+        except Exception as e:
+            error_stack = traceback.format_exc()
+            self.log.error(f"Exception in _backfill_uncompact_vdfs: {e}")
+            self.log.error(f"Exception Stack: {error_stack}")
+
+    async def _send_uncompact_vdfs(
+        self, broadcast_list: List[timelord_protocol.RequestCompactProofOfTime], target_uncompact_proofs: int
+    ):
+        """
+        Blueboxes with leases get their own share of the work, the others get the same sample of unleased work
+        """
+        assert self.server is not None
+        leased_node_ids: List[bytes32] = []
+        other_node_ids: List[bytes32] = []
+        for connection in self.server.get_connections():
+            if connection.connection_type != NodeType.TIMELORD:
+                continue
+            if connection.has_capability(Capability.BLUEBOX_LEASES):
+                leased_node_ids.append(connection.peer_node_id)
+            else:
+                other_node_ids.append(connection.peer_node_id)
+
+        assignments = self.bluebox_leases.assign(broadcast_list, leased_node_ids, target_uncompact_proofs)
+        for node_id, work in assignments.items():
+            if len(work) > 0:
+                msgs = [make_msg(ProtocolMessageTypes.request_compact_proof_of_time, new_pot) for new_pot in work]
+                await self.server.send_to_specific(msgs, node_id)
+
+        if len(other_node_ids) > 0:
+            unleased = self.bluebox_leases.unleased(broadcast_list)
+            if len(unleased) > target_uncompact_proofs:
+                random.shuffle(unleased)
+                unleased = unleased[:target_uncompact_proofs]
+            msgs = [make_msg(ProtocolMessageTypes.request_compact_proof_of_time, new_pot) for new_pot in unleased]
+            for node_id in other_node_ids:
+                await self.server.send_to_specific(msgs, node_id)
 
     async def broadcast_uncompact_blocks(
         self, uncompact_interval_scan: int, target_uncompact_proofs: int, sanitize_weight_proof_only: bool
     ):
-        min_height: Optional[int] = 0
         try:
             while not self._shut_down:
                 while self.sync_store.get_sync_mode():
@@ -1815,129 +2001,37 @@ class FullNode:
                         return
                     await asyncio.sleep(30)
 
-                broadcast_list: List[timelord_protocol.RequestCompactProofOfTime] = []
-                new_min_height = None
                 max_height = self.blockchain.get_peak_height()
                 if max_height is None:
                     await asyncio.sleep(30)
                     continue
-                # Calculate 'min_height' correctly the first time this task is launched, using the db.
-                assert min_height is not None
-                min_height = await self.block_store.get_first_not_compactified(min_height)
-                if min_height is None or min_height > max(0, max_height - 1000):
-                    min_height = max(0, max_height - 1000)
-                batches_finished = 0
-                self.log.info("Scanning the blockchain for uncompact blocks.")
-                assert max_height is not None
-                assert min_height is not None
-                for h in range(min_height, max_height, 100):
-                    # Got 10 times the target header count, sampling the target headers should contain
-                    # enough randomness to split the work between blueboxes.
-                    if len(broadcast_list) > target_uncompact_proofs * 10:
-                        break
-                    stop_height = min(h + 99, max_height)
-                    assert min_height is not None
-                    headers = await self.blockchain.get_header_blocks_in_range(min_height, stop_height)
-                    records: Dict[bytes32, BlockRecord] = {}
-                    if sanitize_weight_proof_only:
-                        records = await self.blockchain.get_block_records_in_range(min_height, stop_height)
-                    for header in headers.values():
-                        prev_broadcast_list_len = len(broadcast_list)
-                        expected_header_hash = self.blockchain.height_to_hash(header.height)
-                        if header.header_hash != expected_header_hash:
-                            continue
-                        if sanitize_weight_proof_only:
-                            assert header.header_hash in records
-                            record = records[header.header_hash]
-                        for sub_slot in header.finished_sub_slots:
-                            if (
-                                sub_slot.proofs.challenge_chain_slot_proof.witness_type > 0
-                                or not sub_slot.proofs.challenge_chain_slot_proof.normalized_to_identity
-                            ):
-                                broadcast_list.append(
-                                    timelord_protocol.RequestCompactProofOfTime(
-                                        sub_slot.challenge_chain.challenge_chain_end_of_slot_vdf,
-                                        header.header_hash,
-                                        header.height,
-                                        uint8(CompressibleVDFField.CC_EOS_VDF),
-                                    )
-                                )
-                            if sub_slot.proofs.infused_challenge_chain_slot_proof is not None and (
-                                sub_slot.proofs.infused_challenge_chain_slot_proof.witness_type > 0
-                                or not sub_slot.proofs.infused_challenge_chain_slot_proof.normalized_to_identity
-                            ):
-                                assert sub_slot.infused_challenge_chain is not None
-                                broadcast_list.append(
-                                    timelord_protocol.RequestCompactProofOfTime(
-                                        sub_slot.infused_challenge_chain.infused_challenge_chain_end_of_slot_vdf,
-                                        header.header_hash,
-                                        header.height,
-                                        uint8(CompressibleVDFField.ICC_EOS_VDF),
-                                    )
-                                )
-                        # Running in 'sanitize_weight_proof_only' ignores CC_SP_VDF and CC_IP_VDF
-                        # unless this is a challenge block.
-                        if sanitize_weight_proof_only:
-                            if not record.is_challenge_block(self.constants):
-                                # Calculates 'new_min_height' as described below.
-                                if (
-                                    prev_broadcast_list_len == 0
-                                    and len(broadcast_list) > 0
-                                    and h <= max(0, max_height - 1000)
-                                ):
-                                    new_min_height = header.height
-                                # Skip calculations for CC_SP_VDF and CC_IP_VDF.
-                                continue
-                        if header.challenge_chain_sp_proof is not None and (
-                            header.challenge_chain_sp_proof.witness_type > 0
-                            or not header.challenge_chain_sp_proof.normalized_to_identity
-                        ):
-                            assert header.reward_chain_block.challenge_chain_sp_vdf is not None
-                            broadcast_list.append(
-                                timelord_protocol.RequestCompactProofOfTime(
-                                    header.reward_chain_block.challenge_chain_sp_vdf,
-                                    header.header_hash,
-                                    header.height,
-                                    uint8(CompressibleVDFField.CC_SP_VDF),
-                                )
-                            )
-
-                        if (
-                            header.challenge_chain_ip_proof.witness_type > 0
-                            or not header.challenge_chain_ip_proof.normalized_to_identity
-                        ):
-                            broadcast_list.append(
-                                timelord_protocol.RequestCompactProofOfTime(
-                                    header.reward_chain_block.challenge_chain_ip_vdf,
-                                    header.header_hash,
-                                    header.height,
-                                    uint8(CompressibleVDFField.CC_IP_VDF),
-                                )
-                            )
-                        # This is the first header with uncompact proofs. Store its height so next time we iterate
-                        # only from here. Fix header block iteration window to at least 1000, so reorgs will be
-                        # handled correctly.
-                        if prev_broadcast_list_len == 0 and len(broadcast_list) > 0 and h <= max(0, max_height - 1000):
-                            new_min_height = header.height
-
-                    # Small sleep between batches.
-                    batches_finished += 1
-                    if batches_finished % 10 == 0:
-                        await asyncio.sleep(1)
-
-                # We have no uncompact blocks, but mentain the block iteration window to at least 1000 blocks.
-                if new_min_height is None:
-                    new_min_height = max(0, max_height - 1000)
-                min_height = new_min_height
-                if len(broadcast_list) > target_uncompact_proofs:
-                    random.shuffle(broadcast_list)
-                    broadcast_list = broadcast_list[:target_uncompact_proofs]
+                self.log.info("Looking up uncompact VDFs.")
+                # Running in 'sanitize_weight_proof_only' ignores CC_SP_VDF and CC_IP_VDF unless this is a challenge
+                # block. Get 10 times the target count, sampling them should contain enough randomness to split the
+                # work between blueboxes.
+                uncompact_vdfs = await self.block_store.get_uncompact_vdfs(
+                    max_height,
+                    target_uncompact_proofs * 10,
+                    self.constants.MIN_BLOCKS_PER_CHALLENGE_BLOCK - 1 if sanitize_weight_proof_only else None,
+                )
+                broadcast_list: List[timelord_protocol.RequestCompactProofOfTime] = []
+                orphaned: Set[bytes32] = set()
+                for header_hash, height, field_vdf, vdf_info in uncompact_vdfs:
+                    if self.blockchain.height_to_hash(height) != header_hash:
+                        # Deep enough that it will not be part of the chain again
+                        if height < max(0, max_height - 1000):
+                            orphaned.add(header_hash)
+                        continue
+                    broadcast_list.append(
+                        timelord_protocol.RequestCompactProofOfTime(vdf_info, header_hash, height, uint8(field_vdf))
+                    )
+                if len(orphaned) > 0:
+                    await self.block_store.remove_uncompact_vdfs(list(orphaned))
+
                 if self.sync_store.get_sync_mode():
                     continue
                 if self.server is not None:
-                    for new_pot in broadcast_list:
-                        msg = make_msg(ProtocolMessageTypes.request_compact_proof_of_time, new_pot)
-                        await self.server.send_to_all([msg], NodeType.TIMELORD)
+                    await self._send_uncompact_vdfs(broadcast_list, target_uncompact_proofs)
                 await asyncio.sleep(uncompact_interval_scan)
         except Exception as e:
             error_stack = traceback.format_exc()
@@ -33,7 +33,6 @@ from chia.types.mempool_item import MempoolItem
 from chia.types.peer_info import PeerInfo
 from chia.types.unfinished_block import UnfinishedBlock
 from chia.util.api_decorators import api_request, peer_required, bytes_required, execute_task
-from chia.util.generator_tools import get_block_header
 from chia.util.hash import std_hash
 from chia.util.ints import uint8, uint32, uint64, uint128
 from chia.util.merkle_set import MerkleSet
@@ -234,6 +233,9 @@ class FullNodeAPI:
         if not self.full_node.blockchain.contains_block(request.tip):
             self.log.error(f"got weight proof request for unknown peak {request.tip}")
             return None
+        # Usually the proof for our peak has already been built and serialized in the background
+        if self.full_node.full_node_store.serialized_wp_message_tip == request.tip:
+            return self.full_node.full_node_store.serialized_wp_message
         if request.tip in self.full_node.pow_creation:
             event = self.full_node.pow_creation[request.tip]
             await event.wait()
@@ -1027,20 +1029,12 @@ class FullNodeAPI:
 
     @api_request
     async def request_block_header(self, request: wallet_protocol.RequestBlockHeader) -> Optional[Message]:
-        header_hash = self.full_node.blockchain.height_to_hash(request.height)
-        if header_hash is None:
+        header_blocks = await self.full_node.get_header_blocks_bytes(request.height, request.height)
+        if header_blocks is None:
             msg = make_msg(ProtocolMessageTypes.reject_header_request, RejectHeaderRequest(request.height))
             return msg
-        block: Optional[FullBlock] = await self.full_node.block_store.get_full_block(header_hash)
-        if block is not None:
-            tx_removals, tx_additions = await self.full_node.blockchain.get_tx_removals_and_additions(block)
-            header_block = get_block_header(block, tx_additions, tx_removals)
-            msg = make_msg(
-                ProtocolMessageTypes.respond_block_header,
-                wallet_protocol.RespondBlockHeader(header_block),
-            )
-            return msg
-        return None
+        # RespondBlockHeader only holds the header block, so its serialization is the stored bytes
+        return Message(uint8(ProtocolMessageTypes.respond_block_header.value), None, header_blocks[0])
 
     @api_request
     async def request_additions(self, request: wallet_protocol.RequestAdditions) -> Optional[Message]:
@@ -1223,35 +1217,31 @@ class FullNodeAPI:
         if request.end_height < request.start_height or request.end_height - request.start_height > 32:
             return None
 
-        header_hashes = []
-        for i in range(request.start_height, request.end_height + 1):
-            if not self.full_node.blockchain.contains_height(uint32(i)):
-                reject = RejectHeaderBlocks(request.start_height, request.end_height)
-                msg = make_msg(ProtocolMessageTypes.reject_header_blocks, reject)
-                return msg
-            header_hashes.append(self.full_node.blockchain.height_to_hash(uint32(i)))
-
-        blocks: List[FullBlock] = await self.full_node.block_store.get_blocks_by_hash(header_hashes)
-        header_blocks = []
-        for block in blocks:
-            added_coins_records = await self.full_node.coin_store.get_coins_added_at_height(block.height)
-            removed_coins_records = await self.full_node.coin_store.get_coins_removed_at_height(block.height)
-            added_coins = [record.coin for record in added_coins_records if not record.coinbase]
-            removal_names = [record.coin.name() for record in removed_coins_records]
-            header_block = get_block_header(block, added_coins, removal_names)
-            header_blocks.append(header_block)
+        header_blocks = await self.full_node.get_header_blocks_bytes(request.start_height, request.end_height)
+        if header_blocks is None:
+            reject = RejectHeaderBlocks(request.start_height, request.end_height)
+            msg = make_msg(ProtocolMessageTypes.reject_header_blocks, reject)
+            return msg
 
-        msg = make_msg(
-            ProtocolMessageTypes.respond_header_blocks,
-            wallet_protocol.RespondHeaderBlocks(request.start_height, request.end_height, header_blocks),
+        # Same serialization as RespondHeaderBlocks, without parsing the stored header blocks
+        data = b"".join(
+            [
+                bytes(request.start_height),
+                bytes(request.end_height),
+                bytes(uint32(len(header_blocks))),
+                *header_blocks,
+            ]
         )
-        return msg
+        return Message(uint8(ProtocolMessageTypes.respond_header_blocks.value), None, data)
 
+    @peer_required
     @api_request
-    async def respond_compact_proof_of_time(self, request: timelord_protocol.RespondCompactProofOfTime):
+    async def respond_compact_proof_of_time(
+        self, request: timelord_protocol.RespondCompactProofOfTime, peer: ws.WSChiaConnection
+    ):
         if self.full_node.sync_store.get_sync_mode():
             return None
-        await self.full_node.respond_compact_proof_of_time(request)
+        await self.full_node.respond_compact_proof_of_time(request, peer)
 
     @execute_task
     @peer_required
@@ -0,0 +1,76 @@
+from typing import Dict, List, Tuple
+
+from chia.types.blockchain_format.sized_bytes import bytes32
+from chia.util.db_wrapper import DBWrapper
+from chia.util.ints import uint32
+
+
+class HeaderBlockStore:
+    """
+    Serialized header blocks (including the transactions filter) of the main chain, so that requests from light
+    wallets are answered without rebuilding them from the full blocks and the coin store. Entries above the fork
+    point are removed on a reorg, and an entry is removed when a compact proof replaces a proof in its block.
+    """
+
+    db_wrapper: DBWrapper
+
+    @classmethod
+    async def create(cls, db_wrapper: DBWrapper):
+        self = cls()
+
+        self.db_wrapper = db_wrapper
+        self.db = db_wrapper.db
+        await self.db.execute(
+            "CREATE TABLE IF NOT EXISTS header_blocks(header_hash text PRIMARY KEY, height bigint, block blob)"
+        )
+        await self.db.execute("CREATE INDEX IF NOT EXISTS header_block_height on header_blocks(height)")
+        await self.db.commit()
+        return self
+
+    async def add_header_blocks(self, header_blocks: List[Tuple[bytes32, uint32, bytes]]) -> None:
+        """
+        Stores header blocks, given as header hash, height and serialized header block
+        """
+        if len(header_blocks) == 0:
+            return
+        async with self.db_wrapper.lock:
+            cursor = await self.db.executemany(
+                "INSERT OR REPLACE INTO header_blocks VALUES(?, ?, ?)",
+                [(header_hash.hex(), height, block) for header_hash, height, block in header_blocks],
+            )
+            await cursor.close()
+            await self.db.commit()
+
+    async def get_header_blocks_bytes(self, header_hashes: List[bytes32]) -> Dict[bytes32, bytes]:
+        """
+        Returns the serialized header blocks that are stored, by header hash
+        """
+        if len(header_hashes) == 0:
+            return {}
+        header_hashes_db = tuple([hh.hex() for hh in header_hashes])
+        formatted_str = (
+            f'SELECT header_hash, block from header_blocks WHERE header_hash in ({"?," * (len(header_hashes_db) - 1)}?)'
+        )
+        cursor = await self.db.execute(formatted_str, header_hashes_db)
+        rows = await cursor.fetchall()
+        await cursor.close()
+        return {bytes32(bytes.fromhex(row[0])): row[1] for row in rows}
+
+    async def remove_header_blocks(self, header_hashes: List[bytes32]) -> None:
+        if len(header_hashes) == 0:
+            return
+        async with self.db_wrapper.lock:
+            cursor = await self.db.executemany(
+                "DELETE FROM header_blocks WHERE header_hash=?", [(header_hash.hex(),) for header_hash in header_hashes]
+            )
+            await cursor.close()
+            await self.db.commit()
+
+    async def rollback_to_height(self, fork_height: uint32) -> None:
+        """
+        Removes the header blocks above fork_height, which might no longer be in the main chain
+        """
+        async with self.db_wrapper.lock:
+            cursor = await self.db.execute("DELETE FROM header_blocks WHERE height>?", (fork_height,))
+            await cursor.close()
+            await self.db.commit()
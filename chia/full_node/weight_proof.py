@@ -2,9 +2,12 @@ import asyncio
 import dataclasses
 import logging
 import math
+import multiprocessing
 import random
+import time
+from concurrent.futures import Executor
 from concurrent.futures.process import ProcessPoolExecutor
-from typing import Dict, List, Optional, Tuple
+from typing import Dict, Iterator, List, Optional, Set, Tuple
 
 from chia.consensus.block_header_validation import validate_finished_header_block
 from chia.consensus.block_record import BlockRecord
@@ -37,27 +40,60 @@ from chia.types.weight_proof import (
 from chia.util.block_cache import BlockCache
 from chia.util.hash import std_hash
 from chia.util.ints import uint8, uint32, uint64, uint128
+from chia.util.lru_cache import LRUCache
 from chia.util.streamable import dataclass_from_dict, recurse_jsonify
 
 log = logging.getLogger(__name__)
 
+# only the last blocks of the recent chain get a full header validation, the rest only a proof of space check
+LAST_BLOCKS_TO_VALIDATE = 100  # todo remove cap after benchmarks
+# smallest number of recent chain blocks whose proofs of space are checked in one worker task
+MIN_RECENT_CHAIN_CHUNK = 50
+
 
 class WeightProofHandler:
 
     LAMBDA_L = 100
     C = 0.5
     MAX_SAMPLES = 20
+    SEGMENT_CACHE_SIZE = 2 * MAX_SAMPLES
 
     def __init__(
         self,
         constants: ConsensusConstants,
         blockchain: BlockchainInterface,
+        executor: Optional[Executor] = None,
     ):
         self.tip: Optional[bytes32] = None
         self.proof: Optional[WeightProof] = None
         self.constants = constants
         self.blockchain = blockchain
         self.lock = asyncio.Lock()
+        # Parts of the last proof that carry over to the next one. Entries are keyed or checked by header hash,
+        # so anything that was reorged out is rebuilt instead of reused. They are only used under self.lock, so proofs
+        # for different tips do not interleave their reads and updates.
+        self.recent_chain_cache: List[HeaderBlock] = []
+        self.ses_block_cache: Dict[uint32, BlockRecord] = {}
+        self.segment_cache: LRUCache = LRUCache(self.SEGMENT_CACHE_SIZE)
+        # Validation runs on the block validation pool of the blockchain when it is passed in, so that there is only
+        # one large process pool. Otherwise a pool of our own, the same size, is started on first use.
+        self.executor: Optional[Executor] = executor
+        self.owns_executor = executor is None
+        cpu_count = multiprocessing.cpu_count()
+        if cpu_count > 61:
+            cpu_count = 61  # Windows Server 2016 has an issue https://bugs.python.org/issue26903
+        self.num_workers = max(cpu_count - 2, 1)
+
+    def shut_down(self):
+        if self.owns_executor and self.executor is not None:
+            self.executor.shutdown(wait=False)
+            self.executor = None
+
+    def _get_executor(self) -> Executor:
+        if self.executor is None:
+            self.executor = ProcessPoolExecutor(max_workers=self.num_workers)
+            log.info(f"Started {self.num_workers} processes for weight proof validation")
+        return self.executor
 
     async def get_proof_of_weight(self, tip: bytes32) -> Optional[WeightProof]:
 
@@ -93,7 +129,8 @@ class WeightProofHandler:
 
     async def _create_proof_of_weight(self, tip: bytes32) -> Optional[WeightProof]:
         """
-        Creates a weight proof object
+        Creates a weight proof object. Callers other than get_proof_of_weight must not run it concurrently, since it
+        updates the caches across awaits.
         """
         assert self.blockchain is not None
         sub_epoch_segments: List[SubEpochChallengeSegment] = []
@@ -116,7 +153,7 @@ class WeightProofHandler:
         rng = random.Random(seed)
         weight_to_check = _get_weights_for_sampling(rng, tip_rec.weight, recent_chain)
         sample_n = 0
-        ses_blocks = await self.blockchain.get_block_records_at(summary_heights)
+        ses_blocks = await self._get_ses_blocks(summary_heights)
         if ses_blocks is None:
             return None
 
@@ -137,15 +174,10 @@ class WeightProofHandler:
 
             if _sample_sub_epoch(prev_ses_block.weight, ses_block.weight, weight_to_check):  # type: ignore
                 sample_n += 1
-                segments = await self.blockchain.get_sub_epoch_challenge_segments(ses_block.header_hash)
+                segments = await self._get_sub_epoch_segments(ses_block, prev_ses_block, uint32(sub_epoch_n))
                 if segments is None:
-                    segments = await self.__create_sub_epoch_segments(ses_block, prev_ses_block, uint32(sub_epoch_n))
-                    if segments is None:
-                        log.error(
-                            f"failed while building segments for sub epoch {sub_epoch_n}, ses height {ses_height} "
-                        )
-                        return None
-                    await self.blockchain.persist_sub_epoch_challenge_segments(ses_block.header_hash, segments)
+                    log.error(f"failed while building segments for sub epoch {sub_epoch_n}, ses height {ses_height} ")
+                    return None
                 log.debug(f"sub epoch {sub_epoch_n} has {len(segments)} segments")
                 sub_epoch_segments.extend(segments)
             prev_ses_block = ses_block
@@ -165,47 +197,89 @@ class WeightProofHandler:
         seed = ses.get_hash()
         return seed
 
-    async def _get_recent_chain(self, tip_height: uint32) -> Optional[List[HeaderBlock]]:
-        recent_chain: List[HeaderBlock] = []
-        ses_heights = self.blockchain.get_ses_heights()
-        min_height = 0
+    async def _get_ses_blocks(self, summary_heights: List[uint32]) -> Optional[List[BlockRecord]]:
+        """
+        Returns the block records that include each sub epoch summary, only reading the ones that are new (or were
+        replaced by a reorg) since the last proof from the db
+        """
+        missing: List[uint32] = []
+        for height in summary_heights:
+            cached = self.ses_block_cache.get(height)
+            if cached is None or cached.header_hash != self.blockchain.height_to_hash(height):
+                missing.append(height)
+        if len(missing) > 0:
+            records = await self.blockchain.get_block_records_at(missing)
+            if records is None or len(records) != len(missing):
+                return None
+            for height, record in zip(missing, records):
+                self.ses_block_cache[height] = record
+        self.ses_block_cache = {height: self.ses_block_cache[height] for height in summary_heights}
+        return [self.ses_block_cache[height] for height in summary_heights]
+
+    async def _get_sub_epoch_segments(
+        self, ses_block: BlockRecord, prev_ses_block: BlockRecord, sub_epoch_n: uint32
+    ) -> Optional[List[SubEpochChallengeSegment]]:
+        segments: Optional[List[SubEpochChallengeSegment]] = self.segment_cache.get(ses_block.header_hash)
+        if segments is not None:
+            return segments
+        segments = await self.blockchain.get_sub_epoch_challenge_segments(ses_block.header_hash)
+        if segments is None:
+            segments = await self.__create_sub_epoch_segments(ses_block, prev_ses_block, sub_epoch_n)
+            if segments is None:
+                return None
+            await self.blockchain.persist_sub_epoch_challenge_segments(ses_block.header_hash, segments)
+        self.segment_cache.put(ses_block.header_hash, segments)
+        return segments
+
+    def _recent_chain_start(self, tip_height: uint32) -> uint32:
+        # the recent chain starts one block before the second to last sub epoch summary
         count_ses = 0
-        for ses_height in reversed(ses_heights):
+        for ses_height in reversed(self.blockchain.get_ses_heights()):
             if ses_height <= tip_height:
                 count_ses += 1
             if count_ses == 2:
-                min_height = ses_height - 1
-                break
-        log.debug(f"start {min_height} end {tip_height}")
-        headers = await self.blockchain.get_header_blocks_in_range(min_height, tip_height)
-        blocks = await self.blockchain.get_block_records_in_range(min_height, tip_height)
-        ses_count = 0
-        curr_height = tip_height
-        blocks_n = 0
-        while ses_count < 2:
-            if curr_height == 0:
-                break
-            # add to needed reward chain recent blocks
-            header_block = headers[self.blockchain.height_to_hash(curr_height)]
-            block_rec = blocks[header_block.header_hash]
-            if header_block is None:
-                log.error("creating recent chain failed")
-                return None
-            recent_chain.insert(0, header_block)
-            if block_rec.sub_epoch_summary_included:
-                ses_count += 1
-            curr_height = uint32(curr_height - 1)  # type: ignore
-            blocks_n += 1
+                return uint32(ses_height - 1)
+        return uint32(0)
 
-        header_block = headers[self.blockchain.height_to_hash(curr_height)]
-        recent_chain.insert(0, header_block)
+    def _cached_recent_chain(self, min_height: uint32, tip_height: uint32) -> List[HeaderBlock]:
+        """
+        Returns the longest prefix of [min_height, tip_height] from the previously built recent chain that is still
+        part of the main chain
+        """
+        cache = self.recent_chain_cache
+        if len(cache) == 0 or cache[0].height > min_height or cache[-1].height < min_height:
+            return []
+        first = cache[0].height
+        end = min(tip_height, cache[-1].height)
+        while end >= min_height and cache[end - first].header_hash != self.blockchain.height_to_hash(uint32(end)):
+            end -= 1
+        return cache[min_height - first : end - first + 1]
+
+    async def _get_recent_chain(self, tip_height: uint32) -> Optional[List[HeaderBlock]]:
+        min_height = self._recent_chain_start(tip_height)
+        recent_chain: List[HeaderBlock] = self._cached_recent_chain(min_height, tip_height)
+        fetch_start = min_height if len(recent_chain) == 0 else recent_chain[-1].height + 1
+        log.debug(f"start {min_height} end {tip_height}, reused {len(recent_chain)} blocks")
+        if fetch_start <= tip_height:
+            try:
+                headers = await self.blockchain.get_header_blocks_in_range(fetch_start, tip_height)
+            except ValueError as e:
+                log.error(f"creating recent chain failed {e}")
+                return None
+            for height in range(fetch_start, tip_height + 1):
+                header_block = headers.get(self.blockchain.height_to_hash(uint32(height)))
+                if header_block is None:
+                    log.error("creating recent chain failed")
+                    return None
+                recent_chain.append(header_block)
+        self.recent_chain_cache = recent_chain
 
         log.info(
             f"recent chain, "
             f"start: {recent_chain[0].reward_chain_block.height} "
             f"end:  {recent_chain[-1].reward_chain_block.height} "
         )
-        return recent_chain
+        return list(recent_chain)
 
     async def create_prev_sub_epoch_segments(self):
         log.debug("create prev sub_epoch_segments")
@@ -574,6 +648,7 @@ class WeightProofHandler:
         peak_height = weight_proof.recent_chain_data[-1].reward_chain_block.height
         log.info(f"validate weight proof peak height {peak_height}")
 
+        start = time.time()
         summaries, sub_epoch_weight_list = _validate_sub_epoch_summaries(self.constants, weight_proof)
         if summaries is None:
             log.error("weight proof failed sub epoch data validation")
@@ -585,32 +660,115 @@ class WeightProofHandler:
             log.error("failed weight proof sub epoch sample validation")
             return False, uint32(0), []
 
-        executor = ProcessPoolExecutor(1)
-        constants, summary_bytes, wp_segment_bytes, wp_recent_chain_bytes = vars_to_bytes(
-            self.constants, summaries, weight_proof
-        )
-        segment_validation_task = asyncio.get_running_loop().run_in_executor(
-            executor, _validate_sub_epoch_segments, constants, rng, wp_segment_bytes, summary_bytes
-        )
-
-        recent_blocks_validation_task = asyncio.get_running_loop().run_in_executor(
-            executor, _validate_recent_blocks, constants, wp_recent_chain_bytes, summary_bytes
+        timings: Dict[str, float] = {"summaries": time.time() - start}
+        valid = await self._validate_segments_and_recent_chain(weight_proof, summaries, rng, timings)
+        log.info(
+            f"weight proof for peak height {peak_height} valid: {valid}, "
+            + ", ".join(f"{phase}: {duration:.2f}s" for phase, duration in timings.items())
         )
-
-        valid_segment_task = segment_validation_task
-        valid_recent_blocks_task = recent_blocks_validation_task
-        valid_recent_blocks = await valid_recent_blocks_task
-        if not valid_recent_blocks:
-            log.error("failed validating weight proof recent blocks")
-            return False, uint32(0), []
-
-        valid_segments = await valid_segment_task
-        if not valid_segments:
-            log.error("failed validating weight proof sub epoch segments")
+        if not valid:
             return False, uint32(0), []
 
         return True, self.get_fork_point(summaries), summaries
 
+    async def _validate_segments_and_recent_chain(
+        self,
+        weight_proof: WeightProof,
+        summaries: List[SubEpochSummary],
+        rng: random.Random,
+        timings: Dict[str, float],
+    ) -> bool:
+        """
+        Validates the sampled sub epochs and the recent chain on the worker pool. Every sampled sub epoch is its own
+        task, and the recent chain proofs of space are checked in chunks. Once those are all done, the last blocks of
+        the recent chain get a full header validation, using the required iters from the chunks. Returns as soon as
+        any task fails.
+        """
+        loop = asyncio.get_running_loop()
+        executor = self._get_executor()
+        start = time.time()
+        constants_dict = recurse_jsonify(dataclasses.asdict(self.constants))
+        summary_bytes = [bytes(summary) for summary in summaries]
+
+        # rng draws and the previous ssi depend on the order of the sub epochs, so they are done here
+        segment_tasks: Set[asyncio.Future] = set()
+        curr_ssi = self.constants.SUB_SLOT_ITERS_STARTING
+        for sub_epoch_n, segments in map_segments_by_sub_epoch(weight_proof.sub_epoch_segments).items():
+            prev_ssi = curr_ssi
+            _, curr_ssi = _get_curr_diff_ssi(self.constants, sub_epoch_n, summaries)
+            sampled_seg_index = rng.choice(range(len(segments)))
+            segment_tasks.add(
+                loop.run_in_executor(
+                    executor,
+                    _validate_sub_epoch,
+                    constants_dict,
+                    summary_bytes,
+                    uint32(sub_epoch_n),
+                    bytes(SubEpochSegments(segments)),
+                    sampled_seg_index,
+                    prev_ssi,
+                )
+            )
+
+        recent_chain = weight_proof.recent_chain_data
+        pospace_inputs = _recent_chain_pospace_inputs(self.constants, summaries, recent_chain)
+        chunk_size = max(MIN_RECENT_CHAIN_CHUNK, math.ceil(len(pospace_inputs) / self.num_workers))
+        pospace_tasks: Dict[asyncio.Future, List[int]] = {}
+        for chunk_start in range(0, len(pospace_inputs), chunk_size):
+            chunk = pospace_inputs[chunk_start : chunk_start + chunk_size]
+            chunk_bytes = bytes(RecentChainData([recent_chain[idx] for idx, _ in chunk]))
+            task = loop.run_in_executor(
+                executor, _validate_recent_chain_pospace, constants_dict, chunk_bytes, [inputs for _, inputs in chunk]
+            )
+            pospace_tasks[task] = [idx for idx, _ in chunk]
+        recent_chain_bytes = bytes(RecentChainData(recent_chain))
+        timings["serialization"] = time.time() - start
+
+        start = time.time()
+        required_iters: Dict[int, uint64] = {}
+        tail_task: Optional[asyncio.Future] = None
+        pending: Set[asyncio.Future] = segment_tasks | set(pospace_tasks.keys())
+        if len(pospace_tasks) == 0:
+            timings["recent chain pospace"] = 0.0
+        try:
+            while True:
+                if tail_task is None and len(required_iters) == len(pospace_inputs):
+                    tail_task = loop.run_in_executor(
+                        executor,
+                        _validate_recent_blocks,
+                        constants_dict,
+                        recent_chain_bytes,
+                        summary_bytes,
+                        required_iters,
+                    )
+                    pending.add(tail_task)
+                if len(segment_tasks & pending) == 0 and "segments" not in timings:
+                    timings["segments"] = time.time() - start
+                if len(pending) == 0:
+                    break
+                done, pending = await asyncio.wait(pending, return_when=asyncio.FIRST_COMPLETED)
+                for task in done:
+                    result = task.result()
+                    if result is None or result is False:
+                        if task is tail_task:
+                            log.error("failed validating weight proof recent blocks")
+                        elif task in pospace_tasks:
+                            log.error("failed validating weight proof recent chain proofs of space")
+                        else:
+                            log.error("failed validating weight proof sub epoch segments")
+                        return False
+                    if task in pospace_tasks:
+                        required_iters.update(zip(pospace_tasks[task], result))
+                        if len(required_iters) == len(pospace_inputs):
+                            timings["recent chain pospace"] = time.time() - start
+                    elif task is tail_task:
+                        timings["recent chain"] = time.time() - start
+            timings["validation"] = time.time() - start
+            return True
+        finally:
+            for task in pending:
+                task.cancel()
+
     def get_fork_point(self, received_summaries: List[SubEpochSummary]) -> uint32:
         # iterate through sub epoch summaries to find fork point
         fork_point_index = 0
@@ -920,38 +1078,61 @@ def _validate_sub_epoch_segments(
 ):
     constants, summaries = bytes_to_vars(constants_dict, summaries_bytes)
     sub_epoch_segments: SubEpochSegments = SubEpochSegments.from_bytes(weight_proof_bytes)
-    rc_sub_slot_hash = constants.GENESIS_CHALLENGE
-    total_blocks, total_ip_iters = 0, 0
-    total_slot_iters, total_slots = 0, 0
-    total_ip_iters = 0
-    prev_ses: Optional[SubEpochSummary] = None
     segments_by_sub_epoch = map_segments_by_sub_epoch(sub_epoch_segments.challenge_segments)
     curr_ssi = constants.SUB_SLOT_ITERS_STARTING
     for sub_epoch_n, segments in segments_by_sub_epoch.items():
         prev_ssi = curr_ssi
-        curr_difficulty, curr_ssi = _get_curr_diff_ssi(constants, sub_epoch_n, summaries)
-        log.debug(f"validate sub epoch {sub_epoch_n}")
-        # recreate RewardChainSubSlot for next ses rc_hash
+        _, curr_ssi = _get_curr_diff_ssi(constants, sub_epoch_n, summaries)
         sampled_seg_index = rng.choice(range(len(segments)))
-        if sub_epoch_n > 0:
-            rc_sub_slot = __get_rc_sub_slot(constants, segments[0], summaries, curr_ssi)
-            prev_ses = summaries[sub_epoch_n - 1]
-            rc_sub_slot_hash = rc_sub_slot.get_hash()
-        if not summaries[sub_epoch_n].reward_chain_hash == rc_sub_slot_hash:
-            log.error(f"failed reward_chain_hash validation sub_epoch {sub_epoch_n}")
+        if not __validate_sub_epoch_segments(constants, summaries, sub_epoch_n, segments, sampled_seg_index, prev_ssi):
             return False
-        for idx, segment in enumerate(segments):
-            valid_segment, ip_iters, slot_iters, slots = _validate_segment(
-                constants, segment, curr_ssi, prev_ssi, curr_difficulty, prev_ses, idx == 0, sampled_seg_index == idx
-            )
-            if not valid_segment:
-                log.error(f"failed to validate sub_epoch {segment.sub_epoch_n} segment {idx} slots")
-                return False
-            prev_ses = None
-            total_blocks += 1
-            total_slot_iters += slot_iters
-            total_slots += slots
-            total_ip_iters += ip_iters
+    return True
+
+
+def _validate_sub_epoch(
+    constants_dict: Dict,
+    summaries_bytes: List[bytes],
+    sub_epoch_n: uint32,
+    segments_bytes: bytes,
+    sampled_seg_index: int,
+    prev_ssi: uint64,
+) -> bool:
+    """
+    Validates the segments of a single sampled sub epoch, prev_ssi is the ssi of the sub epoch sampled before it
+    """
+    constants, summaries = bytes_to_vars(constants_dict, summaries_bytes)
+    segments = SubEpochSegments.from_bytes(segments_bytes).challenge_segments
+    return __validate_sub_epoch_segments(constants, summaries, sub_epoch_n, segments, sampled_seg_index, prev_ssi)
+
+
+def __validate_sub_epoch_segments(
+    constants: ConsensusConstants,
+    summaries: List[SubEpochSummary],
+    sub_epoch_n: int,
+    segments: List[SubEpochChallengeSegment],
+    sampled_seg_index: int,
+    prev_ssi: uint64,
+) -> bool:
+    curr_difficulty, curr_ssi = _get_curr_diff_ssi(constants, sub_epoch_n, summaries)
+    log.debug(f"validate sub epoch {sub_epoch_n}")
+    # recreate RewardChainSubSlot for next ses rc_hash
+    rc_sub_slot_hash = constants.GENESIS_CHALLENGE
+    prev_ses: Optional[SubEpochSummary] = None
+    if sub_epoch_n > 0:
+        rc_sub_slot = __get_rc_sub_slot(constants, segments[0], summaries, curr_ssi)
+        prev_ses = summaries[sub_epoch_n - 1]
+        rc_sub_slot_hash = rc_sub_slot.get_hash()
+    if not summaries[sub_epoch_n].reward_chain_hash == rc_sub_slot_hash:
+        log.error(f"failed reward_chain_hash validation sub_epoch {sub_epoch_n}")
+        return False
+    for idx, segment in enumerate(segments):
+        valid_segment, ip_iters, slot_iters, slots = _validate_segment(
+            constants, segment, curr_ssi, prev_ssi, curr_difficulty, prev_ses, idx == 0, sampled_seg_index == idx
+        )
+        if not valid_segment:
+            log.error(f"failed to validate sub_epoch {segment.sub_epoch_n} segment {idx} slots")
+            return False
+        prev_ses = None
     return True
 
 
@@ -1169,15 +1350,29 @@ def sub_slot_data_vdf_input(
     return cc_input
 
 
-def _validate_recent_blocks(constants_dict: Dict, recent_chain_bytes: bytes, summaries_bytes: List[bytes]) -> bool:
-    constants, summaries = bytes_to_vars(constants_dict, summaries_bytes)
-    recent_chain: RecentChainData = RecentChainData.from_bytes(recent_chain_bytes)
-    sub_blocks = BlockCache({})
-    first_ses_idx = _get_ses_idx(recent_chain.recent_chain_data)
+@dataclasses.dataclass(frozen=True)
+class RecentBlockState:
+    block: HeaderBlock
+    challenge: Optional[bytes32]
+    prev_challenge: Optional[bytes32]
+    sub_slot_deficit: Optional[uint8]  # deficit of the last sub slot finished in this block
+    ssi: uint64
+    diff: uint64
+    ses: Optional[SubEpochSummary]  # sub epoch summary included in this block
+    ses_blocks: int
+    full_validation: bool
+
+
+def _walk_recent_chain(
+    constants: ConsensusConstants, summaries: List[SubEpochSummary], recent_chain: List[HeaderBlock]
+) -> Iterator[RecentBlockState]:
+    """
+    Yields the state each recent chain block is validated against, this does not check any proofs
+    """
+    first_ses_idx = _get_ses_idx(recent_chain)
     ses_idx = len(summaries) - len(first_ses_idx)
     ssi: uint64 = constants.SUB_SLOT_ITERS_STARTING
-    diff: Optional[uint64] = constants.DIFFICULTY_STARTING
-    last_blocks_to_validate = 100  # todo remove cap after benchmarks
+    diff: uint64 = constants.DIFFICULTY_STARTING
     for summary in summaries[:ses_idx]:
         if summary.new_sub_slot_iters is not None:
             ssi = summary.new_sub_slot_iters
@@ -1186,58 +1381,115 @@ def _validate_recent_blocks(constants_dict: Dict, recent_chain_bytes: bytes, sum
 
     ses_blocks, sub_slots, transaction_blocks = 0, 0, 0
     challenge, prev_challenge = None, None
-    tip_height = recent_chain.recent_chain_data[-1].height
-    prev_block_record = None
-    deficit = uint8(0)
-    for idx, block in enumerate(recent_chain.recent_chain_data):
-        required_iters = uint64(0)
-        overflow = False
-        ses = False
-        height = block.height
+    tip_height = recent_chain[-1].height
+    for block in recent_chain:
+        ses: Optional[SubEpochSummary] = None
+        sub_slot_deficit: Optional[uint8] = None
         for sub_slot in block.finished_sub_slots:
             prev_challenge = challenge
             challenge = sub_slot.challenge_chain.get_hash()
-            deficit = sub_slot.reward_chain.deficit
+            sub_slot_deficit = sub_slot.reward_chain.deficit
             if sub_slot.challenge_chain.subepoch_summary_hash is not None:
-                ses = True
                 assert summaries[ses_idx].get_hash() == sub_slot.challenge_chain.subepoch_summary_hash
+                ses = summaries[ses_idx]
                 ses_idx += 1
             if sub_slot.challenge_chain.new_sub_slot_iters is not None:
                 ssi = sub_slot.challenge_chain.new_sub_slot_iters
             if sub_slot.challenge_chain.new_difficulty is not None:
                 diff = sub_slot.challenge_chain.new_difficulty
 
-        if (challenge is not None) and (prev_challenge is not None):
+        full_validation = (
+            sub_slots > 2 and transaction_blocks > 11 and (tip_height - block.height < LAST_BLOCKS_TO_VALIDATE)
+        )
+        yield RecentBlockState(
+            block, challenge, prev_challenge, sub_slot_deficit, ssi, diff, ses, ses_blocks, full_validation
+        )
+
+        if block.first_in_sub_slot:
+            sub_slots += 1
+        if block.is_transaction_block:
+            transaction_blocks += 1
+        if ses is not None:
+            ses_blocks += 1
+
+
+def _recent_chain_pospace_inputs(
+    constants: ConsensusConstants, summaries: List[SubEpochSummary], recent_chain: List[HeaderBlock]
+) -> List[Tuple[int, Tuple[bytes32, bytes32, uint64, bool]]]:
+    """
+    Returns the index in the recent chain and the inputs for _validate_pospace_recent_chain of every block that
+    only gets a proof of space check
+    """
+    inputs: List[Tuple[int, Tuple[bytes32, bytes32, uint64, bool]]] = []
+    for idx, state in enumerate(_walk_recent_chain(constants, summaries, recent_chain)):
+        if state.challenge is None or state.prev_challenge is None or state.full_validation:
+            continue
+        overflow = is_overflow_block(constants, state.block.reward_chain_block.signage_point_index)
+        inputs.append((idx, (state.challenge, state.prev_challenge, state.diff, overflow)))
+    return inputs
+
+
+def _validate_recent_chain_pospace(
+    constants_dict: Dict, blocks_bytes: bytes, inputs: List[Tuple[bytes32, bytes32, uint64, bool]]
+) -> Optional[List[uint64]]:
+    constants: ConsensusConstants = dataclass_from_dict(ConsensusConstants, constants_dict)
+    blocks = RecentChainData.from_bytes(blocks_bytes).recent_chain_data
+    all_required_iters: List[uint64] = []
+    for block, (challenge, prev_challenge, diff, overflow) in zip(blocks, inputs):
+        required_iters = _validate_pospace_recent_chain(constants, block, challenge, diff, overflow, prev_challenge)
+        if required_iters is None:
+            return None
+        all_required_iters.append(required_iters)
+    return all_required_iters
+
+
+def _validate_recent_blocks(
+    constants_dict: Dict,
+    recent_chain_bytes: bytes,
+    summaries_bytes: List[bytes],
+    pospace_required_iters: Optional[Dict[int, uint64]] = None,
+) -> bool:
+    """
+    pospace_required_iters holds the results of _validate_recent_chain_pospace by recent chain index, if the proofs
+    of space were already checked
+    """
+    constants, summaries = bytes_to_vars(constants_dict, summaries_bytes)
+    recent_chain: RecentChainData = RecentChainData.from_bytes(recent_chain_bytes)
+    sub_blocks = BlockCache({})
+    prev_block_record = None
+    deficit = uint8(0)
+    for idx, state in enumerate(_walk_recent_chain(constants, summaries, recent_chain.recent_chain_data)):
+        block = state.block
+        required_iters = uint64(0)
+        overflow = False
+        if state.sub_slot_deficit is not None:
+            deficit = state.sub_slot_deficit
+
+        if (state.challenge is not None) and (state.prev_challenge is not None):
             overflow = is_overflow_block(constants, block.reward_chain_block.signage_point_index)
             deficit = get_deficit(constants, deficit, prev_block_record, overflow, len(block.finished_sub_slots))
             log.debug(f"wp, validate block {block.height}")
-            if sub_slots > 2 and transaction_blocks > 11 and (tip_height - block.height < last_blocks_to_validate):
+            if state.full_validation:
                 required_iters, error = validate_finished_header_block(
-                    constants, sub_blocks, block, False, diff, ssi, ses_blocks > 2
+                    constants, sub_blocks, block, False, state.diff, state.ssi, state.ses_blocks > 2
                 )
                 if error is not None:
                     log.error(f"block {block.header_hash} failed validation {error}")
                     return False
+            elif pospace_required_iters is not None:
+                required_iters = pospace_required_iters[idx]
             else:
                 required_iters = _validate_pospace_recent_chain(
-                    constants, block, challenge, diff, overflow, prev_challenge
+                    constants, block, state.challenge, state.diff, overflow, state.prev_challenge
                 )
                 if required_iters is None:
                     return False
 
-        curr_block_ses = None if not ses else summaries[ses_idx - 1]
         block_record = header_block_to_sub_block_record(
-            constants, required_iters, block, ssi, overflow, deficit, height, curr_block_ses
+            constants, required_iters, block, state.ssi, overflow, deficit, block.height, state.ses
         )
         log.debug(f"add block {block_record.height} to tmp sub blocks")
         sub_blocks.add_block_record(block_record)
-
-        if block.first_in_sub_slot:
-            sub_slots += 1
-        if block.is_transaction_block:
-            transaction_blocks += 1
-        if ses:
-            ses_blocks += 1
         prev_block_record = block_record
 
     return True
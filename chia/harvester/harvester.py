@@ -1,6 +1,7 @@
 import asyncio
 import concurrent
 import logging
+from functools import partial
 from concurrent.futures.thread import ThreadPoolExecutor
 from pathlib import Path
 from typing import Callable, Dict, List, Optional, Set, Tuple
@@ -9,17 +10,27 @@ from blspy import G1Element
 
 import chia.server.ws_connection as ws  # lgtm [py/import-and-import-from]
 from chia.consensus.constants import ConsensusConstants
+from chia.harvester.lookup_scheduler import LookupScheduler, max_lookups_per_device
+from chia.harvester.lookup_stats import LookupStats
+from chia.plotting.plot_cache import PlotCache
 from chia.plotting.plot_tools import PlotInfo
 from chia.plotting.plot_tools import add_plot_directory as add_plot_directory_pt
 from chia.plotting.plot_tools import get_plot_directories as get_plot_directories_pt
 from chia.plotting.plot_tools import load_plots
 from chia.plotting.plot_tools import remove_plot_directory as remove_plot_directory_pt
+from chia.plotting.plot_watcher import PlotDirectoryWatcher
+from chia.util.path import path_from_root
 
 log = logging.getLogger(__name__)
 
+# How long to wait for more plot directory changes before applying them, so that moving many plots is one update
+PLOT_CHANGE_DELAY = 1.0
+
 
 class Harvester:
     provers: Dict[Path, PlotInfo]
+    plot_filter_ids: bytes
+    plot_filter_paths: List[Path]
     failed_to_open_filenames: Dict[Path, int]
     no_key_filenames: Set[Path]
     farmer_public_keys: List[G1Element]
@@ -27,16 +38,23 @@ class Harvester:
     root_path: Path
     _is_shutdown: bool
     executor: ThreadPoolExecutor
+    lookup_scheduler: LookupScheduler
+    lookup_stats: LookupStats
     state_changed_callback: Optional[Callable]
     cached_challenges: List
     constants: ConsensusConstants
     _refresh_lock: asyncio.Lock
+    _refresh_task: Optional[asyncio.Task]
+    plot_watcher: Optional[PlotDirectoryWatcher]
 
     def __init__(self, root_path: Path, config: Dict, constants: ConsensusConstants):
         self.root_path = root_path
 
         # From filename to prover
         self.provers = {}
+        # Plot ids of all provers back to back, and the matching paths, for evaluating the plot filter in one pass
+        self.plot_filter_ids = b""
+        self.plot_filter_paths = []
         self.failed_to_open_filenames = {}
         self.no_key_filenames = set()
 
@@ -46,20 +64,45 @@ class Harvester:
         self.match_str = None
         self.show_memo: bool = False
         self.executor = concurrent.futures.ThreadPoolExecutor(max_workers=config["num_threads"])
+        self.lookup_scheduler = LookupScheduler(self.executor, max_lookups_per_device(config))
+        # Lookups taking longer than this part of the time between signage points are slow
+        sp_interval_seconds = constants.SUB_SLOT_TIME_TARGET / constants.NUM_SPS_SUB_SLOT
+        self.lookup_stats = LookupStats(config.get("slow_lookup_sp_interval_fraction", 0.5) * sp_interval_seconds)
         self.state_changed_callback = None
         self.server = None
         self.constants = constants
         self.cached_challenges = []
         self.log = log
         self.state_changed_callback: Optional[Callable] = None
-        self.last_load_time: float = 0
         self.plot_load_frequency = config.get("plot_loading_frequency_seconds", 120)
+        self.watch_plot_directories: bool = config.get("watch_plot_directories", True)
+        self.plot_watcher = None
+        self._refresh_task = None
+        self._plot_change_task: Optional[asyncio.Task] = None
+        self._added_plot_files: Set[Path] = set()
+        self._removed_plot_files: Set[Path] = set()
+        self._plot_rescan_needed = False
+        self.plot_cache = PlotCache(path_from_root(root_path, config.get("plot_cache_path", "cache/plot_cache.dat")))
+        self.plot_cache.load()
 
     async def _start(self):
         self._refresh_lock = asyncio.Lock()
+        if self.watch_plot_directories:
+            self.plot_watcher = PlotDirectoryWatcher.create(self._on_plot_files_changed)
+            if self.plot_watcher is not None:
+                self.plot_watcher.watch([Path(directory) for directory in get_plot_directories_pt(self.root_path)])
+                self.plot_watcher.start()
+        self._refresh_task = asyncio.create_task(self._refresh_plots_periodically())
 
     def _close(self):
         self._is_shutdown = True
+        if self._refresh_task is not None:
+            self._refresh_task.cancel()
+        if self._plot_change_task is not None:
+            self._plot_change_task.cancel()
+        if self.plot_watcher is not None:
+            self.plot_watcher.close()
+            self.plot_watcher = None
         self.executor.shutdown(wait=True)
 
     async def _await_closed(self):
@@ -99,13 +142,22 @@ class Harvester:
             [str(s) for s in self.no_key_filenames],
         )
 
+    def _have_keys(self) -> bool:
+        # Until the handshake with the farmer, no plot could be farmed
+        return len(self.pool_public_keys) > 0 and len(self.farmer_public_keys) > 0
+
     async def refresh_plots(self):
-        locked: bool = self._refresh_lock.locked()
-        changed: bool = False
-        if not locked:
-            async with self._refresh_lock:
-                # Avoid double refreshing of plots
-                (changed, self.provers, self.failed_to_open_filenames, self.no_key_filenames,) = load_plots(
+        async with self._refresh_lock:
+            # Opening plots blocks, so the directories are scanned off the event loop
+            (
+                changed,
+                self.provers,
+                self.failed_to_open_filenames,
+                self.no_key_filenames,
+            ) = await asyncio.get_running_loop().run_in_executor(
+                None,
+                partial(
+                    load_plots,
                     self.provers,
                     self.failed_to_open_filenames,
                     self.farmer_public_keys,
@@ -113,14 +165,107 @@ class Harvester:
                     self.match_str,
                     self.show_memo,
                     self.root_path,
-                )
+                    plot_cache=self.plot_cache,
+                ),
+            )
+            self._update_plot_filter_ids()
+            if self.plot_watcher is not None:
+                self.plot_watcher.watch([Path(directory) for directory in get_plot_directories_pt(self.root_path)])
         if changed:
             self._state_changed("plots")
 
+    async def update_plots(self, added: Set[Path], removed: Set[Path]):
+        """
+        Applies added and removed plot files without scanning the plot directories. A plot file that was rewritten is
+        in added, and is opened again.
+        """
+        async with self._refresh_lock:
+            for path in added:
+                self.failed_to_open_filenames.pop(path, None)
+            (
+                _,
+                new_provers,
+                self.failed_to_open_filenames,
+                no_key_filenames,
+            ) = await asyncio.get_running_loop().run_in_executor(
+                None,
+                partial(
+                    load_plots,
+                    {},
+                    self.failed_to_open_filenames,
+                    self.farmer_public_keys,
+                    self.pool_public_keys,
+                    self.match_str,
+                    self.show_memo,
+                    self.root_path,
+                    plot_cache=self.plot_cache,
+                    filenames=list(added),
+                ),
+            )
+            provers = {path: info for path, info in self.provers.items() if path not in added and path not in removed}
+            plot_ids = {plot_info.prover.get_id() for plot_info in provers.values()}
+            for path, plot_info in new_provers.items():
+                if plot_info.prover.get_id() in plot_ids:
+                    self.log.warning(f"Have multiple copies of the plot {path}, not adding it.")
+                    continue
+                provers[path] = plot_info
+            for path in removed:
+                self.failed_to_open_filenames.pop(path, None)
+            self.provers = provers
+            self.no_key_filenames = (self.no_key_filenames - added - removed) | no_key_filenames
+            self._update_plot_filter_ids()
+        self.log.info(f"Added {len(new_provers)} and removed {len(removed)} plot files, farming {len(provers)} plots")
+        self._state_changed("plots")
+
+    def _on_plot_files_changed(self, added: Set[Path], removed: Set[Path], rescan: bool):
+        self._added_plot_files = (self._added_plot_files - removed) | added
+        self._removed_plot_files = (self._removed_plot_files - added) | removed
+        self._plot_rescan_needed |= rescan
+        if self._plot_change_task is None or self._plot_change_task.done():
+            self._plot_change_task = asyncio.create_task(self._apply_plot_file_changes())
+
+    async def _apply_plot_file_changes(self):
+        while len(self._added_plot_files) > 0 or len(self._removed_plot_files) > 0 or self._plot_rescan_needed:
+            await asyncio.sleep(PLOT_CHANGE_DELAY)
+            added, removed, rescan = self._added_plot_files, self._removed_plot_files, self._plot_rescan_needed
+            self._added_plot_files, self._removed_plot_files, self._plot_rescan_needed = set(), set(), False
+            if not self._have_keys():
+                # The refresh after the handshake picks these up
+                continue
+            try:
+                if rescan:
+                    await self.refresh_plots()
+                else:
+                    await self.update_plots(added, removed)
+            except Exception as e:
+                self.log.error(f"Error applying plot directory changes {e}")
+
+    async def _refresh_plots_periodically(self):
+        # Also with a watcher, since changes to network mounts are not always reported
+        while not self._is_shutdown:
+            await asyncio.sleep(self.plot_load_frequency)
+            if not self._have_keys():
+                continue
+            try:
+                await self.refresh_plots()
+            except Exception as e:
+                self.log.error(f"Error refreshing plots {e}")
+
+    def _update_plot_filter_ids(self):
+        paths: List[Path] = []
+        plot_ids: List[bytes] = []
+        for path, plot_info in self.provers.items():
+            paths.append(path)
+            plot_ids.append(plot_info.prover.get_id())
+        self.plot_filter_ids = b"".join(plot_ids)
+        self.plot_filter_paths = paths
+        self.lookup_stats.remove_missing(set(paths))
+
     def delete_plot(self, str_path: str):
         path = Path(str_path).resolve()
         if path in self.provers:
             del self.provers[path]
+            self._update_plot_filter_ids()
 
         # Remove absolute and relative paths
         if path.exists():
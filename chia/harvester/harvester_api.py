@@ -1,17 +1,19 @@
 import asyncio
 import time
 from pathlib import Path
-from typing import Callable, List, Tuple
+from typing import Callable, List, Optional, Tuple
 
 from blspy import AugSchemeMPL, G2Element
 
 from chia.consensus.pot_iterations import calculate_iterations_quality, calculate_sp_interval_iters
 from chia.harvester.harvester import Harvester
+from chia.harvester.lookup_scheduler import PRIORITY_FULL_PROOF, PRIORITY_QUALITIES
 from chia.plotting.plot_tools import PlotInfo, parse_plot_info
 from chia.protocols import harvester_protocol
 from chia.protocols.farmer_protocol import FarmingInfo
 from chia.protocols.protocol_message_types import ProtocolMessageTypes
-from chia.server.outbound_message import make_msg
+from chia.protocols.shared_protocol import Capability
+from chia.server.outbound_message import Message, make_msg
 from chia.server.ws_connection import WSChiaConnection
 from chia.types.blockchain_format.proof_of_space import ProofOfSpace
 from chia.types.blockchain_format.sized_bytes import bytes32
@@ -45,6 +47,44 @@ class HarvesterAPI:
             self.harvester.log.warning("Not farming any plots on this harvester. Check your configuration.")
             return
 
+    def _blocking_lookup_proof(
+        self, filename: Path, plot_info: PlotInfo, challenge_hash: bytes32, sp_hash: bytes32, index: int
+    ) -> Optional[ProofOfSpace]:
+        # Fetches the full proof for one of the qualities of the plot, about 64 reads. This is a blocking call,
+        # so it should be run in a thread pool.
+        try:
+            plot_id = plot_info.prover.get_id()
+            sp_challenge_hash = ProofOfSpace.calculate_pos_challenge(plot_id, challenge_hash, sp_hash)
+            try:
+                proof_xs = plot_info.prover.get_full_proof(sp_challenge_hash, index)
+            except Exception as e:
+                self.harvester.log.error(f"Exception fetching full proof for {filename}. {e}")
+                self.harvester.log.error(
+                    f"File: {filename} Plot ID: {plot_id.hex()}, challenge: {sp_challenge_hash}, "
+                    f"plot_info: {plot_info}"
+                )
+                return None
+
+            # Look up local_sk from plot to save locked memory
+            (
+                pool_public_key_or_puzzle_hash,
+                farmer_public_key,
+                local_master_sk,
+            ) = parse_plot_info(plot_info.prover.get_memo())
+            local_sk = master_sk_to_local_sk(local_master_sk)
+            plot_public_key = ProofOfSpace.generate_plot_public_key(local_sk.get_g1(), farmer_public_key)
+            return ProofOfSpace(
+                sp_challenge_hash,
+                plot_info.pool_public_key,
+                plot_info.pool_contract_puzzle_hash,
+                plot_public_key,
+                uint8(plot_info.prover.get_size()),
+                proof_xs,
+            )
+        except Exception as e:
+            self.harvester.log.error(f"Unknown error: {e}")
+            return None
+
     @peer_required
     @api_request
     async def new_signage_point_harvester(
@@ -61,25 +101,26 @@ class HarvesterAPI:
         inclusion (required_iters < sp_interval_iters).
         4. Looks up the full proof of space in the plot for each quality, approximately 64 reads per quality
         5. Returns the proof of space to the farmer
+        If the farmer supports Capability.QUALITY_ANNOUNCE, steps 4 and 5 are replaced by announcing the quality, and
+        the farmer requests the proofs it wants with request_proof_of_space.
         """
-        if len(self.harvester.pool_public_keys) == 0 or len(self.harvester.farmer_public_keys) == 0:
+        if not self.harvester._have_keys():
             # This means that we have not received the handshake yet
             return
 
         start = time.time()
         assert len(new_challenge.challenge_hash) == 32
 
-        # Refresh plots to see if there are any new ones
-        if start - self.harvester.last_load_time > self.harvester.plot_load_frequency:
-            await self.harvester.refresh_plots()
-            self.harvester.last_load_time = time.time()
+        sp_interval_iters = calculate_sp_interval_iters(self.harvester.constants, new_challenge.sub_slot_iters)
+        announce_qualities = peer.has_capability(Capability.QUALITY_ANNOUNCE)
 
-        loop = asyncio.get_running_loop()
-
-        def blocking_lookup(filename: Path, plot_info: PlotInfo) -> List[Tuple[bytes32, ProofOfSpace]]:
+        def blocking_lookup_qualities(filename: Path, plot_info: PlotInfo) -> List[Tuple[int, bytes32, uint64]]:
             # Uses the DiskProver object to lookup qualities. This is a blocking call,
-            # so it should be run in a thread pool.
+            # so it should be run in a thread pool. Returns the qualities good enough to fetch the full proof for.
             try:
+                if not filename.exists():
+                    self.harvester.log.error(f"Plot file {filename} may no longer exist")
+                    return []
                 plot_id = plot_info.prover.get_id()
                 sp_challenge_hash = ProofOfSpace.calculate_pos_challenge(
                     plot_id,
@@ -96,7 +137,7 @@ class HarvesterAPI:
                     )
                     return []
 
-                responses: List[Tuple[bytes32, ProofOfSpace]] = []
+                good_qualities: List[Tuple[int, bytes32, uint64]] = []
                 if quality_strings is not None:
                     # Found proofs of space (on average 1 is expected per plot)
                     for index, quality_str in enumerate(quality_strings):
@@ -107,91 +148,91 @@ class HarvesterAPI:
                             new_challenge.difficulty,
                             new_challenge.sp_hash,
                         )
-                        sp_interval_iters = calculate_sp_interval_iters(
-                            self.harvester.constants, new_challenge.sub_slot_iters
-                        )
                         if required_iters < sp_interval_iters:
-                            # Found a very good proof of space! will fetch the whole proof from disk,
-                            # then send to farmer
-                            try:
-                                proof_xs = plot_info.prover.get_full_proof(sp_challenge_hash, index)
-                            except Exception as e:
-                                self.harvester.log.error(f"Exception fetching full proof for {filename}. {e}")
-                                self.harvester.log.error(
-                                    f"File: {filename} Plot ID: {plot_id.hex()}, challenge: {sp_challenge_hash}, "
-                                    f"plot_info: {plot_info}"
-                                )
-                                continue
-
-                            # Look up local_sk from plot to save locked memory
-                            (
-                                pool_public_key_or_puzzle_hash,
-                                farmer_public_key,
-                                local_master_sk,
-                            ) = parse_plot_info(plot_info.prover.get_memo())
-                            local_sk = master_sk_to_local_sk(local_master_sk)
-                            plot_public_key = ProofOfSpace.generate_plot_public_key(
-                                local_sk.get_g1(), farmer_public_key
-                            )
-                            responses.append(
-                                (
-                                    quality_str,
-                                    ProofOfSpace(
-                                        sp_challenge_hash,
-                                        plot_info.pool_public_key,
-                                        plot_info.pool_contract_puzzle_hash,
-                                        plot_public_key,
-                                        uint8(plot_info.prover.get_size()),
-                                        proof_xs,
-                                    ),
-                                )
-                            )
-                return responses
+                            # Found a very good proof of space! the whole proof will be fetched from disk
+                            good_qualities.append((index, quality_str, required_iters))
+                return good_qualities
             except Exception as e:
                 self.harvester.log.error(f"Unknown error: {e}")
                 return []
 
-        async def lookup_challenge(
-            filename: Path, plot_info: PlotInfo
-        ) -> Tuple[Path, List[harvester_protocol.NewProofOfSpace]]:
-            # Executes a DiskProverLookup in a thread pool, and returns responses
-            all_responses: List[harvester_protocol.NewProofOfSpace] = []
+        async def lookup_challenge(filename: Path, plot_info: PlotInfo) -> Tuple[Path, List[Message]]:
+            # Executes the DiskProver lookups on the plot's disk, and returns responses
+            all_responses: List[Message] = []
             if self.harvester._is_shutdown:
                 return filename, []
-            proofs_of_space_and_q: List[Tuple[bytes32, ProofOfSpace]] = await loop.run_in_executor(
-                self.harvester.executor, blocking_lookup, filename, plot_info
+            scheduler = self.harvester.lookup_scheduler
+            directory = str(filename.parent)
+            lookup_start = time.monotonic()
+            good_qualities: List[Tuple[int, bytes32, uint64]] = await scheduler.run(
+                plot_info.device, directory, PRIORITY_QUALITIES, blocking_lookup_qualities, filename, plot_info
             )
-            for quality_str, proof_of_space in proofs_of_space_and_q:
-                all_responses.append(
-                    harvester_protocol.NewProofOfSpace(
+            qualities_time = time.monotonic() - lookup_start
+            if announce_qualities:
+                self.harvester.lookup_stats.add(filename, qualities_time, None, time.time() - start)
+                for index, quality_str, required_iters in good_qualities:
+                    announcement = harvester_protocol.NewQualityHarvester(
                         new_challenge.challenge_hash,
                         new_challenge.sp_hash,
                         quality_str.hex() + str(filename.resolve()),
-                        proof_of_space,
+                        uint8(index),
+                        required_iters,
                         new_challenge.signage_point_index,
                     )
+                    all_responses.append(make_msg(ProtocolMessageTypes.new_quality_harvester, announcement))
+                return filename, all_responses
+
+            full_proof_time: Optional[float] = None
+            proofs_of_space: List[Optional[ProofOfSpace]] = []
+            if len(good_qualities) > 0:
+                proofs_of_space = await asyncio.gather(
+                    *[
+                        scheduler.run(
+                            plot_info.device,
+                            directory,
+                            PRIORITY_FULL_PROOF,
+                            self._blocking_lookup_proof,
+                            filename,
+                            plot_info,
+                            new_challenge.challenge_hash,
+                            new_challenge.sp_hash,
+                            index,
+                        )
+                        for index, _, _ in good_qualities
+                    ]
                 )
+                full_proof_time = time.monotonic() - lookup_start - qualities_time
+            self.harvester.lookup_stats.add(filename, qualities_time, full_proof_time, time.time() - start)
+            for (_, quality_str, _), proof_of_space in zip(good_qualities, proofs_of_space):
+                if proof_of_space is None:
+                    continue
+                response = harvester_protocol.NewProofOfSpace(
+                    new_challenge.challenge_hash,
+                    new_challenge.sp_hash,
+                    quality_str.hex() + str(filename.resolve()),
+                    proof_of_space,
+                    new_challenge.signage_point_index,
+                )
+                all_responses.append(make_msg(ProtocolMessageTypes.new_proof_of_space, response))
             return filename, all_responses
 
         awaitables = []
         passed = 0
-        total = 0
-        for try_plot_filename, try_plot_info in self.harvester.provers.items():
-            try:
-                if try_plot_filename.exists():
-                    # Passes the plot filter (does not check sp filter yet though, since we have not reached sp)
-                    # This is being executed at the beginning of the slot
-                    total += 1
-                    if ProofOfSpace.passes_plot_filter(
-                        self.harvester.constants,
-                        try_plot_info.prover.get_id(),
-                        new_challenge.challenge_hash,
-                        new_challenge.sp_hash,
-                    ):
-                        passed += 1
-                        awaitables.append(lookup_challenge(try_plot_filename, try_plot_info))
-            except Exception as e:
-                self.harvester.log.error(f"Error plot file {try_plot_filename} may no longer exist {e}")
+        total = len(self.harvester.plot_filter_paths)
+        # Passes the plot filter (does not check sp filter yet though, since we have not reached sp)
+        # This is being executed at the beginning of the slot
+        for index in ProofOfSpace.plots_passing_filter(
+            self.harvester.constants,
+            self.harvester.plot_filter_ids,
+            new_challenge.challenge_hash,
+            new_challenge.sp_hash,
+        ):
+            try_plot_filename = self.harvester.plot_filter_paths[index]
+            try_plot_info = self.harvester.provers.get(try_plot_filename)
+            if try_plot_info is None:
+                continue
+            passed += 1
+            awaitables.append(lookup_challenge(try_plot_filename, try_plot_info))
 
         # Concurrently executes all lookups on disk, to take advantage of multiple disk parallelism
         total_proofs_found = 0
@@ -207,9 +248,8 @@ class HarvesterAPI:
                 pass
                 # If you want additional logs, uncomment the following line
                 # self.harvester.log.debug(f"Looking up qualities on {filename} took: {time.time() - start}")
-            for response in sublist:
+            for msg in sublist:
                 total_proofs_found += 1
-                msg = make_msg(ProtocolMessageTypes.new_proof_of_space, response)
                 await peer.send_message(msg)
 
         now = uint64(int(time.time()))
@@ -230,18 +270,47 @@ class HarvesterAPI:
         )
 
     @api_request
-    async def request_signatures(self, request: harvester_protocol.RequestSignatures):
+    async def request_proof_of_space(self, request: harvester_protocol.RequestProofOfSpace):
         """
-        The farmer requests a signature on the header hash, for one of the proofs that we found.
-        A signature is created on the header hash using the harvester private key. This can also
-        be used for pooling.
+        The farmer requests the full proof for a quality that we announced with new_quality_harvester.
         """
         plot_filename = Path(request.plot_identifier[64:]).resolve()
+        plot_info = self.harvester.provers.get(plot_filename)
+        if plot_info is None:
+            self.harvester.log.warning(f"KeyError plot {plot_filename} does not exist.")
+            return
+
+        proof_of_space: Optional[ProofOfSpace] = await self.harvester.lookup_scheduler.run(
+            plot_info.device,
+            str(plot_filename.parent),
+            PRIORITY_FULL_PROOF,
+            self._blocking_lookup_proof,
+            plot_filename,
+            plot_info,
+            request.challenge_hash,
+            request.sp_hash,
+            request.quality_index,
+        )
+        if proof_of_space is None:
+            return
+        response = harvester_protocol.NewProofOfSpace(
+            request.challenge_hash,
+            request.sp_hash,
+            request.plot_identifier,
+            proof_of_space,
+            request.signage_point_index,
+        )
+        return make_msg(ProtocolMessageTypes.new_proof_of_space, response)
+
+    def _sign(self, request: harvester_protocol.RequestSignatures) -> Optional[harvester_protocol.RespondSignatures]:
+        # Signs the messages with the local key of the plot. The memo is kept in memory by the prover, so this does not
+        # touch the disk, and runs right away instead of waiting behind the lookups in the thread pool.
+        plot_filename = Path(request.plot_identifier[64:]).resolve()
         try:
             plot_info = self.harvester.provers[plot_filename]
         except KeyError:
             self.harvester.log.warning(f"KeyError plot {plot_filename} does not exist.")
-            return
+            return None
 
         # Look up local_sk from plot to save locked memory
         (
@@ -260,7 +329,7 @@ class HarvesterAPI:
             signature: G2Element = AugSchemeMPL.sign(local_sk, message, agg_pk)
             message_signatures.append((message, signature))
 
-        response: harvester_protocol.RespondSignatures = harvester_protocol.RespondSignatures(
+        return harvester_protocol.RespondSignatures(
             request.plot_identifier,
             request.challenge_hash,
             request.sp_hash,
@@ -269,4 +338,36 @@ class HarvesterAPI:
             message_signatures,
         )
 
+    def _sign_batch(
+        self, requests: List[harvester_protocol.RequestSignatures]
+    ) -> List[harvester_protocol.RespondSignatures]:
+        responses: List[harvester_protocol.RespondSignatures] = []
+        for request in requests:
+            response = self._sign(request)
+            if response is not None:
+                responses.append(response)
+        return responses
+
+    @api_request
+    async def request_signatures(self, request: harvester_protocol.RequestSignatures):
+        """
+        The farmer requests a signature on the header hash, for one of the proofs that we found.
+        A signature is created on the header hash using the harvester private key. This can also
+        be used for pooling.
+        """
+        response: Optional[harvester_protocol.RespondSignatures] = self._sign(request)
+        if response is None:
+            return
         return make_msg(ProtocolMessageTypes.respond_signatures, response)
+
+    @api_request
+    async def request_signatures_batch(self, request: harvester_protocol.RequestSignaturesBatch):
+        """
+        All the signature requests of the farmer for one signage point, answered in one message.
+        """
+        responses: List[harvester_protocol.RespondSignatures] = self._sign_batch(request.requests)
+        if len(responses) == 0:
+            return
+        return make_msg(
+            ProtocolMessageTypes.respond_signatures_batch, harvester_protocol.RespondSignaturesBatch(responses)
+        )
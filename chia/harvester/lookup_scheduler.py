@@ -0,0 +1,118 @@
+import asyncio
+import heapq
+import itertools
+import os
+import time
+from concurrent.futures import Executor
+from dataclasses import dataclass, field
+from typing import Any, Callable, Dict, List, Set, Tuple
+
+from chia.util.histogram import Histogram
+
+# Lookups with a lower priority run first. Quality lookups decide whether a proof is needed at all, and are only a
+# few reads, so they go before full proof lookups, which are about 64 reads each
+PRIORITY_QUALITIES = 0
+PRIORITY_FULL_PROOF = 1
+
+LOOKUP_KINDS = {PRIORITY_QUALITIES: "qualities", PRIORITY_FULL_PROOF: "full_proof"}
+
+
+@dataclass
+class DeviceQueue:
+    running: int = 0
+    # (priority, sequence number, time queued, future, function, args)
+    pending: List[Tuple[int, int, float, asyncio.Future, Callable, Tuple]] = field(default_factory=list)
+    directories: Set[str] = field(default_factory=set)
+    latencies: Dict[str, Histogram] = field(default_factory=dict)
+    queued: Histogram = field(default_factory=Histogram)
+
+
+def device_name(device: int) -> str:
+    return f"{os.major(device)}:{os.minor(device)}"
+
+
+def max_lookups_per_device(config: Dict) -> int:
+    """
+    max_lookups_per_disk of the harvester config. 0, the default, means num_threads, so the threads are not split up
+    by disk at all. Plots behind mergerfs, FUSE, NFS or any other single mount all share one device, and a lower limit
+    would cap the lookups of every plot at once.
+    """
+    max_per_device = config.get("max_lookups_per_disk", 0)
+    if max_per_device <= 0:
+        return config["num_threads"]
+    return min(max_per_device, config["num_threads"])
+
+
+class LookupScheduler:
+    """
+    Runs blocking plot lookups on a shared executor, with at most max_per_device lookups at a time on each device
+    (st_dev of the plot file). Plots on a slow or busy disk then only wait for each other, instead of taking every
+    thread of the executor away from plots on other disks.
+    """
+
+    def __init__(self, executor: Executor, max_per_device: int):
+        self.executor = executor
+        self.max_per_device = max(max_per_device, 1)
+        self.devices: Dict[int, DeviceQueue] = {}
+        self._sequence = itertools.count()
+
+    async def run(self, device: int, directory: str, priority: int, func: Callable, *args) -> Any:
+        queue = self.devices.get(device)
+        if queue is None:
+            queue = DeviceQueue()
+            self.devices[device] = queue
+        queue.directories.add(directory)
+        future: asyncio.Future = asyncio.get_running_loop().create_future()
+        heapq.heappush(queue.pending, (priority, next(self._sequence), time.monotonic(), future, func, args))
+        self._dispatch(device, queue)
+        return await future
+
+    def _dispatch(self, device: int, queue: DeviceQueue) -> None:
+        loop = asyncio.get_running_loop()
+        while queue.running < self.max_per_device and len(queue.pending) > 0:
+            priority, _, enqueued, future, func, args = heapq.heappop(queue.pending)
+            if future.cancelled():
+                continue
+            queue.running += 1
+
+            def timed_call(func=func, args=args, enqueued=enqueued) -> Tuple[float, float, Any]:
+                started = time.monotonic()
+                result = func(*args)
+                return started - enqueued, time.monotonic() - started, result
+
+            task = loop.run_in_executor(self.executor, timed_call)
+            task.add_done_callback(
+                lambda task, future=future, priority=priority: self._done(device, queue, priority, future, task)
+            )
+
+    def _done(self, device: int, queue: DeviceQueue, priority: int, future: asyncio.Future, task) -> None:
+        queue.running -= 1
+        if task.cancelled():
+            if not future.done():
+                future.cancel()
+        elif task.exception() is not None:
+            if not future.done():
+                future.set_exception(task.exception())
+        else:
+            waited, took, result = task.result()
+            queue.queued.add(waited)
+            kind = LOOKUP_KINDS[priority]
+            if kind not in queue.latencies:
+                queue.latencies[kind] = Histogram()
+            queue.latencies[kind].add(took)
+            if not future.done():
+                future.set_result(result)
+        self._dispatch(device, queue)
+
+    def get_device_stats(self) -> List[Dict]:
+        return [
+            {
+                "device": device_name(device),
+                "directories": sorted(queue.directories),
+                "running": queue.running,
+                "pending": len(queue.pending),
+                "queued": queue.queued.to_json_dict(),
+                "latencies": {kind: histogram.to_json_dict() for kind, histogram in queue.latencies.items()},
+            }
+            for device, queue in self.devices.items()
+        ]
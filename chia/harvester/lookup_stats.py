@@ -0,0 +1,129 @@
+import logging
+import time
+from collections import deque
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Deque, Dict, List, Optional, Set
+
+from chia.util.histogram import RollingHistogram
+
+log = logging.getLogger(__name__)
+
+# Histograms per directory cover the last hour
+STATS_WINDOW_SECONDS = 3600
+# A plot is slow when at least SLOW_FRACTION of its last RECENT_LOOKUPS lookups took longer than the budget
+RECENT_LOOKUPS = 20
+MIN_LOOKUPS = 5
+SLOW_FRACTION = 0.5
+
+
+@dataclass
+class PlotLookupStats:
+    # Total lookup times, from the signage point to the last proof, of the most recent lookups
+    recent: Deque[float] = field(default_factory=lambda: deque(maxlen=RECENT_LOOKUPS))
+    slow: bool = False
+
+    def slow_count(self, budget: float) -> int:
+        return sum(1 for took in self.recent if took > budget)
+
+    def is_slow(self, budget: float) -> bool:
+        return len(self.recent) >= MIN_LOOKUPS and self.slow_count(budget) >= SLOW_FRACTION * len(self.recent)
+
+    def to_json_dict(self, budget: float) -> Dict:
+        return {
+            "lookups": len(self.recent),
+            "slow_lookups": self.slow_count(budget),
+            "mean": sum(self.recent) / len(self.recent) if len(self.recent) > 0 else 0,
+            "max": max(self.recent, default=0),
+        }
+
+
+@dataclass
+class DirectoryLookupStats:
+    qualities: RollingHistogram = field(default_factory=lambda: RollingHistogram(STATS_WINDOW_SECONDS))
+    full_proof: RollingHistogram = field(default_factory=lambda: RollingHistogram(STATS_WINDOW_SECONDS))
+    total: RollingHistogram = field(default_factory=lambda: RollingHistogram(STATS_WINDOW_SECONDS))
+    slow_plots: Set[Path] = field(default_factory=set)
+
+
+class LookupStats:
+    """
+    Timing of the proof lookups of each plot, and histograms per plot directory, for finding plots and drives that
+    are too slow to answer signage points in time. A lookup is slow when it takes longer than budget seconds.
+    """
+
+    def __init__(self, budget: float):
+        self.budget = budget
+        self.plots: Dict[Path, PlotLookupStats] = {}
+        self.directories: Dict[Path, DirectoryLookupStats] = {}
+
+    def add(self, filename: Path, qualities_time: float, full_proof_time: Optional[float], total_time: float) -> None:
+        now = time.time()
+        directory_stats = self.directories.get(filename.parent)
+        if directory_stats is None:
+            directory_stats = DirectoryLookupStats()
+            self.directories[filename.parent] = directory_stats
+        directory_stats.qualities.add(qualities_time, now)
+        if full_proof_time is not None:
+            directory_stats.full_proof.add(full_proof_time, now)
+        directory_stats.total.add(total_time, now)
+
+        plot_stats = self.plots.get(filename)
+        if plot_stats is None:
+            plot_stats = PlotLookupStats()
+            self.plots[filename] = plot_stats
+        plot_stats.recent.append(total_time)
+        slow = plot_stats.is_slow(self.budget)
+        if slow and not plot_stats.slow:
+            log.warning(
+                f"Plot {filename} is slow, {plot_stats.slow_count(self.budget)} of its last {len(plot_stats.recent)} "
+                f"lookups took longer than {self.budget:.2f} seconds. Consider moving it to a faster disk."
+            )
+            directory_stats.slow_plots.add(filename)
+        elif not slow and plot_stats.slow:
+            directory_stats.slow_plots.discard(filename)
+        plot_stats.slow = slow
+
+    def remove_missing(self, filenames: Set[Path]) -> None:
+        """
+        Forgets the plots that are not in filenames, and the directories that none of them are in
+        """
+        for filename in [filename for filename in self.plots.keys() if filename not in filenames]:
+            del self.plots[filename]
+            directory_stats = self.directories.get(filename.parent)
+            if directory_stats is not None:
+                directory_stats.slow_plots.discard(filename)
+        directories = {filename.parent for filename in filenames}
+        for directory in [directory for directory in self.directories.keys() if directory not in directories]:
+            del self.directories[directory]
+
+    def to_json_dict(self) -> Dict:
+        now = time.time()
+        directories: List[Dict] = []
+        for directory, stats in self.directories.items():
+            total = stats.total.histogram(now)
+            directories.append(
+                {
+                    "directory": str(directory),
+                    "qualities": stats.qualities.histogram(now).to_json_dict(),
+                    "full_proof": stats.full_proof.histogram(now).to_json_dict(),
+                    "total": total.to_json_dict(),
+                    "slow_plots": len(stats.slow_plots),
+                    # The typical lookup of the directory is over the budget, not just a few of its plots
+                    "slow": total.count >= MIN_LOOKUPS and total.quantile(0.5) > self.budget,
+                }
+            )
+        return {
+            "budget": self.budget,
+            "window_seconds": STATS_WINDOW_SECONDS,
+            "directories": directories,
+            "slow_plots": {
+                str(filename): stats.to_json_dict(self.budget) for filename, stats in self.plots.items() if stats.slow
+            },
+        }
+
+    def get_plot(self, filename: Path) -> Optional[Dict]:
+        stats = self.plots.get(filename)
+        if stats is None:
+            return None
+        return {**stats.to_json_dict(self.budget), "recent": list(stats.recent), "slow": stats.slow}
@@ -1,21 +1,233 @@
+import json
 import logging
+import os
+import time
 from collections import Counter
+from concurrent.futures import FIRST_COMPLETED, Future, wait
+from concurrent.futures.process import ProcessPoolExecutor
 from pathlib import Path
-from typing import Dict, List
+from typing import Dict, Iterator, List, Optional, Set
 
 from blspy import G1Element
-from chiapos import Verifier
+from chiapos import DiskProver, Verifier
 
 from chia.plotting.plot_tools import find_duplicate_plot_IDs, get_plot_filenames, load_plots, parse_plot_info
 from chia.util.config import load_config
 from chia.util.hash import std_hash
 from chia.util.keychain import Keychain
-from chia.wallet.derive_keys import master_sk_to_farmer_sk, master_sk_to_local_sk
+from chia.wallet.derive_keys import master_sk_to_farmer_sk
 
 log = logging.getLogger(__name__)
 
 
-def check_plots(root_path, num, challenge_start, grep_string, list_duplicates, debug_show_memo):
+def check_plot(filename: str, num_start: int, num_end: int) -> Dict:
+    """
+    Checks one plot with the challenges num_start to num_end. This runs in a worker process, so the plot is opened
+    here and the result is plain data that can be written to json.
+    """
+    result: Dict = {
+        "filename": filename,
+        "file_size": 0,
+        "mtime_ns": 0,
+        "k": 0,
+        "plot_id": None,
+        "farmer_public_key": None,
+        "challenge_start": num_start,
+        "challenge_end": num_end,
+        "qualities": 0,
+        "proofs": 0,
+        "quality_lookup_seconds": 0.0,
+        "proof_lookup_seconds": 0.0,
+        "max_lookup_seconds": 0.0,
+        "valid": False,
+        "error": None,
+    }
+    try:
+        stat_info = os.stat(filename)
+        result["file_size"] = stat_info.st_size
+        result["mtime_ns"] = stat_info.st_mtime_ns
+        pr = DiskProver(filename)
+        result["k"] = pr.get_size()
+        result["plot_id"] = pr.get_id().hex()
+        _, farmer_public_key, _ = parse_plot_info(pr.get_memo())
+        result["farmer_public_key"] = str(farmer_public_key)
+    except Exception as e:
+        result["error"] = f"{type(e)}: {e} error in opening plot {filename}"
+        return result
+
+    v = Verifier()
+    for i in range(num_start, num_end):
+        challenge = std_hash(i.to_bytes(32, "big"))
+        # Some plot errors cause get_qualities_for_challenge to throw a RuntimeError
+        try:
+            start = time.monotonic()
+            quality_strs = pr.get_qualities_for_challenge(challenge)
+            took = time.monotonic() - start
+        except Exception as e:
+            result["error"] = f"{type(e)}: {e} error in getting challenge qualities for plot {filename}"
+            return result
+        result["qualities"] += len(quality_strs)
+        result["quality_lookup_seconds"] += took
+        result["max_lookup_seconds"] = max(result["max_lookup_seconds"], took)
+        for index, quality_str in enumerate(quality_strs):
+            # Other plot errors cause get_full_proof or validate_proof to throw an AssertionError
+            try:
+                start = time.monotonic()
+                proof = pr.get_full_proof(challenge, index)
+                took = time.monotonic() - start
+                result["proofs"] += 1
+                result["proof_lookup_seconds"] += took
+                result["max_lookup_seconds"] = max(result["max_lookup_seconds"], took)
+                ver_quality_str = v.validate_proof(pr.get_id(), pr.get_size(), challenge, proof)
+                assert quality_str == ver_quality_str
+            except Exception as e:
+                result["error"] = f"{type(e)}: {e} error in proving/verifying for plot {filename}"
+                return result
+    result["valid"] = result["proofs"] > 0
+    return result
+
+
+class PlotCheckCheckpoint:
+    """
+    Results of checked plots, one json object per line, appended as soon as each plot is checked. When a run is
+    interrupted, the next run with the same checkpoint skips the plots that were already checked, as long as the
+    plot file did not change and the same challenges are used.
+    """
+
+    def __init__(self, path: Path, num_start: int, num_end: int):
+        self.path = path
+        self.num_start = num_start
+        self.num_end = num_end
+        self.results: Dict[str, Dict] = {}
+
+    def load(self) -> None:
+        if not self.path.exists():
+            return
+        line = ""
+        with open(self.path, "r") as f:
+            for line in f:
+                try:
+                    result = json.loads(line)
+                except json.JSONDecodeError:
+                    # The last line is cut off if the previous run was killed while writing it
+                    continue
+                if result["challenge_start"] == self.num_start and result["challenge_end"] == self.num_end:
+                    self.results[result["filename"]] = result
+        if len(line) > 0 and not line.endswith("\n"):
+            # Ends the cut off line, so that the next result is not appended to it
+            with open(self.path, "a") as f:
+                f.write("\n")
+        log.info(f"Loaded {len(self.results)} checked plots from {self.path}")
+
+    def get(self, filename: Path) -> Optional[Dict]:
+        result = self.results.get(str(filename))
+        if result is None:
+            return None
+        try:
+            stat_info = filename.stat()
+        except OSError:
+            return None
+        if result["file_size"] != stat_info.st_size or result["mtime_ns"] != stat_info.st_mtime_ns:
+            return None
+        return result
+
+    def add(self, result: Dict) -> None:
+        self.results[result["filename"]] = result
+        with open(self.path, "a") as f:
+            f.write(json.dumps(result) + "\n")
+
+
+def run_plot_checks(
+    filenames: List[Path],
+    num_start: int,
+    num_end: int,
+    workers: Optional[int],
+    checkpoint: Optional[PlotCheckCheckpoint],
+) -> Iterator[Dict]:
+    """
+    Checks the plots in worker processes, and yields the result of each plot as it is done. The plots of each disk
+    are checked one at a time, since concurrent lookups on one disk only compete for seeks, while plots on different
+    disks are checked in parallel.
+    """
+    by_device: Dict[int, List[Path]] = {}
+    for filename in sorted(filenames):
+        if checkpoint is not None:
+            result = checkpoint.get(filename)
+            if result is not None:
+                yield result
+                continue
+        try:
+            device = filename.stat().st_dev
+        except OSError:
+            device = 0
+        by_device.setdefault(device, []).append(filename)
+    if len(by_device) == 0:
+        return
+
+    if workers is None:
+        workers = min(len(by_device), os.cpu_count() or 1)
+    log.info(f"Checking {sum(len(paths) for paths in by_device.values())} plots on {len(by_device)} disks")
+    with ProcessPoolExecutor(max_workers=max(workers, 1)) as executor:
+        running: Dict[Future, int] = {}
+
+        def check_next(device: int) -> None:
+            if len(by_device[device]) > 0:
+                filename = by_device[device].pop(0)
+                running[executor.submit(check_plot, str(filename), num_start, num_end)] = device
+
+        try:
+            for device in by_device.keys():
+                check_next(device)
+            while len(running) > 0:
+                done, _ = wait(running.keys(), return_when=FIRST_COMPLETED)
+                for future in done:
+                    device = running.pop(future)
+                    result = future.result()
+                    if checkpoint is not None:
+                        checkpoint.add(result)
+                    yield result
+                    check_next(device)
+        except BaseException:
+            # Don't start checking the plots that are still queued
+            for future in running.keys():
+                future.cancel()
+            raise
+
+
+def write_results(
+    path: Path,
+    results: List[Dict],
+    num_start: int,
+    num_end: int,
+    failed_to_open_filenames: Dict[Path, int],
+    no_key_filenames: Set[Path],
+) -> None:
+    with open(path, "w") as f:
+        json.dump(
+            {
+                "challenge_start": num_start,
+                "challenge_end": num_end,
+                "plots": results,
+                "failed_to_open": [str(filename) for filename in failed_to_open_filenames.keys()],
+                "no_key": [str(filename) for filename in no_key_filenames],
+            },
+            f,
+            indent=2,
+        )
+    log.info(f"Wrote results of {len(results)} plots to {path}")
+
+
+def check_plots(
+    root_path,
+    num,
+    challenge_start,
+    grep_string,
+    list_duplicates,
+    debug_show_memo,
+    workers: Optional[int] = None,
+    checkpoint_path: Optional[str] = None,
+    json_output: Optional[str] = None,
+):
     config = load_config(root_path, "config.yaml")
     if num is not None:
         if num == 0:
@@ -57,7 +269,6 @@ def check_plots(root_path, num, challenge_start, grep_string, list_duplicates, d
     if num == 0:
         return
 
-    v = Verifier()
     log.info("Loading plots in config.yaml using plot_tools loading code\n")
     kc: Keychain = Keychain()
     pks = [master_sk_to_farmer_sk(sk).get_g1() for sk, _ in kc.get_all_private_keys()]
@@ -81,55 +292,42 @@ def check_plots(root_path, num, challenge_start, grep_string, list_duplicates, d
     total_size = 0
     bad_plots_list: List[Path] = []
 
-    for plot_path, plot_info in provers.items():
-        pr = plot_info.prover
-        log.info(f"Testing plot {plot_path} k={pr.get_size()}")
-        log.info(f"\tPool public key: {plot_info.pool_public_key}")
-
-        # Look up local_sk from plot to save locked memory
-        (
-            pool_public_key_or_puzzle_hash,
-            farmer_public_key,
-            local_master_sk,
-        ) = parse_plot_info(pr.get_memo())
-        local_sk = master_sk_to_local_sk(local_master_sk)
-        log.info(f"\tFarmer public key: {farmer_public_key}")
-        log.info(f"\tLocal sk: {local_sk}")
-        total_proofs = 0
-        caught_exception: bool = False
-        for i in range(num_start, num_end):
-            challenge = std_hash(i.to_bytes(32, "big"))
-            # Some plot errors cause get_qualities_for_challenge to throw a RuntimeError
-            try:
-                for index, quality_str in enumerate(pr.get_qualities_for_challenge(challenge)):
-                    # Other plot errors cause get_full_proof or validate_proof to throw an AssertionError
-                    try:
-                        proof = pr.get_full_proof(challenge, index)
-                        total_proofs += 1
-                        ver_quality_str = v.validate_proof(pr.get_id(), pr.get_size(), challenge, proof)
-                        assert quality_str == ver_quality_str
-                    except AssertionError as e:
-                        log.error(f"{type(e)}: {e} error in proving/verifying for plot {plot_path}")
-                        caught_exception = True
-            except KeyboardInterrupt:
-                log.warning("Interrupted, closing")
-                return
-            except SystemExit:
-                log.warning("System is shutting down.")
-                return
-            except Exception as e:
-                log.error(f"{type(e)}: {e} error in getting challenge qualities for plot {plot_path}")
-                caught_exception = True
-            if caught_exception is True:
-                break
-        if total_proofs > 0 and caught_exception is False:
-            log.info(f"\tProofs {total_proofs} / {challenges}, {round(total_proofs/float(challenges), 4)}")
-            total_good_plots[pr.get_size()] += 1
-            total_size += plot_path.stat().st_size
-        else:
-            total_bad_plots += 1
-            log.error(f"\tProofs {total_proofs} / {challenges}, {round(total_proofs/float(challenges), 4)}")
-            bad_plots_list.append(plot_path)
+    checkpoint: Optional[PlotCheckCheckpoint] = None
+    if checkpoint_path is not None:
+        checkpoint = PlotCheckCheckpoint(Path(checkpoint_path), num_start, num_end)
+        checkpoint.load()
+    results: List[Dict] = []
+    interrupted = False
+    try:
+        for result in run_plot_checks(list(provers.keys()), num_start, num_end, workers, checkpoint):
+            results.append(result)
+            plot_path = Path(result["filename"])
+            log.info(f"Testing plot {plot_path} k={result['k']}")
+            log.info(f"\tPool public key: {provers[plot_path].pool_public_key}")
+            log.info(f"\tFarmer public key: {result['farmer_public_key']}")
+            log.info(
+                f"\tLookup time: {result['quality_lookup_seconds']:.3f}s qualities, "
+                f"{result['proof_lookup_seconds']:.3f}s proofs"
+            )
+            if result["error"] is not None:
+                log.error(f"\t{result['error']}")
+            if result["valid"]:
+                log.info(f"\tProofs {result['proofs']} / {challenges}, {round(result['proofs']/float(challenges), 4)}")
+                total_good_plots[result["k"]] += 1
+                total_size += result["file_size"]
+            else:
+                total_bad_plots += 1
+                log.error(f"\tProofs {result['proofs']} / {challenges}, {round(result['proofs']/float(challenges), 4)}")
+                bad_plots_list.append(plot_path)
+    except KeyboardInterrupt:
+        log.warning("Interrupted, closing")
+        interrupted = True
+    if json_output is not None:
+        write_results(Path(json_output), results, num_start, num_end, failed_to_open_filenames, no_key_filenames)
+    if interrupted:
+        if checkpoint is not None:
+            log.warning(f"Run again with the same checkpoint {checkpoint_path} to continue")
+        return
     log.info("")
     log.info("")
     log.info("Summary")
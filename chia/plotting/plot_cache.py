@@ -0,0 +1,138 @@
+import logging
+import os
+import threading
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Dict, List, Optional, Set
+
+from blspy import G1Element
+from chiapos import DiskProver
+
+from chia.types.blockchain_format.sized_bytes import bytes32
+from chia.util.ints import uint8, uint64
+from chia.util.path import mkdir
+from chia.util.streamable import Streamable, streamable
+
+log = logging.getLogger(__name__)
+
+PLOT_CACHE_VERSION = 1
+
+
+@dataclass(frozen=True)
+@streamable
+class PlotCacheEntry(Streamable):
+    filename: str
+    file_size: uint64
+    mtime_ns: uint64
+    plot_id: bytes32
+    k: uint8
+    pool_public_key: Optional[G1Element]
+    pool_contract_puzzle_hash: Optional[bytes32]
+    farmer_public_key: G1Element
+    plot_public_key: G1Element
+
+
+@dataclass(frozen=True)
+@streamable
+class PlotCacheData(Streamable):
+    version: uint8
+    entries: List[PlotCacheEntry]
+
+
+class CachedDiskProver:
+    """
+    Stands in for the DiskProver of a plot that was loaded from the plot cache. The plot id and size come from the
+    cache, the plot file is only opened once qualities, proofs or the memo are needed.
+    """
+
+    def __init__(self, filename: str, plot_id: bytes32, k: uint8):
+        self._filename = filename
+        self._plot_id = plot_id
+        self._k = k
+        self._prover: Optional[DiskProver] = None
+        self._lock = threading.Lock()
+
+    def _get_prover(self) -> DiskProver:
+        with self._lock:
+            if self._prover is None:
+                prover = DiskProver(self._filename)
+                if prover.get_id() != self._plot_id:
+                    raise ValueError(f"Plot {self._filename} does not match its cache entry")
+                self._prover = prover
+            return self._prover
+
+    def get_filename(self) -> str:
+        return self._filename
+
+    def get_id(self) -> bytes32:
+        return self._plot_id
+
+    def get_size(self) -> uint8:
+        return self._k
+
+    def get_memo(self) -> bytes:
+        return self._get_prover().get_memo()
+
+    def get_qualities_for_challenge(self, challenge: bytes32) -> List[bytes32]:
+        return self._get_prover().get_qualities_for_challenge(challenge)
+
+    def get_full_proof(self, challenge: bytes32, index: int) -> bytes:
+        return self._get_prover().get_full_proof(challenge, index)
+
+
+class PlotCache:
+    """
+    Keeps what load_plots learns from opening a plot file, keyed by path, size and modification time, so that
+    unchanged plots can be loaded without reading them again.
+    """
+
+    def __init__(self, path: Path):
+        self.path = path
+        self.entries: Dict[str, PlotCacheEntry] = {}
+        self.changed = False
+        self.lock = threading.Lock()
+
+    def load(self) -> None:
+        if not self.path.exists():
+            return
+        try:
+            data = PlotCacheData.from_bytes(self.path.read_bytes())
+        except Exception as e:
+            log.warning(f"Failed to load plot cache {self.path}, starting with an empty one. {e}")
+            return
+        if data.version != PLOT_CACHE_VERSION:
+            log.info(f"Ignoring plot cache {self.path} with version {data.version}")
+            return
+        self.entries = {entry.filename: entry for entry in data.entries}
+        log.info(f"Loaded {len(self.entries)} entries from plot cache {self.path}")
+
+    def save(self) -> None:
+        with self.lock:
+            if not self.changed:
+                return
+            data = PlotCacheData(uint8(PLOT_CACHE_VERSION), list(self.entries.values()))
+            self.changed = False
+        try:
+            mkdir(self.path.parent)
+            tmp_path = self.path.with_suffix(".tmp")
+            tmp_path.write_bytes(bytes(data))
+            os.replace(tmp_path, self.path)
+        except Exception as e:
+            log.error(f"Failed to save plot cache {self.path}. {e}")
+
+    def get(self, filename: Path, stat_info: os.stat_result) -> Optional[PlotCacheEntry]:
+        entry = self.entries.get(str(filename))
+        if entry is None or entry.file_size != stat_info.st_size or entry.mtime_ns != stat_info.st_mtime_ns:
+            return None
+        return entry
+
+    def put(self, entry: PlotCacheEntry) -> None:
+        with self.lock:
+            self.entries[entry.filename] = entry
+            self.changed = True
+
+    def remove_missing(self, filenames: Set[str]) -> None:
+        with self.lock:
+            for filename in [filename for filename in self.entries.keys() if filename not in filenames]:
+                del self.entries[filename]
+                self.changed = True
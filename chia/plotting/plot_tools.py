@@ -12,9 +12,11 @@ from blspy import G1Element, PrivateKey
 from chiapos import DiskProver
 
 from chia.consensus.pos_quality import UI_ACTUAL_SPACE_CONSTANT_FACTOR, _expected_plot_size
+from chia.plotting.plot_cache import CachedDiskProver, PlotCache, PlotCacheEntry
 from chia.types.blockchain_format.proof_of_space import ProofOfSpace
 from chia.types.blockchain_format.sized_bytes import bytes32
 from chia.util.config import load_config, save_config
+from chia.util.ints import uint8, uint64
 from chia.wallet.derive_keys import master_sk_to_local_sk
 
 log = logging.getLogger(__name__)
@@ -22,12 +24,19 @@ log = logging.getLogger(__name__)
 
 @dataclass
 class PlotInfo:
-    prover: DiskProver
+    prover: Union[DiskProver, CachedDiskProver]
     pool_public_key: Optional[G1Element]
     pool_contract_puzzle_hash: Optional[bytes32]
     plot_public_key: G1Element
     file_size: int
     time_modified: float
+    # Device the plot file is on, lookups are scheduled per device
+    device: int = 0
+
+
+def is_plot_filename(path: Path) -> bool:
+    # Files ending in .plot, working around MacOS ._ files
+    return path.suffix == ".plot" and not path.name.startswith("._")
 
 
 def _get_filenames(directory: Path) -> List[Path]:
@@ -42,8 +51,7 @@ def _get_filenames(directory: Path) -> List[Path]:
     try:
         for child in directory.iterdir():
             if not child.is_dir():
-                # If it is a file ending in .plot, add it - work around MacOS ._ files
-                if child.suffix == ".plot" and not child.name.startswith("._"):
+                if is_plot_filename(child):
                     all_files.append(child)
             else:
                 log.info(f"Not checking subdirectory {child}, subdirectories not added by default")
@@ -144,17 +152,25 @@ def load_plots(
     show_memo: bool,
     root_path: Path,
     open_no_key_filenames=False,
+    plot_cache: Optional[PlotCache] = None,
+    filenames: Optional[List[Path]] = None,
 ) -> Tuple[bool, Dict[Path, PlotInfo], Dict[Path, int], Set[Path]]:
+    """
+    Loads all plots in the plot directories, or only the given filenames, in which case the returned provers only
+    contain those plots.
+    """
     start_time = time.time()
-    config_file = load_config(root_path, "config.yaml", "harvester")
     changed = False
     no_key_filenames: Set[Path] = set()
-    log.info(f'Searching directories {config_file["plot_directories"]}')
-
-    plot_filenames: Dict[Path, List[Path]] = get_plot_filenames(config_file)
     all_filenames: List[Path] = []
-    for paths in plot_filenames.values():
-        all_filenames += paths
+    if filenames is not None:
+        all_filenames = filenames
+    else:
+        config_file = load_config(root_path, "config.yaml", "harvester")
+        log.info(f'Searching directories {config_file["plot_directories"]}')
+        plot_filenames: Dict[Path, List[Path]] = get_plot_filenames(config_file)
+        for paths in plot_filenames.values():
+            all_filenames += paths
     plot_ids: Set[bytes32] = set()
     plot_ids_lock = threading.Lock()
 
@@ -186,26 +202,64 @@ def load_plots(
                     new_provers[filename] = provers[filename]
                     return stat_info.st_size, new_provers
             try:
-                prover = DiskProver(str(filename))
-
-                expected_size = _expected_plot_size(prover.get_size()) * UI_ACTUAL_SPACE_CONSTANT_FACTOR
                 stat_info = filename.stat()
+                cache_entry: Optional[PlotCacheEntry] = None
+                if plot_cache is not None:
+                    cache_entry = plot_cache.get(filename, stat_info)
+                local_master_sk: Optional[PrivateKey] = None
+                prover: Union[DiskProver, CachedDiskProver]
+                if cache_entry is not None:
+                    # Unchanged since it was last opened, the plot file is not read until it is needed
+                    prover = CachedDiskProver(filename_str, cache_entry.plot_id, cache_entry.k)
+                    pool_public_key = cache_entry.pool_public_key
+                    pool_contract_puzzle_hash = cache_entry.pool_contract_puzzle_hash
+                    farmer_public_key = cache_entry.farmer_public_key
+                    plot_public_key: G1Element = cache_entry.plot_public_key
+                else:
+                    prover = DiskProver(str(filename))
 
-                # TODO: consider checking if the file was just written to (which would mean that the file is still
-                # being copied). A segfault might happen in this edge case.
+                    expected_size = _expected_plot_size(prover.get_size()) * UI_ACTUAL_SPACE_CONSTANT_FACTOR
 
-                if prover.get_size() >= 30 and stat_info.st_size < 0.98 * expected_size:
-                    log.warning(
-                        f"Not farming plot {filename}. Size is {stat_info.st_size / (1024**3)} GiB, but expected"
-                        f" at least: {expected_size / (1024 ** 3)} GiB. We assume the file is being copied."
-                    )
-                    return 0, new_provers
+                    # TODO: consider checking if the file was just written to (which would mean that the file is
+                    # still being copied). A segfault might happen in this edge case.
 
-                (
-                    pool_public_key_or_puzzle_hash,
-                    farmer_public_key,
-                    local_master_sk,
-                ) = parse_plot_info(prover.get_memo())
+                    if prover.get_size() >= 30 and stat_info.st_size < 0.98 * expected_size:
+                        log.warning(
+                            f"Not farming plot {filename}. Size is {stat_info.st_size / (1024**3)} GiB, but expected"
+                            f" at least: {expected_size / (1024 ** 3)} GiB. We assume the file is being copied."
+                        )
+                        return 0, new_provers
+
+                    (
+                        pool_public_key_or_puzzle_hash,
+                        farmer_public_key,
+                        local_master_sk,
+                    ) = parse_plot_info(prover.get_memo())
+
+                    if isinstance(pool_public_key_or_puzzle_hash, G1Element):
+                        pool_public_key = pool_public_key_or_puzzle_hash
+                        pool_contract_puzzle_hash = None
+                    else:
+                        assert isinstance(pool_public_key_or_puzzle_hash, bytes32)
+                        pool_public_key = None
+                        pool_contract_puzzle_hash = pool_public_key_or_puzzle_hash
+
+                    local_sk = master_sk_to_local_sk(local_master_sk)
+                    plot_public_key = ProofOfSpace.generate_plot_public_key(local_sk.get_g1(), farmer_public_key)
+                    if plot_cache is not None:
+                        plot_cache.put(
+                            PlotCacheEntry(
+                                filename_str,
+                                uint64(stat_info.st_size),
+                                uint64(stat_info.st_mtime_ns),
+                                prover.get_id(),
+                                uint8(prover.get_size()),
+                                pool_public_key,
+                                pool_contract_puzzle_hash,
+                                farmer_public_key,
+                                plot_public_key,
+                            )
+                        )
 
                 # Only use plots that correct keys associated with them
                 if farmer_public_keys is not None and farmer_public_key not in farmer_public_keys:
@@ -214,14 +268,6 @@ def load_plots(
                     if not open_no_key_filenames:
                         return 0, new_provers
 
-                if isinstance(pool_public_key_or_puzzle_hash, G1Element):
-                    pool_public_key = pool_public_key_or_puzzle_hash
-                    pool_contract_puzzle_hash = None
-                else:
-                    assert isinstance(pool_public_key_or_puzzle_hash, bytes32)
-                    pool_public_key = None
-                    pool_contract_puzzle_hash = pool_public_key_or_puzzle_hash
-
                 if (
                     pool_public_keys is not None
                     and pool_public_key is not None
@@ -232,10 +278,6 @@ def load_plots(
                     if not open_no_key_filenames:
                         return 0, new_provers
 
-                stat_info = filename.stat()
-                local_sk = master_sk_to_local_sk(local_master_sk)
-                plot_public_key: G1Element = ProofOfSpace.generate_plot_public_key(local_sk.get_g1(), farmer_public_key)
-
                 with plot_ids_lock:
                     if prover.get_id() in plot_ids:
                         log.warning(f"Have multiple copies of the plot {filename}, not adding it.")
@@ -249,6 +291,7 @@ def load_plots(
                     plot_public_key,
                     stat_info.st_size,
                     stat_info.st_mtime,
+                    stat_info.st_dev,
                 )
 
                 changed = True
@@ -261,6 +304,8 @@ def load_plots(
 
             if show_memo:
                 plot_memo: bytes32
+                if local_master_sk is None:
+                    _, _, local_master_sk = parse_plot_info(prover.get_memo())
                 if pool_contract_puzzle_hash is None:
                     plot_memo = stream_plot_info_pk(pool_public_key, farmer_public_key, local_master_sk)
                 else:
@@ -280,6 +325,11 @@ def load_plots(
         initial_value: Tuple[int, Dict[Path, PlotInfo]] = (0, {})
         total_size, new_provers = reduce(reduce_function, executor.map(process_file, all_filenames), initial_value)
 
+    if plot_cache is not None:
+        if filenames is None:
+            plot_cache.remove_missing({str(filename) for filename in all_filenames})
+        plot_cache.save()
+
     log.info(
         f"Loaded a total of {len(new_provers)} plots of size {total_size / (1024 ** 4)} TiB, in"
         f" {time.time()-start_time} seconds"
@@ -0,0 +1,140 @@
+import asyncio
+import ctypes
+import ctypes.util
+import logging
+import os
+import struct
+import sys
+from pathlib import Path
+from typing import Callable, Dict, List, Optional, Set
+
+from chia.plotting.plot_tools import is_plot_filename
+
+log = logging.getLogger(__name__)
+
+# See inotify(7)
+IN_CLOSE_WRITE = 0x00000008
+IN_MOVED_FROM = 0x00000040
+IN_MOVED_TO = 0x00000080
+IN_DELETE = 0x00000200
+IN_DELETE_SELF = 0x00000400
+IN_MOVE_SELF = 0x00000800
+IN_Q_OVERFLOW = 0x00004000
+IN_IGNORED = 0x00008000
+IN_ONLYDIR = 0x01000000
+
+# Plots are only picked up once they are completely written or moved in, not when they are created
+WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR
+
+# struct inotify_event { int wd; uint32_t mask; uint32_t cookie; uint32_t len; char name[]; }
+EVENT_HEADER = struct.Struct("iIII")
+READ_SIZE = 64 * 1024
+
+# Called with the added plot files, the removed plot files, and whether a full rescan is needed
+PlotChangeCallback = Callable[[Set[Path], Set[Path], bool], None]
+
+
+class PlotDirectoryWatcher:
+    """
+    Reports plot files that are added to, removed from, or renamed within the plot directories, using inotify. This is
+    only available on Linux, create returns None when inotify can't be used and the plot directories have to be
+    scanned periodically instead. Changes made on another machine to a network mount are not reported.
+    """
+
+    def __init__(self, libc: ctypes.CDLL, fd: int, callback: PlotChangeCallback):
+        self.libc = libc
+        self.fd = fd
+        self.callback = callback
+        self.directories: Dict[int, Path] = {}
+        self.started = False
+
+    @staticmethod
+    def create(callback: PlotChangeCallback) -> Optional["PlotDirectoryWatcher"]:
+        if not sys.platform.startswith("linux"):
+            return None
+        try:
+            libc = ctypes.CDLL(ctypes.util.find_library("c"), use_errno=True)
+            libc.inotify_init1.argtypes = [ctypes.c_int]
+            libc.inotify_add_watch.argtypes = [ctypes.c_int, ctypes.c_char_p, ctypes.c_uint32]
+            libc.inotify_rm_watch.argtypes = [ctypes.c_int, ctypes.c_int]
+            fd = libc.inotify_init1(os.O_NONBLOCK | os.O_CLOEXEC)
+        except (OSError, AttributeError) as e:
+            log.info(f"Can't watch the plot directories, they will be scanned periodically. {e}")
+            return None
+        if fd < 0:
+            log.info(f"Can't watch the plot directories: {os.strerror(ctypes.get_errno())}")
+            return None
+        return PlotDirectoryWatcher(libc, fd, callback)
+
+    def watch(self, directories: List[Path]) -> None:
+        """
+        Watches exactly the given directories. Directories that can't be watched yet, for example because they don't
+        exist, are tried again on the next call.
+        """
+        watched: Set[Path] = set(self.directories.values())
+        for directory in directories:
+            if directory in watched:
+                continue
+            wd = self.libc.inotify_add_watch(self.fd, os.fsencode(directory), WATCH_MASK)
+            if wd < 0:
+                log.warning(f"Can't watch plot directory {directory}: {os.strerror(ctypes.get_errno())}")
+                continue
+            self.directories[wd] = directory
+        for wd, directory in list(self.directories.items()):
+            if directory not in directories:
+                self.libc.inotify_rm_watch(self.fd, wd)
+                del self.directories[wd]
+
+    def start(self) -> None:
+        asyncio.get_running_loop().add_reader(self.fd, self._read_events)
+        self.started = True
+
+    def close(self) -> None:
+        if self.started:
+            asyncio.get_event_loop().remove_reader(self.fd)
+            self.started = False
+        os.close(self.fd)
+
+    def _read_events(self) -> None:
+        try:
+            data = os.read(self.fd, READ_SIZE)
+        except BlockingIOError:
+            return
+        added, removed, rescan = self.parse_events(data)
+        if len(added) > 0 or len(removed) > 0 or rescan:
+            self.callback(added, removed, rescan)
+
+    def parse_events(self, data: bytes):
+        added: Set[Path] = set()
+        removed: Set[Path] = set()
+        rescan = False
+        offset = 0
+        while offset + EVENT_HEADER.size <= len(data):
+            wd, mask, _, length = EVENT_HEADER.unpack_from(data, offset)
+            name = data[offset + EVENT_HEADER.size : offset + EVENT_HEADER.size + length].rstrip(b"\0")
+            offset += EVENT_HEADER.size + length
+            if mask & IN_Q_OVERFLOW:
+                # Events were dropped, only a rescan can tell what changed
+                rescan = True
+                continue
+            directory = self.directories.get(wd)
+            if directory is None:
+                continue
+            if mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF):
+                # The directory itself is gone, or was unmounted
+                log.warning(f"Plot directory {directory} was removed or moved")
+                if not mask & IN_IGNORED:
+                    self.libc.inotify_rm_watch(self.fd, wd)
+                del self.directories[wd]
+                rescan = True
+                continue
+            path = directory / os.fsdecode(name)
+            if len(name) == 0 or not is_plot_filename(path):
+                continue
+            if mask & (IN_CLOSE_WRITE | IN_MOVED_TO):
+                removed.discard(path)
+                added.add(path)
+            elif mask & (IN_MOVED_FROM | IN_DELETE):
+                added.discard(path)
+                removed.add(path)
+        return added, removed, rescan
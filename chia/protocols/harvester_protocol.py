@@ -59,3 +59,36 @@ class RespondSignatures(Streamable):
     local_pk: G1Element
     farmer_pk: G1Element
     message_signatures: List[Tuple[bytes32, G2Element]]
+
+
+@dataclass(frozen=True)
+@streamable
+class RequestSignaturesBatch(Streamable):
+    requests: List[RequestSignatures]
+
+
+@dataclass(frozen=True)
+@streamable
+class RespondSignaturesBatch(Streamable):
+    responses: List[RespondSignatures]
+
+
+@dataclass(frozen=True)
+@streamable
+class NewQualityHarvester(Streamable):
+    challenge_hash: bytes32
+    sp_hash: bytes32
+    plot_identifier: str
+    quality_index: uint8
+    required_iters: uint64
+    signage_point_index: uint8
+
+
+@dataclass(frozen=True)
+@streamable
+class RequestProofOfSpace(Streamable):
+    challenge_hash: bytes32
+    sp_hash: bytes32
+    plot_identifier: str
+    quality_index: uint8
+    signage_point_index: uint8
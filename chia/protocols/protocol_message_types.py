@@ -81,3 +81,11 @@ class ProtocolMessageTypes(Enum):
 
     # Simulator protocol
     farm_new_block = 65
+
+    # Harvester protocol, with Capability.QUALITY_ANNOUNCE
+    new_quality_harvester = 66
+    request_proof_of_space = 67
+
+    # Harvester protocol, with Capability.BATCH_SIGNATURES
+    request_signatures_batch = 68
+    respond_signatures_batch = 69
@@ -5,7 +5,7 @@ from typing import List, Tuple
 from chia.util.ints import uint8, uint16
 from chia.util.streamable import Streamable, streamable
 
-protocol_version = "0.0.32"
+protocol_version = "0.0.35"
 
 """
 Handshake when establishing a connection between two servers.
@@ -17,6 +17,10 @@ Note: When changing this file, also change protocol_message_types.py
 # These are passed in as uint16 into the Handshake
 class Capability(IntEnum):
     BASE = 1  # Base capability just means it supports the chia protocol at mainnet
+    COMPRESSION = 2  # Supports compressed message payloads, value is a comma separated list of codecs
+    QUALITY_ANNOUNCE = 3  # Harvester announces qualities, and the farmer requests the full proofs it wants
+    BATCH_SIGNATURES = 4  # Farmer sends the signature requests of one signage point to a harvester in one message
+    BLUEBOX_LEASES = 5  # Full node gives each bluebox its own uncompact VDFs, instead of the same ones to all of them
 
 
 @dataclass(frozen=True)
@@ -14,6 +14,8 @@ class FarmerRpcApi:
         return {
             "/get_signage_point": self.get_signage_point,
             "/get_signage_points": self.get_signage_points,
+            "/get_signage_point_counters": self.get_signage_point_counters,
+            "/get_declare_proof_latency": self.get_declare_proof_latency,
             "/get_reward_targets": self.get_reward_targets,
             "/set_reward_targets": self.set_reward_targets,
         }
@@ -43,10 +45,10 @@ class FarmerRpcApi:
 
     async def get_signage_point(self, request: Dict) -> Dict:
         sp_hash = hexstr_to_bytes(request["sp_hash"])
-        for _, sps in self.service.sps.items():
-            for sp in sps:
+        for _, sp_state in self.service.sp_store.states.items():
+            for sp in sp_state.sps:
                 if sp.challenge_chain_sp == sp_hash:
-                    pospaces = self.service.proofs_of_space.get(sp.challenge_chain_sp, [])
+                    pospaces = sp_state.proofs_of_space
                     return {
                         "signage_point": {
                             "challenge_hash": sp.challenge_hash,
@@ -62,9 +64,9 @@ class FarmerRpcApi:
 
     async def get_signage_points(self, _: Dict) -> Dict:
         result: List = []
-        for _, sps in self.service.sps.items():
-            for sp in sps:
-                pospaces = self.service.proofs_of_space.get(sp.challenge_chain_sp, [])
+        for _, sp_state in self.service.sp_store.states.items():
+            for sp in sp_state.sps:
+                pospaces = sp_state.proofs_of_space
                 result.append(
                     {
                         "signage_point": {
@@ -80,6 +82,12 @@ class FarmerRpcApi:
                 )
         return {"signage_points": result}
 
+    async def get_signage_point_counters(self, _: Dict) -> Dict:
+        return {"counters": self.service.sp_store.get_counters()}
+
+    async def get_declare_proof_latency(self, _: Dict) -> Dict:
+        return {"latency": self.service.declare_proof_latency.to_json_dict()}
+
     async def get_reward_targets(self, request: Dict) -> Dict:
         search_for_private_key = request["search_for_private_key"]
         return self.service.get_reward_targets(search_for_private_key)
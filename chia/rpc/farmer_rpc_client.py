@@ -22,6 +22,12 @@ class FarmerRpcClient(RpcClient):
     async def get_signage_points(self) -> List[Dict]:
         return (await self.fetch("get_signage_points", {}))["signage_points"]
 
+    async def get_signage_point_counters(self) -> Dict:
+        return (await self.fetch("get_signage_point_counters", {}))["counters"]
+
+    async def get_declare_proof_latency(self) -> Dict:
+        return (await self.fetch("get_declare_proof_latency", {}))["latency"]
+
     async def get_reward_targets(self, search_for_private_key: bool) -> Dict:
         response = await self.fetch("get_reward_targets", {"search_for_private_key": search_for_private_key})
         return_dict = {
@@ -72,6 +72,9 @@ class FullNodeRpcClient(RpcClient):
             return None
         return network_space_bytes_estimate["space"]
 
+    async def get_bluebox_stats(self) -> Dict:
+        return (await self.fetch("get_bluebox_stats", {}))["bluebox_stats"]
+
     async def get_coin_records_by_puzzle_hash(
         self,
         puzzle_hash: bytes32,
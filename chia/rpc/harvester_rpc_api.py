@@ -1,3 +1,4 @@
+from pathlib import Path
 from typing import Callable, Dict, List
 
 from chia.harvester.harvester import Harvester
@@ -17,6 +18,8 @@ class HarvesterRpcApi:
             "/add_plot_directory": self.add_plot_directory,
             "/get_plot_directories": self.get_plot_directories,
             "/remove_plot_directory": self.remove_plot_directory,
+            "/get_disk_latencies": self.get_disk_latencies,
+            "/get_lookup_stats": self.get_lookup_stats,
         }
 
     async def _state_changed(self, change: str) -> List[WsRpcMessage]:
@@ -59,3 +62,14 @@ class HarvesterRpcApi:
         if await self.service.remove_plot_directory(directory_name):
             return {}
         raise ValueError(f"Did not remove plot directory {directory_name}")
+
+    async def get_disk_latencies(self, request: Dict) -> Dict:
+        return {"disks": self.service.lookup_scheduler.get_device_stats()}
+
+    async def get_lookup_stats(self, request: Dict) -> Dict:
+        if "filename" in request:
+            plot_stats = self.service.lookup_stats.get_plot(Path(request["filename"]).resolve())
+            if plot_stats is None:
+                raise ValueError(f"No lookups for plot {request['filename']}")
+            return {"plot": plot_stats}
+        return {"stats": self.service.lookup_stats.to_json_dict()}
@@ -29,3 +29,12 @@ class HarvesterRpcClient(RpcClient):
 
     async def remove_plot_directory(self, dirname: str) -> bool:
         return (await self.fetch("remove_plot_directory", {"dirname": dirname}))["success"]
+
+    async def get_disk_latencies(self) -> List[Dict[str, Any]]:
+        return (await self.fetch("get_disk_latencies", {}))["disks"]
+
+    async def get_lookup_stats(self) -> Dict[str, Any]:
+        return (await self.fetch("get_lookup_stats", {}))["stats"]
+
+    async def get_plot_lookup_stats(self, filename: str) -> Dict[str, Any]:
+        return (await self.fetch("get_lookup_stats", {"filename": filename}))["plot"]
@@ -57,6 +57,9 @@ class RpcClient:
     async def close_connection(self, node_id: bytes32) -> Dict:
         return await self.fetch("close_connection", {"node_id": node_id.hex()})
 
+    async def get_protocol_metrics(self) -> Dict:
+        return (await self.fetch("get_protocol_metrics", {}))["protocol_metrics"]
+
     async def stop_node(self) -> Dict:
         return await self.fetch("stop_node", {})
 
@@ -148,6 +148,21 @@ class RpcServer:
             ]
         return {"connections": con_info}
 
+    async def get_protocol_metrics(self, request: Dict) -> Dict:
+        if self.rpc_api.service.server is None:
+            raise ValueError("Global connections is not set")
+        protocol_metrics = self.rpc_api.service.server.protocol_metrics
+        if protocol_metrics is None:
+            raise ValueError("Protocol metrics are not enabled, set protocol_metrics: True in the config")
+        return {"protocol_metrics": protocol_metrics.to_json_dict()}
+
+    async def prometheus_metrics(self, request) -> aiohttp.web.Response:
+        """
+        Prometheus text endpoint, only registered if protocol metrics are enabled.
+        """
+        protocol_metrics = self.rpc_api.service.server.protocol_metrics
+        return aiohttp.web.Response(text=protocol_metrics.to_prometheus(), content_type="text/plain")
+
     async def open_connection(self, request: Dict):
         host = request["host"]
         port = request["port"]
@@ -326,7 +341,14 @@ async def start_rpc_server(
             rpc_server._wrap_http_handler(rpc_server.close_connection),
         ),
         aiohttp.web.post("/stop_node", rpc_server._wrap_http_handler(rpc_server.stop_node)),
+        aiohttp.web.post(
+            "/get_protocol_metrics",
+            rpc_server._wrap_http_handler(rpc_server.get_protocol_metrics),
+        ),
     ]
+    server = getattr(rpc_api.service, "server", None)
+    if server is not None and server.protocol_metrics is not None:
+        routes.append(aiohttp.web.get("/metrics", rpc_server.prometheus_metrics))
 
     app.add_routes(routes)
     if connect_to_daemon:
@@ -0,0 +1,21 @@
+from typing import Callable, Dict, List
+
+from chia.timelord.timelord import Timelord
+from chia.util.ws_message import WsRpcMessage
+
+
+class TimelordRpcApi:
+    def __init__(self, timelord: Timelord):
+        self.service = timelord
+        self.service_name = "chia_timelord"
+
+    def get_routes(self) -> Dict[str, Callable]:
+        return {
+            "/get_timelord_metrics": self.get_timelord_metrics,
+        }
+
+    async def _state_changed(self, change: str) -> List[WsRpcMessage]:
+        return []
+
+    async def get_timelord_metrics(self, _: Dict) -> Dict:
+        return {"metrics": self.service.get_metrics()}
@@ -0,0 +1,16 @@
+from typing import Dict
+
+from chia.rpc.rpc_client import RpcClient
+
+
+class TimelordRpcClient(RpcClient):
+    """
+    Client to Chia RPC, connects to a local timelord. Uses HTTP/JSON, and converts back from
+    JSON into native python objects before returning. All api calls use POST requests.
+    Note that this is not the same as the peer protocol, or wallet protocol (which run Chia's
+    protocol on top of TCP), it's a separate protocol on top of HTTP thats provides easy access
+    to the timelord.
+    """
+
+    async def get_timelord_metrics(self) -> Dict:
+        return (await self.fetch("get_timelord_metrics", {}))["metrics"]
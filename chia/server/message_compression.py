@@ -0,0 +1,90 @@
+import time
+import zlib
+from enum import IntEnum
+from typing import Optional, Tuple
+
+from chia.protocols.protocol_message_types import ProtocolMessageTypes
+
+"""
+Payload compression for the peer protocol. It is negotiated in the handshake with Capability.COMPRESSION, and once
+both peers support it, the data of every message (after the handshake) starts with one byte specifying the codec.
+Only large messages of the types below are actually compressed, everything else is sent with the NONE codec.
+"""
+
+
+class Codec(IntEnum):
+    NONE = 0
+    ZLIB = 1
+
+
+# Value of the compression capability in the handshake, comma separated list of supported codecs
+SUPPORTED_CODECS = "zlib"
+
+# Messages smaller than this are not worth the CPU time
+COMPRESSION_THRESHOLD = 16 * 1024
+
+# Fast compression level, we are trying to save upload bandwidth without making the node CPU bound
+COMPRESSION_LEVEL = 3
+
+# Same as the max websocket message size. Received payloads are capped lower, at the max size of their message type
+MAX_DECOMPRESSED_SIZE = 50 * 1024 * 1024
+
+COMPRESSIBLE_MESSAGE_TYPES = {
+    ProtocolMessageTypes.respond_proof_of_weight.value,
+    ProtocolMessageTypes.respond_blocks.value,
+    ProtocolMessageTypes.respond_block.value,
+    ProtocolMessageTypes.respond_unfinished_block.value,
+    ProtocolMessageTypes.respond_header_blocks.value,
+    ProtocolMessageTypes.respond_block_header.value,
+    ProtocolMessageTypes.respond_additions.value,
+    ProtocolMessageTypes.respond_removals.value,
+    ProtocolMessageTypes.respond_transaction.value,
+    ProtocolMessageTypes.respond_peers.value,
+}
+
+
+def should_compress(message_type: int, size: int) -> bool:
+    return size >= COMPRESSION_THRESHOLD and message_type in COMPRESSIBLE_MESSAGE_TYPES
+
+
+def compress_payload(data: bytes) -> Tuple[bytes, float]:
+    """
+    Returns the codec byte followed by the compressed data, or by the original data if it does not compress, and the
+    CPU time it took. Meant to be run in an executor, zlib releases the GIL.
+    """
+    start = time.thread_time()
+    compressed = zlib.compress(data, COMPRESSION_LEVEL)
+    if len(compressed) >= len(data):
+        return bytes([Codec.NONE]) + data, time.thread_time() - start
+    return bytes([Codec.ZLIB]) + compressed, time.thread_time() - start
+
+
+def uncompressed_payload(data: bytes) -> bytes:
+    return bytes([Codec.NONE]) + data
+
+
+def is_compressed(data: bytes) -> bool:
+    return len(data) > 0 and data[0] == Codec.ZLIB
+
+
+def decompress_payload(data: bytes, max_size: int = MAX_DECOMPRESSED_SIZE) -> Tuple[Optional[bytes], float]:
+    """
+    Reverses compress_payload and uncompressed_payload, also returning the CPU time it took. Returns None if the data
+    is invalid, or larger than max_size once decompressed. Decompression stops at max_size, so that a decompression
+    bomb never takes more memory than that.
+    """
+    if len(data) == 0:
+        return None, 0
+    if data[0] == Codec.NONE:
+        return data[1:], 0
+    if data[0] != Codec.ZLIB:
+        return None, 0
+    start = time.thread_time()
+    decompressor = zlib.decompressobj()
+    try:
+        result = decompressor.decompress(data[1:], max_size)
+    except zlib.error:
+        return None, time.thread_time() - start
+    if len(decompressor.unconsumed_tail) > 0 or not decompressor.eof:
+        return None, time.thread_time() - start
+    return result, time.thread_time() - start
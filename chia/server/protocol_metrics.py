@@ -0,0 +1,147 @@
+from typing import Dict, List
+
+from chia.protocols.protocol_message_types import ProtocolMessageTypes
+from chia.util.histogram import Histogram
+
+
+class MessageTypeMetrics:
+    def __init__(self):
+        self.messages_received: int = 0
+        self.bytes_received: int = 0
+        self.messages_sent: int = 0
+        self.bytes_sent: int = 0
+        # Time spent in the api function handling a message of this type
+        self.handler_latency: Histogram = Histogram()
+        self.handler_errors: int = 0
+        # Round trip time of requests of this type that we sent with create_request
+        self.request_rtt: Histogram = Histogram()
+        self.request_timeouts: int = 0
+        # Payload compression, only for connections that negotiated it
+        self.uncompressed_bytes_sent: int = 0
+        self.compressed_bytes_sent: int = 0
+        self.compression_seconds: float = 0
+        self.compressed_bytes_received: int = 0
+        self.decompressed_bytes_received: int = 0
+        self.decompression_seconds: float = 0
+
+    def to_json_dict(self) -> Dict:
+        return {
+            "messages_received": self.messages_received,
+            "bytes_received": self.bytes_received,
+            "messages_sent": self.messages_sent,
+            "bytes_sent": self.bytes_sent,
+            "handler_latency": self.handler_latency.to_json_dict(),
+            "handler_errors": self.handler_errors,
+            "request_rtt": self.request_rtt.to_json_dict(),
+            "request_timeouts": self.request_timeouts,
+            "uncompressed_bytes_sent": self.uncompressed_bytes_sent,
+            "compressed_bytes_sent": self.compressed_bytes_sent,
+            "compression_ratio": self.compressed_bytes_sent / self.uncompressed_bytes_sent
+            if self.uncompressed_bytes_sent > 0
+            else None,
+            "compression_seconds": self.compression_seconds,
+            "compressed_bytes_received": self.compressed_bytes_received,
+            "decompressed_bytes_received": self.decompressed_bytes_received,
+            "decompression_seconds": self.decompression_seconds,
+        }
+
+
+class ProtocolMetrics:
+    """
+    Per ProtocolMessageTypes instrumentation of the peer protocol, shared by all the connections of a ChiaServer.
+    This is only created when enabled in the config, connections skip all the bookkeeping when it's None.
+    """
+
+    def __init__(self):
+        self.by_type: Dict[int, MessageTypeMetrics] = {}
+
+    def get(self, message_type: int) -> MessageTypeMetrics:
+        metrics = self.by_type.get(message_type)
+        if metrics is None:
+            metrics = MessageTypeMetrics()
+            self.by_type[message_type] = metrics
+        return metrics
+
+    def message_received(self, message_type: int, size: int) -> None:
+        metrics = self.get(message_type)
+        metrics.messages_received += 1
+        metrics.bytes_received += size
+
+    def message_sent(self, message_type: int, size: int) -> None:
+        metrics = self.get(message_type)
+        metrics.messages_sent += 1
+        metrics.bytes_sent += size
+
+    def handler_finished(self, message_type: int, duration: float, error: bool) -> None:
+        metrics = self.get(message_type)
+        metrics.handler_latency.add(duration)
+        if error:
+            metrics.handler_errors += 1
+
+    def request_finished(self, message_type: int, duration: float, timed_out: bool) -> None:
+        metrics = self.get(message_type)
+        if timed_out:
+            metrics.request_timeouts += 1
+        else:
+            metrics.request_rtt.add(duration)
+
+    def payload_compressed(self, message_type: int, uncompressed: int, compressed: int, cpu_time: float) -> None:
+        metrics = self.get(message_type)
+        metrics.uncompressed_bytes_sent += uncompressed
+        metrics.compressed_bytes_sent += compressed
+        metrics.compression_seconds += cpu_time
+
+    def payload_decompressed(self, message_type: int, compressed: int, decompressed: int, cpu_time: float) -> None:
+        metrics = self.get(message_type)
+        metrics.compressed_bytes_received += compressed
+        metrics.decompressed_bytes_received += decompressed
+        metrics.decompression_seconds += cpu_time
+
+    @staticmethod
+    def _type_name(message_type: int) -> str:
+        try:
+            return ProtocolMessageTypes(message_type).name
+        except ValueError:
+            return f"unknown_{message_type}"
+
+    def to_json_dict(self) -> Dict:
+        return {self._type_name(t): m.to_json_dict() for t, m in sorted(self.by_type.items())}
+
+    def to_prometheus(self) -> str:
+        """
+        Returns the metrics in the Prometheus text exposition format.
+        """
+        counters = [
+            ("messages_received", "Messages received from peers"),
+            ("bytes_received", "Bytes received from peers"),
+            ("messages_sent", "Messages sent to peers"),
+            ("bytes_sent", "Bytes sent to peers"),
+            ("handler_errors", "Api calls that raised an exception"),
+            ("request_timeouts", "Requests to peers that timed out"),
+            ("uncompressed_bytes_sent", "Size of compressed payloads sent, before compression"),
+            ("compressed_bytes_sent", "Size of compressed payloads sent, after compression"),
+            ("compression_seconds", "CPU time spent compressing payloads"),
+            ("compressed_bytes_received", "Size of compressed payloads received, before decompression"),
+            ("decompressed_bytes_received", "Size of compressed payloads received, after decompression"),
+            ("decompression_seconds", "CPU time spent decompressing payloads"),
+        ]
+        lines: List[str] = []
+        items = sorted(self.by_type.items())
+        for field, description in counters:
+            name = f"chia_protocol_{field}_total"
+            lines.append(f"# HELP {name} {description}")
+            lines.append(f"# TYPE {name} counter")
+            for message_type, metrics in items:
+                lines.append(f'{name}{{message_type="{self._type_name(message_type)}"}} {getattr(metrics, field)}')
+        for field, description in [
+            ("handler_latency", "Time spent handling messages from peers"),
+            ("request_rtt", "Round trip time of requests to peers"),
+        ]:
+            name = f"chia_protocol_{field}_seconds"
+            lines.append(f"# HELP {name} {description}")
+            lines.append(f"# TYPE {name} histogram")
+            for message_type, metrics in items:
+                histogram = getattr(metrics, field)
+                if histogram.count > 0:
+                    lines += histogram.prometheus_lines(name, f'message_type="{self._type_name(message_type)}"')
+        return "\n".join(lines) + "\n"
@@ -1,8 +1,7 @@
 import dataclasses
 import logging
 import time
-from collections import Counter
-from typing import Optional
+from typing import Dict, List, Optional
 
 from chia.protocols.protocol_message_types import ProtocolMessageTypes
 from chia.server.outbound_message import Message
@@ -42,6 +41,10 @@ rate_limits_other = {
     ProtocolMessageTypes.new_proof_of_space: RLSettings(100, 2048),
     ProtocolMessageTypes.request_signatures: RLSettings(100, 2048),
     ProtocolMessageTypes.respond_signatures: RLSettings(100, 2048),
+    ProtocolMessageTypes.new_quality_harvester: RLSettings(100, 1024),
+    ProtocolMessageTypes.request_proof_of_space: RLSettings(100, 1024),
+    ProtocolMessageTypes.request_signatures_batch: RLSettings(100, 16 * 1024),
+    ProtocolMessageTypes.respond_signatures_batch: RLSettings(100, 16 * 1024),
     ProtocolMessageTypes.new_signage_point: RLSettings(200, 2048),
     ProtocolMessageTypes.declare_proof_of_space: RLSettings(100, 10 * 1024),
     ProtocolMessageTypes.request_signed_values: RLSettings(100, 512),
@@ -97,6 +100,37 @@ rate_limits_other = {
     ProtocolMessageTypes.farm_new_block: RLSettings(200, 200),
 }
 
+# Largest single non-tx message, the aggregate bucket always has room for at least one of these
+NON_TX_MAX_SIZE = max(settings.max_size for settings in rate_limits_other.values())
+
+
+@dataclasses.dataclass
+class TokenBucket:
+    """
+    A continuously refilling bucket. Tokens are added at fill_rate per second, up to capacity. Incoming limiters are
+    allowed to go into debt (up to one full bucket), since the message was already received, which means an abusive
+    peer has to stay quiet for a while before it is allowed to send again.
+    """
+
+    capacity: float
+    fill_rate: float
+    tokens: float
+    last_update: float
+
+    def refill(self, now: float) -> None:
+        if now > self.last_update:
+            self.tokens = min(self.capacity, self.tokens + (now - self.last_update) * self.fill_rate)
+        self.last_update = now
+
+    def seconds_until(self, amount: float) -> float:
+        missing = amount - self.tokens
+        if missing <= 0:
+            return 0
+        return missing / self.fill_rate
+
+    def consume(self, amount: float) -> None:
+        self.tokens = max(-self.capacity, self.tokens - amount)
+
 
 # TODO: only full node disconnects based on rate limits
 
@@ -104,91 +138,120 @@ rate_limits_other = {
 class RateLimiter:
     incoming: bool
     reset_seconds: int
-    current_minute: int
-    message_counts: Counter
-    message_cumulative_sizes: Counter
     percentage_of_limit: int
-    non_tx_message_counts: int = 0
-    non_tx_cumulative_size: int = 0
+    burst_percentage: int
+    message_limits: Dict[ProtocolMessageTypes, RLSettings]
+    message_count_buckets: Dict[ProtocolMessageTypes, TokenBucket]
+    message_size_buckets: Dict[ProtocolMessageTypes, TokenBucket]
+    non_tx_count_bucket: TokenBucket
+    non_tx_size_bucket: TokenBucket
 
-    def __init__(self, incoming: bool, reset_seconds=60, percentage_of_limit=100):
+    def __init__(self, incoming: bool, reset_seconds=60, percentage_of_limit=100, burst_percentage=100):
         """
         The incoming parameter affects whether counters are incremented
         unconditionally or not. For incoming messages, the counters are always
         incremeneted. For outgoing messages, the counters are only incremented
         if they are allowed to be sent by the rate limiter, since we won't send
         the messages otherwise.
+
+        Limits are expressed per reset_seconds, and are refilled continuously at that rate. burst_percentage is the
+        proportion of one period's allowance that can be used at once, after a peer has been idle.
         """
         self.incoming = incoming
         self.reset_seconds = reset_seconds
-        self.current_minute = time.time() // reset_seconds
-        self.message_counts = Counter()
-        self.message_cumulative_sizes = Counter()
         self.percentage_of_limit = percentage_of_limit
-        self.non_tx_message_counts = 0
-        self.non_tx_cumulative_size = 0
+        self.burst_percentage = burst_percentage
+        self.message_limits = {}
+        self.message_count_buckets = {}
+        self.message_size_buckets = {}
+        now = time.time()
+        self.non_tx_count_bucket = self._new_bucket(NON_TX_FREQ, 1, now)
+        self.non_tx_size_bucket = self._new_bucket(NON_TX_MAX_TOTAL_SIZE, NON_TX_MAX_SIZE, now)
+
+    def _new_bucket(self, limit: int, min_capacity: int, now: float) -> TokenBucket:
+        allowance: float = limit * self.percentage_of_limit / 100
+        # The bucket must always be able to hold at least one maximum sized message, otherwise it never goes through
+        capacity: float = max(allowance * self.burst_percentage / 100, min_capacity)
+        return TokenBucket(capacity, allowance / self.reset_seconds, capacity, now)
+
+    def _get_limits(self, message_type: ProtocolMessageTypes) -> RLSettings:
+        if message_type in self.message_limits:
+            return self.message_limits[message_type]
+
+        limits = DEFAULT_SETTINGS
+        if message_type in rate_limits_tx:
+            limits = rate_limits_tx[message_type]
+        elif message_type in rate_limits_other:
+            limits = rate_limits_other[message_type]
+        else:
+            log.warning(f"Message type {message_type} not found in rate limits")
+
+        if limits.max_total_size is None:
+            limits = dataclasses.replace(limits, max_total_size=limits.frequency * limits.max_size)
+        assert limits.max_total_size is not None
+
+        now = time.time()
+        self.message_limits[message_type] = limits
+        self.message_count_buckets[message_type] = self._new_bucket(limits.frequency, 1, now)
+        self.message_size_buckets[message_type] = self._new_bucket(limits.max_total_size, limits.max_size, now)
+        return limits
+
+    def _get_buckets(self, message_type: ProtocolMessageTypes, now: float) -> List[TokenBucket]:
+        """
+        Returns the (count, size) buckets for this message type, followed by the aggregate non tx buckets if they apply.
+        """
+        self._get_limits(message_type)
+        buckets = [self.message_count_buckets[message_type], self.message_size_buckets[message_type]]
+        if message_type in rate_limits_other:
+            buckets += [self.non_tx_count_bucket, self.non_tx_size_bucket]
+        for bucket in buckets:
+            bucket.refill(now)
+        return buckets
+
+    def max_size(self, message_type: int) -> int:
+        """
+        The largest payload accepted for this message type
+        """
+        try:
+            return self._get_limits(ProtocolMessageTypes(message_type)).max_size
+        except ValueError:
+            return DEFAULT_SETTINGS.max_size
+
+    def seconds_until_allowed(self, message: Message) -> Optional[float]:
+        """
+        Returns how long we have to wait until this message fits into all of its buckets, without consuming any tokens,
+        or None if the message can never be sent (because it's too large).
+        """
+        try:
+            message_type = ProtocolMessageTypes(message.type)
+        except Exception:
+            return 0
+        if len(message.data) > self._get_limits(message_type).max_size:
+            return None
+        buckets = self._get_buckets(message_type, time.time())
+        return max(bucket.seconds_until(amount) for bucket, amount in zip(buckets, [1, len(message.data)] * 2))
 
     def process_msg_and_check(self, message: Message) -> bool:
         """
         Returns True if message can be processed successfully, false if a rate limit is passed.
         """
 
-        current_minute = int(time.time() // self.reset_seconds)
-        if current_minute != self.current_minute:
-            self.current_minute = current_minute
-            self.message_counts = Counter()
-            self.message_cumulative_sizes = Counter()
-            self.non_tx_message_counts = 0
-            self.non_tx_cumulative_size = 0
         try:
             message_type = ProtocolMessageTypes(message.type)
         except Exception as e:
             log.warning(f"Invalid message: {message.type}, {e}")
             return True
 
-        new_message_counts: int = self.message_counts[message_type] + 1
-        new_cumulative_size: int = self.message_cumulative_sizes[message_type] + len(message.data)
-        new_non_tx_count: int = self.non_tx_message_counts
-        new_non_tx_size: int = self.non_tx_cumulative_size
-        proportion_of_limit: float = self.percentage_of_limit / 100
-
-        ret: bool = False
-        try:
-
-            limits = DEFAULT_SETTINGS
-            if message_type in rate_limits_tx:
-                limits = rate_limits_tx[message_type]
-            elif message_type in rate_limits_other:
-                limits = rate_limits_other[message_type]
-                new_non_tx_count = self.non_tx_message_counts + 1
-                new_non_tx_size = self.non_tx_cumulative_size + len(message.data)
-                if new_non_tx_count > NON_TX_FREQ * proportion_of_limit:
-                    return False
-                if new_non_tx_size > NON_TX_MAX_TOTAL_SIZE * proportion_of_limit:
-                    return False
-            else:
-                log.warning(f"Message type {message_type} not found in rate limits")
-
-            if limits.max_total_size is None:
-                limits = dataclasses.replace(limits, max_total_size=limits.frequency * limits.max_size)
-            assert limits.max_total_size is not None
-
-            if new_message_counts > limits.frequency * proportion_of_limit:
-                return False
-            if len(message.data) > limits.max_size:
-                return False
-            if new_cumulative_size > limits.max_total_size * proportion_of_limit:
-                return False
-
-            ret = True
-            return True
-        finally:
-            if self.incoming or ret:
-                # now that we determined that it's OK to send the message, commit the
-                # updates to the counters. Alternatively, if this was an
-                # incoming message, we already received it and it should
-                # increment the counters unconditionally
-                self.message_counts[message_type] = new_message_counts
-                self.message_cumulative_sizes[message_type] = new_cumulative_size
-                self.non_tx_message_counts = new_non_tx_count
-                self.non_tx_cumulative_size = new_non_tx_size
+        size: int = len(message.data)
+        buckets = self._get_buckets(message_type, time.time())
+        amounts = [1, size] * 2
+        ret: bool = size <= self._get_limits(message_type).max_size and all(
+            bucket.seconds_until(amount) == 0 for bucket, amount in zip(buckets, amounts)
+        )
+        if self.incoming or ret:
+            # now that we determined that it's OK to send the message, take the tokens from the
+            # buckets. Alternatively, if this was an incoming message, we already received it and it should
+            # take the tokens unconditionally
+            for bucket, amount in zip(buckets, amounts):
+                bucket.consume(amount)
+        return ret
@@ -16,9 +16,10 @@ from cryptography.hazmat.backends import default_backend
 from cryptography.hazmat.primitives import hashes, serialization
 
 from chia.protocols.protocol_message_types import ProtocolMessageTypes
-from chia.protocols.shared_protocol import protocol_version
+from chia.protocols.shared_protocol import Capability, protocol_version
 from chia.server.introducer_peers import IntroducerPeers
 from chia.server.outbound_message import Message, NodeType
+from chia.server.protocol_metrics import ProtocolMetrics
 from chia.server.ssl_context import private_ssl_paths, public_ssl_paths
 from chia.server.ws_connection import WSChiaConnection
 from chia.types.blockchain_format.sized_bytes import bytes32
@@ -58,6 +59,21 @@ def ssl_context_for_client(
     return ssl_context
 
 
+def capabilities_from_config(config: Dict) -> List[Tuple[uint16, str]]:
+    capabilities: List[Tuple[uint16, str]] = []
+    if config.get("quality_announce", False):
+        capabilities.append((uint16(Capability.QUALITY_ANNOUNCE.value), "1"))
+    if config.get("batch_signatures", False):
+        capabilities.append((uint16(Capability.BATCH_SIGNATURES.value), "1"))
+    # Leases are handed out by full nodes that send bluebox work, and only taken by timelords in sanitizer mode, since
+    # other timelords drop compact proof requests
+    sends_bluebox_work = config.get("send_uncompact_interval", 0) != 0
+    takes_bluebox_work = config.get("sanitizer_mode", False) and config.get("bluebox_leases", False)
+    if sends_bluebox_work or takes_bluebox_work:
+        capabilities.append((uint16(Capability.BLUEBOX_LEASES.value), "1"))
+    return capabilities
+
+
 class ChiaServer:
     def __init__(
         self,
@@ -75,6 +91,7 @@ class ChiaServer:
         chia_ca_crt_key: Tuple[Path, Path],
         name: str = None,
         introducer_peers: Optional[IntroducerPeers] = None,
+        rate_limit_burst_percent: int = 100,
     ):
         # Keeps track of all connections to and from this node.
         logging.basicConfig(level=logging.DEBUG)
@@ -97,6 +114,7 @@ class ChiaServer:
         self._network_id = network_id
         self._inbound_rate_limit_percent = inbound_rate_limit_percent
         self._outbound_rate_limit_percent = outbound_rate_limit_percent
+        self._rate_limit_burst_percent = rate_limit_burst_percent
 
         # Task list to keep references to tasks, so they don't get GCd
         self._tasks: List[asyncio.Task] = []
@@ -111,6 +129,11 @@ class ChiaServer:
         self.node = node
         self.root_path = root_path
         self.config = config
+        self.protocol_metrics: Optional[ProtocolMetrics] = None
+        if config.get("protocol_metrics", False):
+            self.protocol_metrics = ProtocolMetrics()
+        # Optional protocol features offered to peers in the handshake
+        self.capabilities: List[Tuple[uint16, str]] = capabilities_from_config(config)
         self.on_connect: Optional[Callable] = None
         self.incoming_messages: asyncio.Queue = asyncio.Queue()
         self.shut_down_event = asyncio.Event()
@@ -243,6 +266,10 @@ class ChiaServer:
                 self._inbound_rate_limit_percent,
                 self._outbound_rate_limit_percent,
                 close_event,
+                rate_limit_burst_percent=self._rate_limit_burst_percent,
+                protocol_metrics=self.protocol_metrics,
+                message_compression=self.config.get("message_compression", False),
+                capabilities=self.capabilities,
             )
             handshake = await connection.perform_handshake(
                 self._network_id,
@@ -386,6 +413,10 @@ class ChiaServer:
                     self._inbound_rate_limit_percent,
                     self._outbound_rate_limit_percent,
                     session=session,
+                    rate_limit_burst_percent=self._rate_limit_burst_percent,
+                    protocol_metrics=self.protocol_metrics,
+                    message_compression=self.config.get("message_compression", False),
+                    capabilities=self.capabilities,
                 )
                 handshake = await connection.perform_handshake(
                     self._network_id,
@@ -481,6 +512,9 @@ class ChiaServer:
 
             async def api_call(full_message: Message, connection: WSChiaConnection, task_id):
                 start_time = time.time()
+                # Set once the handler returns, the reply is not part of its latency
+                handler_time: Optional[float] = None
+                error = False
                 try:
                     if self.received_message_callback is not None:
                         await self.received_message_callback(connection)
@@ -533,11 +567,13 @@ class ChiaServer:
                         f"Time taken to process {message_type} from {connection.peer_node_id} is "
                         f"{time.time() - start_time} seconds"
                     )
+                    handler_time = time.time() - start_time
 
                     if response is not None:
                         response_message = Message(response.type, full_message.id, response.data)
                         await connection.reply_to_request(response_message)
                 except Exception as e:
+                    error = True
                     if self.connection_close_task is None:
                         tb = traceback.format_exc()
                         connection.log.error(
@@ -548,6 +584,10 @@ class ChiaServer:
                     # TODO: actually throw one of the errors from errors.py and pass this to close
                     await connection.close(self.api_exception_ban_seconds, WSCloseCode.PROTOCOL_ERROR, Err.UNKNOWN)
                 finally:
+                    if self.protocol_metrics is not None and (handler_time is not None or error):
+                        if handler_time is None:
+                            handler_time = time.time() - start_time
+                        self.protocol_metrics.handler_finished(full_message.type, handler_time, error)
                     if task_id in self.api_tasks:
                         self.api_tasks.pop(task_id)
                     if task_id in self.tasks_from_peer[connection.peer_node_id]:
@@ -72,7 +72,8 @@ class Service:
         chia_ca_crt, chia_ca_key = chia_ssl_ca_paths(root_path, self.config)
         inbound_rlp = self.config.get("inbound_rate_limit_percent")
         outbound_rlp = self.config.get("outbound_rate_limit_percent")
-        assert inbound_rlp and outbound_rlp
+        burst_rlp = self.config.get("rate_limit_burst_percent", 100)
+        assert inbound_rlp and outbound_rlp and burst_rlp
         self._server = ChiaServer(
             advertised_port,
             node,
@@ -87,6 +88,7 @@ class Service:
             (private_ca_crt, private_ca_key),
             (chia_ca_crt, chia_ca_key),
             name=f"{service_name}_server",
+            rate_limit_burst_percent=burst_rlp,
         )
         f = getattr(node, "set_server", None)
         if f:
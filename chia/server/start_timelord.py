@@ -4,6 +4,7 @@ from typing import Dict
 
 from chia.consensus.constants import ConsensusConstants
 from chia.consensus.default_constants import DEFAULT_CONSTANTS
+from chia.rpc.timelord_rpc_api import TimelordRpcApi
 from chia.server.outbound_message import NodeType
 from chia.server.start_service import run_service
 from chia.timelord.timelord import Timelord
@@ -46,6 +47,8 @@ def service_kwargs_for_timelord(
         auth_connect_peers=False,
         network_id=network_id,
     )
+    if config.get("start_rpc_server", False):
+        kwargs["rpc_info"] = (TimelordRpcApi, config["rpc_port"])
     return kwargs
 
 
@@ -1,17 +1,29 @@
 import asyncio
+import heapq
+import itertools
 import logging
 import time
 import traceback
-from typing import Any, Callable, Dict, List, Optional
+from collections import deque
+from typing import Any, Callable, Deque, Dict, List, Optional, Tuple
 
 from aiohttp import WSCloseCode, WSMessage, WSMsgType
 
 from chia.cmds.init_funcs import chia_full_version_str
 from chia.protocols.protocol_message_types import ProtocolMessageTypes
 from chia.protocols.shared_protocol import Capability, Handshake
+from chia.server.message_compression import (
+    COMPRESSIBLE_MESSAGE_TYPES,
+    SUPPORTED_CODECS,
+    compress_payload,
+    decompress_payload,
+    is_compressed,
+    should_compress,
+    uncompressed_payload,
+)
 from chia.server.outbound_message import Message, NodeType, make_msg
+from chia.server.protocol_metrics import ProtocolMetrics
 from chia.server.rate_limits import RateLimiter
-from chia.types.blockchain_format.sized_bytes import bytes32
 from chia.types.peer_info import PeerInfo
 from chia.util.errors import Err, ProtocolError
 from chia.util.ints import uint8, uint16
@@ -46,6 +58,10 @@ class WSChiaConnection:
         outbound_rate_limit_percent: int,
         close_event=None,
         session=None,
+        rate_limit_burst_percent: int = 100,
+        protocol_metrics: Optional[ProtocolMetrics] = None,
+        message_compression: bool = False,
+        capabilities: Optional[List[Tuple[uint16, str]]] = None,
     ):
         # Local properties
         self.ws: Any = ws
@@ -74,6 +90,14 @@ class WSChiaConnection:
         self.bytes_read = 0
         self.bytes_written = 0
         self.last_message_time: float = 0
+        # Shared with the server, None if protocol metrics are disabled
+        self.protocol_metrics: Optional[ProtocolMetrics] = protocol_metrics
+        # Whether we offer payload compression in the handshake, and whether the peer accepted it
+        self.message_compression = message_compression
+        self.compression_negotiated = False
+        # Other optional features we offer in the handshake, and what the peer offered
+        self.local_capabilities: List[Tuple[uint16, str]] = [] if capabilities is None else capabilities
+        self.peer_capabilities: List[Tuple[uint16, str]] = []
 
         # Messaging
         self.incoming_queue: asyncio.Queue = incoming_queue
@@ -86,9 +110,13 @@ class WSChiaConnection:
         self.session = session
         self.close_callback = close_callback
 
-        self.pending_requests: Dict[bytes32, asyncio.Event] = {}
-        self.pending_timeouts: Dict[bytes32, asyncio.Task] = {}
-        self.request_results: Dict[bytes32, Message] = {}
+        # Requests we sent and are waiting for a response, by message id. The future is resolved with the response,
+        # or with None on timeout or when the connection closes.
+        self.pending_requests: Dict[uint16, asyncio.Future] = {}
+        # Min heap of (deadline, sequence number, future), expired by a single timer for the whole connection
+        self.request_deadlines: List[Tuple[float, int, asyncio.Future]] = []
+        self.request_sequence = itertools.count()
+        self.request_timeout_handle: Optional[asyncio.TimerHandle] = None
         self.closed = False
         self.connection_type: Optional[NodeType] = None
         if is_outbound:
@@ -98,10 +126,18 @@ class WSChiaConnection:
             # request. The receiving peer (not is_outbound), will use 2^15 to 2^16 - 1
             self.request_nonce = uint16(2 ** 15)
 
-        # This means that even if the other peer's boundaries for each minute are not aligned, we will not
-        # disconnect. Also it allows a little flexibility.
-        self.outbound_rate_limiter = RateLimiter(incoming=False, percentage_of_limit=outbound_rate_limit_percent)
-        self.inbound_rate_limiter = RateLimiter(incoming=True, percentage_of_limit=inbound_rate_limit_percent)
+        # We send at a lower rate than we accept, which means that even if the other peer's buckets are not in sync
+        # with ours, we will not be disconnected. Also it allows a little flexibility.
+        self.outbound_rate_limiter = RateLimiter(
+            incoming=False, percentage_of_limit=outbound_rate_limit_percent, burst_percentage=rate_limit_burst_percent
+        )
+        self.inbound_rate_limiter = RateLimiter(
+            incoming=True, percentage_of_limit=inbound_rate_limit_percent, burst_percentage=rate_limit_burst_percent
+        )
+        # Outbound messages that were rate limited, per message type, in the order they were sent. Only the first
+        # message of each type is scheduled, for when the rate limiter has enough tokens for it.
+        self.rate_limited_messages: Dict[int, Deque[Message]] = {}
+        self.rate_limit_timers: Dict[int, asyncio.TimerHandle] = {}
 
     async def perform_handshake(self, network_id: str, protocol_version: str, server_port: int, local_type: NodeType):
         if self.is_outbound:
@@ -113,7 +149,7 @@ class WSChiaConnection:
                     chia_full_version_str(),
                     uint16(server_port),
                     uint8(local_type.value),
-                    [(uint16(Capability.BASE.value), "1")],
+                    self._capabilities(),
                 ),
             )
             assert outbound_handshake is not None
@@ -129,6 +165,8 @@ class WSChiaConnection:
 
             self.peer_server_port = inbound_handshake.server_port
             self.connection_type = NodeType(inbound_handshake.node_type)
+            self.compression_negotiated = self._peer_supports_compression(inbound_handshake)
+            self.peer_capabilities = inbound_handshake.capabilities
 
         else:
             try:
@@ -151,17 +189,38 @@ class WSChiaConnection:
                     chia_full_version_str(),
                     uint16(server_port),
                     uint8(local_type.value),
-                    [(uint16(Capability.BASE.value), "1")],
+                    self._capabilities(),
                 ),
             )
             await self._send_message(outbound_handshake)
             self.peer_server_port = inbound_handshake.server_port
             self.connection_type = NodeType(inbound_handshake.node_type)
+            self.compression_negotiated = self._peer_supports_compression(inbound_handshake)
+            self.peer_capabilities = inbound_handshake.capabilities
 
         self.outbound_task = asyncio.create_task(self.outbound_handler())
         self.inbound_task = asyncio.create_task(self.inbound_handler())
         return True
 
+    def _capabilities(self) -> List[Tuple[uint16, str]]:
+        capabilities = [(uint16(Capability.BASE.value), "1")]
+        if self.message_compression:
+            capabilities.append((uint16(Capability.COMPRESSION.value), SUPPORTED_CODECS))
+        return capabilities + self.local_capabilities
+
+    def has_capability(self, capability: Capability) -> bool:
+        # Only features that both sides offered can be used
+        offered = any(local == capability.value for local, _ in self.local_capabilities)
+        return offered and any(peer == capability.value for peer, _ in self.peer_capabilities)
+
+    def _peer_supports_compression(self, handshake: Handshake) -> bool:
+        if not self.message_compression:
+            return False
+        for capability, value in handshake.capabilities:
+            if capability == Capability.COMPRESSION.value and "zlib" in value.split(","):
+                return True
+        return False
+
     async def close(self, ban_time: int = 0, ws_close_code: WSCloseCode = WSCloseCode.OK, error: Optional[Err] = None):
         """
         Closes the connection, and finally calls the close_callback on the server, so the connections gets removed
@@ -188,7 +247,8 @@ class WSChiaConnection:
                 await self.session.close()
             if self.close_event is not None:
                 self.close_event.set()
-            self.cancel_pending_timeouts()
+            self.cancel_pending_requests()
+            self.cancel_rate_limit_timers()
         except Exception:
             error_stack = traceback.format_exc()
             self.log.warning(f"Exception closing socket: {error_stack}")
@@ -196,9 +256,20 @@ class WSChiaConnection:
             raise
         self.close_callback(self, ban_time)
 
-    def cancel_pending_timeouts(self):
-        for _, task in self.pending_timeouts.items():
-            task.cancel()
+    def cancel_pending_requests(self):
+        if self.request_timeout_handle is not None:
+            self.request_timeout_handle.cancel()
+            self.request_timeout_handle = None
+        self.request_deadlines = []
+        for _, future in self.pending_requests.items():
+            if not future.done():
+                future.set_result(None)
+
+    def cancel_rate_limit_timers(self):
+        for _, timer in self.rate_limit_timers.items():
+            timer.cancel()
+        self.rate_limit_timers = {}
+        self.rate_limited_messages = {}
 
     async def outbound_handler(self):
         try:
@@ -223,9 +294,9 @@ class WSChiaConnection:
                 message: Message = await self._read_one_message()
                 if message is not None:
                     if message.id in self.pending_requests:
-                        self.request_results[message.id] = message
-                        event = self.pending_requests[message.id]
-                        event.set()
+                        future = self.pending_requests[message.id]
+                        if not future.done():
+                            future.set_result(message)
                     else:
                         await self.incoming_queue.put((message, self))
                 else:
@@ -281,49 +352,78 @@ class WSChiaConnection:
         if self.closed:
             return None
 
-        # We will wait for this event, it will be set either by the response, or the timeout
-        event = asyncio.Event()
-
         # The request nonce is an integer between 0 and 2**16 - 1, which is used to match requests to responses
-        # If is_outbound, 0 <= nonce < 2^15, else  2^15 <= nonce < 2^16
-        request_id = self.request_nonce
-        if self.is_outbound:
-            self.request_nonce = uint16(self.request_nonce + 1) if self.request_nonce != (2 ** 15 - 1) else uint16(0)
-        else:
-            self.request_nonce = (
-                uint16(self.request_nonce + 1) if self.request_nonce != (2 ** 16 - 1) else uint16(2 ** 15)
-            )
+        # If is_outbound, 0 <= nonce < 2^15, else  2^15 <= nonce < 2^16. After wrapping around, nonces of requests
+        # that are still pending are skipped, at most one per pending request.
+        request_id = self._next_request_nonce()
+        for _ in range(len(self.pending_requests)):
+            if request_id not in self.pending_requests:
+                break
+            request_id = self._next_request_nonce()
+        if request_id in self.pending_requests:
+            raise ValueError(f"All {len(self.pending_requests)} request nonces to {self.peer_host} are in use")
 
         message = Message(message_no_id.type, request_id, message_no_id.data)
 
-        self.pending_requests[message.id] = event
+        # Resolved either by the response in inbound_handler, or with None by the timeout
+        future: asyncio.Future = asyncio.get_running_loop().create_future()
+        self.pending_requests[request_id] = future
+        if timeout is not None:
+            self._add_request_deadline(timeout, future)
+        request_start_t = time.time()
         await self.outgoing_queue.put(message)
 
-        # If the timeout passes, we set the event
-        async def time_out(req_id, req_timeout):
-            try:
-                await asyncio.sleep(req_timeout)
-                if req_id in self.pending_requests:
-                    self.pending_requests[req_id].set()
-            except asyncio.CancelledError:
-                if req_id in self.pending_requests:
-                    self.pending_requests[req_id].set()
-                raise
-
-        timeout_task = asyncio.create_task(time_out(message.id, timeout))
-        self.pending_timeouts[message.id] = timeout_task
-        await event.wait()
-
-        self.pending_requests.pop(message.id)
-        result: Optional[Message] = None
-        if message.id in self.request_results:
-            result = self.request_results[message.id]
-            assert result is not None
+        try:
+            result: Optional[Message] = await future
+        finally:
+            self.pending_requests.pop(request_id, None)
+        if result is not None:
             self.log.info(f"<- {ProtocolMessageTypes(result.type).name} from: {self.peer_host}:{self.peer_port}")
-            self.request_results.pop(result.id)
+        if self.protocol_metrics is not None and not self.closed:
+            self.protocol_metrics.request_finished(message.type, time.time() - request_start_t, result is None)
 
         return result
 
+    def _next_request_nonce(self) -> uint16:
+        request_id = self.request_nonce
+        if self.is_outbound:
+            self.request_nonce = uint16(self.request_nonce + 1) if self.request_nonce != (2 ** 15 - 1) else uint16(0)
+        else:
+            self.request_nonce = (
+                uint16(self.request_nonce + 1) if self.request_nonce != (2 ** 16 - 1) else uint16(2 ** 15)
+            )
+        return request_id
+
+    def _add_request_deadline(self, timeout: float, future: asyncio.Future):
+        if len(self.request_deadlines) > 2 * len(self.pending_requests) + 100:
+            # Entries of requests that were already answered are normally dropped when they reach the top of the
+            # heap, this keeps the heap small if there are many requests with long timeouts
+            self.request_deadlines = [entry for entry in self.request_deadlines if not entry[2].done()]
+            heapq.heapify(self.request_deadlines)
+        deadline = asyncio.get_running_loop().time() + timeout
+        heapq.heappush(self.request_deadlines, (deadline, next(self.request_sequence), future))
+        if self.request_timeout_handle is None or self.request_deadlines[0][2] is future:
+            # This is now the earliest deadline, move the timer
+            self._schedule_request_timeouts()
+
+    def _schedule_request_timeouts(self):
+        if self.request_timeout_handle is not None:
+            self.request_timeout_handle.cancel()
+            self.request_timeout_handle = None
+        if len(self.request_deadlines) > 0:
+            self.request_timeout_handle = asyncio.get_running_loop().call_at(
+                self.request_deadlines[0][0], self._expire_requests
+            )
+
+    def _expire_requests(self):
+        self.request_timeout_handle = None
+        now = asyncio.get_running_loop().time()
+        while len(self.request_deadlines) > 0 and self.request_deadlines[0][0] <= now:
+            _, _, future = heapq.heappop(self.request_deadlines)
+            if not future.done():
+                future.set_result(None)
+        self._schedule_request_timeouts()
+
     async def reply_to_request(self, response: Message):
         if self.closed:
             return
@@ -335,18 +435,41 @@ class WSChiaConnection:
         for message in messages:
             await self.outgoing_queue.put(message)
 
-    async def _wait_and_retry(self, msg: Message, queue: asyncio.Queue):
-        try:
-            await asyncio.sleep(1)
-            await queue.put(msg)
-        except Exception as e:
-            self.log.debug(f"Exception {e} while waiting to retry sending rate limited message")
+    def _schedule_rate_limited(self, message_type: int):
+        """
+        Schedules the first rate limited message of this type to be put back into the outgoing queue, as soon as the
+        rate limiter has enough tokens to send it.
+        """
+        backlog = self.rate_limited_messages[message_type]
+        delay: Optional[float] = None
+        while len(backlog) > 0:
+            delay = self.outbound_rate_limiter.seconds_until_allowed(backlog[0])
+            if delay is not None:
+                break
+            dropped = backlog.popleft()
+            self.log.warning(
+                f"Not sending message {ProtocolMessageTypes(dropped.type).name} of size {len(dropped.data)} to "
+                f"{self.peer_host}, it is larger than the rate limit"
+            )
+        if delay is None:
+            self.rate_limited_messages.pop(message_type)
             return
+        self.rate_limit_timers[message_type] = asyncio.get_running_loop().call_later(
+            delay, self._release_rate_limited, message_type
+        )
+
+    def _release_rate_limited(self, message_type: int):
+        self.rate_limit_timers.pop(message_type, None)
+        if self.closed or message_type not in self.rate_limited_messages:
+            return
+        self.outgoing_queue.put_nowait(self.rate_limited_messages[message_type][0])
 
     async def _send_message(self, message: Message):
-        encoded: bytes = bytes(message)
-        size = len(encoded)
-        assert len(encoded) < (2 ** (LENGTH_BYTES * 8))
+        backlog: Optional[Deque[Message]] = self.rate_limited_messages.get(message.type)
+        if backlog is not None and backlog[0] is not message:
+            # Other messages of this type are already waiting for the rate limiter, keep them in order
+            backlog.append(message)
+            return
         if not self.outbound_rate_limiter.process_msg_and_check(message):
             if not is_localhost(self.peer_host):
                 self.log.debug(
@@ -356,7 +479,9 @@ class WSChiaConnection:
 
                 # TODO: fix this special case. This function has rate limits which are too low.
                 if ProtocolMessageTypes(message.type) != ProtocolMessageTypes.respond_peers:
-                    asyncio.create_task(self._wait_and_retry(message, self.outgoing_queue))
+                    if backlog is None:
+                        self.rate_limited_messages[message.type] = deque([message])
+                    self._schedule_rate_limited(message.type)
 
                 return
             else:
@@ -364,10 +489,69 @@ class WSChiaConnection:
                     f"Not rate limiting ourselves. message type: {ProtocolMessageTypes(message.type).name}, "
                     f"peer: {self.peer_host}"
                 )
+        elif backlog is not None:
+            # This was the first rate limited message of its type, schedule the next one
+            backlog.popleft()
+            if len(backlog) > 0:
+                self._schedule_rate_limited(message.type)
+            else:
+                self.rate_limited_messages.pop(message.type)
 
+        if self.compression_negotiated:
+            message = await self._compress(message)
+        encoded: bytes = bytes(message)
+        size = len(encoded)
+        assert len(encoded) < (2 ** (LENGTH_BYTES * 8))
         await self.ws.send_bytes(encoded)
         self.log.info(f"-> {ProtocolMessageTypes(message.type).name} to peer {self.peer_host} {self.peer_node_id}")
         self.bytes_written += size
+        if self.protocol_metrics is not None:
+            self.protocol_metrics.message_sent(message.type, size)
+
+    async def _compress(self, message: Message) -> Message:
+        if not should_compress(message.type, len(message.data)):
+            return Message(message.type, message.id, uncompressed_payload(message.data))
+        data, cpu_time = await asyncio.get_running_loop().run_in_executor(None, compress_payload, message.data)
+        if self.protocol_metrics is not None:
+            self.protocol_metrics.payload_compressed(message.type, len(message.data), len(data), cpu_time)
+        return Message(message.type, message.id, data)
+
+    async def _decompress(self, message: Message) -> Optional[Message]:
+        if is_compressed(message.data):
+            data, cpu_time = await asyncio.get_running_loop().run_in_executor(
+                None, decompress_payload, message.data, self.inbound_rate_limiter.max_size(message.type)
+            )
+            if data is not None and self.protocol_metrics is not None:
+                self.protocol_metrics.payload_decompressed(message.type, len(message.data), len(data), cpu_time)
+        else:
+            data, _ = decompress_payload(message.data)
+        if data is None:
+            return None
+        return Message(message.type, message.id, data)
+
+    async def _check_inbound_rate_limit(self, message: Message) -> bool:
+        """
+        Returns False if the peer surpassed the rate limit and is being disconnected
+        """
+        if self.inbound_rate_limiter.process_msg_and_check(message):
+            return True
+        try:
+            message_type = ProtocolMessageTypes(message.type).name
+        except Exception:
+            message_type = "Unknown"
+        if self.local_type == NodeType.FULL_NODE and not is_localhost(self.peer_host):
+            self.log.error(
+                f"Peer has been rate limited and will be disconnected: {self.peer_host}, message: {message_type}"
+            )
+            # Only full node disconnects peers, to prevent abuse and crashing timelords, farmers, etc
+            asyncio.create_task(self.close(300))
+            await asyncio.sleep(3)
+            return False
+        self.log.warning(
+            f"Peer surpassed rate limit {self.peer_host}, message: {message_type}, "
+            f"port {self.peer_port} but not disconnecting"
+        )
+        return True
 
     async def _read_one_message(self) -> Optional[Message]:
         try:
@@ -410,26 +594,35 @@ class WSChiaConnection:
             full_message_loaded: Message = Message.from_bytes(data)
             self.bytes_read += len(data)
             self.last_message_time = time.time()
-            try:
-                message_type = ProtocolMessageTypes(full_message_loaded.type).name
-            except Exception:
-                message_type = "Unknown"
-            if not self.inbound_rate_limiter.process_msg_and_check(full_message_loaded):
-                if self.local_type == NodeType.FULL_NODE and not is_localhost(self.peer_host):
-                    self.log.error(
-                        f"Peer has been rate limited and will be disconnected: {self.peer_host}, "
-                        f"message: {message_type}"
+            if self.protocol_metrics is not None:
+                self.protocol_metrics.message_received(full_message_loaded.type, len(data))
+            rate_limit_checked = False
+            if self.compression_negotiated:
+                if is_compressed(full_message_loaded.data):
+                    if full_message_loaded.type not in COMPRESSIBLE_MESSAGE_TYPES:
+                        self.log.error(
+                            f"Compressed payload of type {full_message_loaded.type} from {self.peer_host}, "
+                            f"which is never compressed, disconnecting"
+                        )
+                        asyncio.create_task(self.close(300, WSCloseCode.PROTOCOL_ERROR, Err.INVALID_PROTOCOL_MESSAGE))
+                        await asyncio.sleep(3)
+                        return None
+                    # The compressed size is checked against the rate limits before the payload is inflated
+                    compressed_message = Message(
+                        full_message_loaded.type, full_message_loaded.id, full_message_loaded.data[1:]
                     )
-                    # Only full node disconnects peers, to prevent abuse and crashing timelords, farmers, etc
-                    asyncio.create_task(self.close(300))
+                    if not await self._check_inbound_rate_limit(compressed_message):
+                        return None
+                    rate_limit_checked = True
+                decompressed_message = await self._decompress(full_message_loaded)
+                if decompressed_message is None:
+                    self.log.error(f"Invalid compressed payload from {self.peer_host}, disconnecting")
+                    asyncio.create_task(self.close(300, WSCloseCode.PROTOCOL_ERROR, Err.INVALID_PROTOCOL_MESSAGE))
                     await asyncio.sleep(3)
                     return None
-                else:
-                    self.log.warning(
-                        f"Peer surpassed rate limit {self.peer_host}, message: {message_type}, "
-                        f"port {self.peer_port} but not disconnecting"
-                    )
-                    return full_message_loaded
+                full_message_loaded = decompressed_message
+            if not rate_limit_checked and not await self._check_inbound_rate_limit(full_message_loaded):
+                return None
             return full_message_loaded
         elif message.type == WSMsgType.ERROR:
             self.log.error(f"WebSocket Error: {message}")
@@ -1,10 +1,11 @@
 import asyncio
 import dataclasses
-import io
 import logging
 import random
 import time
 import traceback
+import weakref
+from concurrent.futures import ThreadPoolExecutor
 from typing import Callable, Dict, List, Optional, Tuple, Set
 
 from chiavdf import create_discriminant
@@ -16,8 +17,16 @@ from chia.protocols.protocol_message_types import ProtocolMessageTypes
 from chia.server.outbound_message import NodeType, make_msg
 from chia.server.server import ChiaServer
 from chia.timelord.iters_from_block import iters_from_block
+from chia.timelord.timelord_metrics import TimelordMetrics
 from chia.timelord.timelord_state import LastState
 from chia.timelord.types import Chain, IterationType, StateType
+from chia.timelord.vdf_client_protocol import (
+    STOP_ITERATIONS,
+    decode_proof,
+    encode_discriminant,
+    encode_iterations,
+    encode_mode,
+)
 from chia.types.blockchain_format.classgroup import ClassgroupElement
 from chia.types.blockchain_format.reward_chain_block import RewardChainBlock
 from chia.types.blockchain_format.sized_bytes import bytes32
@@ -91,6 +100,27 @@ class Timelord:
         self.sanitizer_mode = self.config["sanitizer_mode"]
         self.pending_bluebox_info: List[timelord_protocol.RequestCompactProofOfTime] = []
         self.last_active_time = time.time()
+        # Binary framing of discriminants, iterations and proofs, see vdf_client_protocol.py
+        self.vdf_binary_protocol: bool = self.config.get("vdf_binary_protocol", False)
+        # Writes to each vdf_client are serialized by its own lock, so they don't wait for the global lock
+        self.writer_locks: "weakref.WeakKeyDictionary[asyncio.StreamWriter, asyncio.Lock]"
+        self.writer_locks = weakref.WeakKeyDictionary()
+        # Our own proofs are checked off the event loop, after they are used, so they don't delay the chains
+        self.proof_verification_rate: float = self.config.get("proof_verification_rate", 1.0)
+        self.verify_executor = ThreadPoolExecutor(max_workers=1, thread_name_prefix="timelord-verify-")
+        self.verification_tasks: Set[asyncio.Task] = set()
+        self.proofs_verified: int = 0
+        self.invalid_proofs_count: int = 0
+        self.metrics = TimelordMetrics()
+
+    async def _write_to_client(self, writer: asyncio.StreamWriter, data: bytes):
+        lock = self.writer_locks.get(writer)
+        if lock is None:
+            lock = asyncio.Lock()
+            self.writer_locks[writer] = lock
+        async with lock:
+            writer.write(data)
+            await writer.drain()
 
     async def _start(self):
         self.lock: asyncio.Lock = asyncio.Lock()
@@ -112,19 +142,59 @@ class Timelord:
             task.cancel()
         if self.main_loop is not None:
             self.main_loop.cancel()
+        for task in self.verification_tasks:
+            task.cancel()
+        self.verify_executor.shutdown(wait=False)
 
     async def _await_closed(self):
         pass
 
+    def _schedule_proof_verification(
+        self, chain: Chain, initial_form: ClassgroupElement, vdf_info: VDFInfo, vdf_proof: VDFProof
+    ):
+        if self.proof_verification_rate < 1 and random.random() >= self.proof_verification_rate:
+            return
+        task = asyncio.create_task(self._verify_proof(chain, initial_form, vdf_info, vdf_proof))
+        self.verification_tasks.add(task)
+        task.add_done_callback(self.verification_tasks.discard)
+
+    async def _verify_proof(
+        self, chain: Chain, initial_form: ClassgroupElement, vdf_info: VDFInfo, vdf_proof: VDFProof
+    ):
+        valid = await asyncio.get_running_loop().run_in_executor(
+            self.verify_executor, vdf_proof.is_valid, self.constants, initial_form, vdf_info
+        )
+        self.proofs_verified += 1
+        if not valid:
+            self.invalid_proofs_count += 1
+            log.error(
+                f"Invalid proof of time! Chain: {chain}, iters: {vdf_info.number_of_iterations}. "
+                f"{self.invalid_proofs_count} of {self.proofs_verified} checked proofs were invalid."
+            )
+
     def set_server(self, server: ChiaServer):
         self.server = server
 
+    def _set_state_changed_callback(self, callback: Callable):
+        self.state_changed_callback = callback
+
+    def get_metrics(self) -> Dict:
+        metrics = self.metrics.to_json_dict()
+        metrics["proofs_finished"] = len(self.proofs_finished)
+        metrics["pending_bluebox_info"] = len(self.pending_bluebox_info)
+        metrics["free_clients"] = len(self.free_clients)
+        metrics["vdf_failures"] = self.vdf_failures_count
+        metrics["proofs_verified"] = self.proofs_verified
+        metrics["invalid_proofs"] = self.invalid_proofs_count
+        return metrics
+
     async def _handle_client(self, reader: asyncio.StreamReader, writer: asyncio.StreamWriter):
         async with self.lock:
             client_ip = writer.get_extra_info("peername")[0]
             log.debug(f"New timelord connection from client: {client_ip}.")
             if client_ip in self.ip_whitelist:
                 self.free_clients.append((client_ip, reader, writer))
+                self.metrics.vdf_client_connected(client_ip)
                 log.debug(f"Added new VDF client {client_ip}.")
                 for ip, end_time in list(self.potential_free_clients):
                     if ip == client_ip:
@@ -143,8 +213,7 @@ class Timelord:
                     return
             stop_ip, _, stop_writer = self.chain_type_to_stream[chain]
             self.potential_free_clients.append((stop_ip, time.time()))
-            stop_writer.write(b"010")
-            await stop_writer.drain()
+            await self._write_to_client(stop_writer, encode_iterations(STOP_ITERATIONS, self.vdf_binary_protocol))
             if chain in self.allows_iters:
                 self.allows_iters.remove(chain)
             if chain not in self.unspawned_chains:
@@ -269,6 +338,7 @@ class Timelord:
         for chain, iters in self.iters_to_submit.items():
             for iteration in iters:
                 assert iteration > 0
+        self.metrics.chains_reset()
 
     async def _handle_new_peak(self):
         assert self.new_peak is not None
@@ -350,12 +420,8 @@ class Timelord:
                         continue
                     log.debug(f"Submitting iterations to {chain}: {iteration}")
                     assert iteration > 0
-                    prefix = str(len(str(iteration)))
-                    if len(str(iteration)) < 10:
-                        prefix = "0" + prefix
-                    iter_str = prefix + str(iteration)
-                    writer.write(iter_str.encode())
-                    await writer.drain()
+                    await self._write_to_client(writer, encode_iterations(iteration, self.vdf_binary_protocol))
+                    self.metrics.iterations_submitted(chain, iteration)
                     self.iters_submitted[chain].append(iteration)
 
     def _clear_proof_list(self, iters: uint64):
@@ -838,36 +904,17 @@ class Timelord:
         # Labels a proof to the current state only
         proof_label: Optional[int] = None,
     ):
-        disc: int = create_discriminant(challenge, self.constants.DISCRIMINANT_SIZE_BITS)
+        disc: str = create_discriminant(challenge, self.constants.DISCRIMINANT_SIZE_BITS)
 
         try:
             # Depending on the flags 'fast_algorithm' and 'sanitizer_mode',
             # the timelord tells the vdf_client what to execute.
-            async with self.lock:
-                if self.sanitizer_mode:
-                    writer.write(b"S")
-                else:
-                    if self.config["fast_algorithm"]:
-                        # Run n-wesolowski (fast) algorithm.
-                        writer.write(b"N")
-                    else:
-                        # Run two-wesolowski (slow) algorithm.
-                        writer.write(b"T")
-                await writer.drain()
-
-            prefix = str(len(str(disc)))
-            if len(prefix) == 1:
-                prefix = "00" + prefix
-            if len(prefix) == 2:
-                prefix = "0" + prefix
-            async with self.lock:
-                writer.write((prefix + str(disc)).encode())
-                await writer.drain()
-
+            binary = self.vdf_binary_protocol
+            setup = encode_mode(self.sanitizer_mode, self.config["fast_algorithm"], binary)
+            setup += encode_discriminant(disc, binary)
             # Send initial_form prefixed with its length.
-            async with self.lock:
-                writer.write(bytes([len(initial_form.data)]) + initial_form.data)
-                await writer.drain()
+            setup += bytes([len(initial_form.data)]) + initial_form.data
+            await self._write_to_client(writer, setup)
             try:
                 ok = await reader.readexactly(2)
             except (asyncio.IncompleteReadError, ConnectionResetError, Exception) as e:
@@ -885,15 +932,10 @@ class Timelord:
                 async with self.lock:
                     self.allows_iters.append(chain)
             else:
-                async with self.lock:
-                    assert chain is Chain.BLUEBOX
-                    assert bluebox_iteration is not None
-                    prefix = str(len(str(bluebox_iteration)))
-                    if len(str(bluebox_iteration)) < 10:
-                        prefix = "0" + prefix
-                    iter_str = prefix + str(bluebox_iteration)
-                    writer.write(iter_str.encode())
-                    await writer.drain()
+                assert chain is Chain.BLUEBOX
+                assert bluebox_iteration is not None
+                await self._write_to_client(writer, encode_iterations(bluebox_iteration, binary))
+                bluebox_start_time = time.time()
 
             # Listen to the client until "STOP" is received.
             while True:
@@ -917,16 +959,14 @@ class Timelord:
                     pass
                 if msg == "STOP":
                     log.debug(f"Stopped client running on ip {ip}.")
-                    async with self.lock:
-                        writer.write(b"ACK")
-                        await writer.drain()
+                    await self._write_to_client(writer, b"ACK")
                     break
                 else:
                     try:
                         # This must be a proof, 4 bytes is length prefix
                         length = int.from_bytes(data, "big")
                         proof = await reader.readexactly(length)
-                        stdout_bytes_io: io.BytesIO = io.BytesIO(bytes.fromhex(proof.decode()))
+                        iterations, y_bytes, witness, proof_bytes = decode_proof(proof, binary)
                     except (
                         asyncio.IncompleteReadError,
                         ConnectionResetError,
@@ -938,16 +978,9 @@ class Timelord:
                             self.vdf_failures_count += 1
                         break
 
-                    iterations_needed = uint64(int.from_bytes(stdout_bytes_io.read(8), "big", signed=True))
-
-                    y_size_bytes = stdout_bytes_io.read(8)
-                    y_size = uint64(int.from_bytes(y_size_bytes, "big", signed=True))
-
-                    y_bytes = stdout_bytes_io.read(y_size)
-                    witness_type = uint8(int.from_bytes(stdout_bytes_io.read(1), "big", signed=True))
-                    proof_bytes: bytes = stdout_bytes_io.read()
+                    iterations_needed = uint64(iterations)
+                    witness_type = uint8(witness)
 
-                    # Verifies our own proof just in case
                     form_size = ClassgroupElement.get_size(self.constants)
                     output = ClassgroupElement.from_bytes(y_bytes[:form_size])
                     if not self.sanitizer_mode:
@@ -958,6 +991,11 @@ class Timelord:
                             f" iters, "
                             f"Estimated IPS: {ips}, Chain: {chain}"
                         )
+                        self.metrics.proof_received(chain, iterations_needed, ips)
+                    else:
+                        time_taken = time.time() - bluebox_start_time
+                        ips = int(iterations_needed / time_taken * 10) / 10
+                        self.metrics.proof_received(chain, iterations_needed, ips, bluebox_start_time)
 
                     vdf_info: VDFInfo = VDFInfo(
                         challenge,
@@ -970,16 +1008,14 @@ class Timelord:
                         self.sanitizer_mode,
                     )
 
-                    if not vdf_proof.is_valid(self.constants, initial_form, vdf_info):
-                        log.error("Invalid proof of time!")
+                    # Verifies our own proof just in case, without holding up the proof
+                    self._schedule_proof_verification(chain, initial_form, vdf_info, vdf_proof)
                     if not self.sanitizer_mode:
                         async with self.lock:
                             assert proof_label is not None
                             self.proofs_finished.append((chain, vdf_info, vdf_proof, proof_label))
                     else:
-                        async with self.lock:
-                            writer.write(b"010")
-                            await writer.drain()
+                        await self._write_to_client(writer, encode_iterations(STOP_ITERATIONS, binary))
                         assert header_hash is not None
                         assert field_vdf is not None
                         assert height is not None
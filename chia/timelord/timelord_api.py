@@ -32,6 +32,7 @@ class TimelordAPI:
                     f"{new_peak.reward_chain_block.weight} "
                 )
                 self.timelord.new_peak = new_peak
+                self.timelord.metrics.new_peak_received()
             elif (
                 self.timelord.last_state.peak is not None
                 and self.timelord.last_state.peak.reward_chain_block == new_peak.reward_chain_block
@@ -41,6 +42,7 @@ class TimelordAPI:
             else:
                 log.warning("block that we don't have, changing to it.")
                 self.timelord.new_peak = new_peak
+                self.timelord.metrics.new_peak_received()
                 self.timelord.new_subslot_end = None
 
     @api_request
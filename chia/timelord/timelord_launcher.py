@@ -4,7 +4,7 @@ import pathlib
 import signal
 import socket
 import time
-from typing import List
+from typing import Dict, List
 
 import pkg_resources
 
@@ -14,6 +14,9 @@ from chia.util.default_root import DEFAULT_ROOT_PATH
 from chia.util.setproctitle import setproctitle
 
 active_processes: List = []
+# Times each vdf_client process was restarted, and how many of its runs exited with an error, by process number
+restart_counts: Dict[int, int] = {}
+failure_counts: Dict[int, int] = {}
 stopped = False
 lock = asyncio.Lock()
 
@@ -70,7 +73,13 @@ async def spawn_process(host, port, counter):
                     first_10_seconds = False
             else:
                 log.error(f"VDF client {counter}: {stderr.decode().rstrip()}")
-        log.info(f"Process number {counter} ended.")
+        restart_counts[counter] = restart_counts.get(counter, 0) + 1
+        if proc.returncode != 0:
+            failure_counts[counter] = failure_counts.get(counter, 0) + 1
+        log.info(
+            f"Process number {counter} ended with code {proc.returncode}. Restarted {restart_counts[counter]} times, "
+            f"{failure_counts.get(counter, 0)} failures."
+        )
         async with lock:
             if proc in active_processes:
                 active_processes.remove(proc)
@@ -0,0 +1,92 @@
+import time
+from typing import Dict, Optional, Tuple
+
+from chia.timelord.types import Chain
+from chia.util.histogram import RollingHistogram
+
+# Histograms cover the last hour
+METRICS_WINDOW_SECONDS = 3600
+# Proofs take from a few seconds (signage points) up to a whole sub slot (end of slot)
+PROOF_LATENCY_BUCKETS = [1, 2.5, 5, 10, 20, 30, 60, 120, 300, 600]
+
+
+class TimelordMetrics:
+    """
+    Timing of the timelord's chains: the iterations per second of each chain, the time from submitting iterations to
+    a vdf_client until its proof arrives, and the time from receiving a new peak until the chains are reset to it.
+    """
+
+    def __init__(self):
+        # Estimated iterations per second of the last proof of each chain
+        self.ips: Dict[Chain, float] = {}
+        self.proofs: Dict[Chain, int] = {}
+        # When each (chain, iterations) was submitted to its vdf_client, cleared when the chains reset
+        self.submitted: Dict[Tuple[Chain, int], float] = {}
+        self.proof_latency: Dict[Chain, RollingHistogram] = {}
+        self.peak_reset_lag = RollingHistogram(METRICS_WINDOW_SECONDS)
+        self.new_peak_time: Optional[float] = None
+        self.chain_resets: int = 0
+        # Sessions started by vdf_clients from each ip. A vdf_client also reconnects for every new session when it is
+        # healthy, so this is not a restart count, those are only logged by the launcher.
+        self.vdf_client_sessions: Dict[str, int] = {}
+
+    def iterations_submitted(self, chain: Chain, iterations: int, now: Optional[float] = None) -> None:
+        self.submitted[(chain, int(iterations))] = time.time() if now is None else now
+
+    def proof_received(
+        self,
+        chain: Chain,
+        iterations: int,
+        ips: float,
+        submit_time: Optional[float] = None,
+        now: Optional[float] = None,
+    ) -> None:
+        """
+        submit_time is looked up from iterations_submitted, unless it is given
+        """
+        if now is None:
+            now = time.time()
+        self.ips[chain] = ips
+        self.proofs[chain] = self.proofs.get(chain, 0) + 1
+        if submit_time is None:
+            submit_time = self.submitted.pop((chain, int(iterations)), None)
+        if submit_time is not None:
+            if chain not in self.proof_latency:
+                self.proof_latency[chain] = RollingHistogram(METRICS_WINDOW_SECONDS, bounds=PROOF_LATENCY_BUCKETS)
+            self.proof_latency[chain].add(now - submit_time, now)
+
+    def new_peak_received(self, now: Optional[float] = None) -> None:
+        # Only the first peak since the last reset counts, later ones are handled by the same reset
+        if self.new_peak_time is None:
+            self.new_peak_time = time.time() if now is None else now
+
+    def chains_reset(self, now: Optional[float] = None) -> None:
+        if now is None:
+            now = time.time()
+        self.chain_resets += 1
+        self.submitted = {}
+        if self.new_peak_time is not None:
+            self.peak_reset_lag.add(now - self.new_peak_time, now)
+            self.new_peak_time = None
+
+    def vdf_client_connected(self, ip: str) -> None:
+        self.vdf_client_sessions[ip] = self.vdf_client_sessions.get(ip, 0) + 1
+
+    def to_json_dict(self, now: Optional[float] = None) -> Dict:
+        if now is None:
+            now = time.time()
+        return {
+            "chains": {
+                chain.name: {
+                    "ips": self.ips.get(chain, 0),
+                    "proofs": self.proofs.get(chain, 0),
+                    "proof_latency": (
+                        self.proof_latency[chain].histogram(now).to_json_dict() if chain in self.proof_latency else None
+                    ),
+                }
+                for chain in set(self.ips) | set(self.proof_latency)
+            },
+            "peak_reset_lag": self.peak_reset_lag.histogram(now).to_json_dict(),
+            "chain_resets": self.chain_resets,
+            "vdf_client_sessions": self.vdf_client_sessions,
+        }
@@ -0,0 +1,56 @@
+"""
+Framing of the messages between the timelord and a vdf_client.
+
+The timelord starts a session by sending the mode letter: S (compact proof for a bluebox), N (n-wesolowski) or
+T (two-wesolowski). In the text protocol the discriminant, the iterations and the proofs are sent as decimal or hex
+strings. If the letter is lowercase, the rest of the session uses the binary protocol instead:
+- discriminant: 2 byte big-endian length, followed by the absolute value of the discriminant, big-endian
+- iterations: 8 byte big-endian unsigned, 0 stops the vdf_client
+- proof: 4 byte big-endian length, followed by the raw proof fields, which the text protocol hex encodes
+The initial form, "OK", "STOP" and "ACK" are the same in both protocols.
+"""
+
+from typing import Tuple
+
+STOP_ITERATIONS = 0
+
+
+def encode_mode(sanitizer_mode: bool, fast_algorithm: bool, binary: bool) -> bytes:
+    if sanitizer_mode:
+        mode = b"S"
+    elif fast_algorithm:
+        mode = b"N"
+    else:
+        mode = b"T"
+    return mode.lower() if binary else mode
+
+
+def encode_discriminant(disc: str, binary: bool) -> bytes:
+    """
+    disc is the hex string returned by chiavdf's create_discriminant, the text protocol sends it as is
+    """
+    if binary:
+        magnitude = abs(int(disc, 16))
+        disc_bytes = magnitude.to_bytes((magnitude.bit_length() + 7) // 8, "big")
+        return len(disc_bytes).to_bytes(2, "big") + disc_bytes
+    return (str(len(disc)).zfill(3) + disc).encode()
+
+
+def encode_iterations(iterations: int, binary: bool) -> bytes:
+    if binary:
+        return iterations.to_bytes(8, "big")
+    iter_str = str(iterations)
+    return (str(len(iter_str)).zfill(2) + iter_str).encode()
+
+
+def decode_proof(payload: bytes, binary: bool) -> Tuple[int, bytes, int, bytes]:
+    """
+    Returns iterations, output (y), witness type and proof, from a proof received after its 4 byte length
+    """
+    data = memoryview(payload if binary else bytes.fromhex(payload.decode()))
+    iterations = int.from_bytes(data[0:8], "big", signed=True)
+    y_size = int.from_bytes(data[8:16], "big", signed=True)
+    y_bytes = bytes(data[16 : 16 + y_size])
+    witness_type = int.from_bytes(data[16 + y_size : 17 + y_size], "big", signed=True)
+    proof_bytes = bytes(data[17 + y_size :])
+    return iterations, y_bytes, witness_type, proof_bytes
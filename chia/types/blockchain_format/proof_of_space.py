@@ -1,6 +1,7 @@
 import logging
 from dataclasses import dataclass
-from typing import Optional
+from hashlib import sha256
+from typing import List, Optional
 
 from bitstring import BitArray
 from blspy import G1Element
@@ -75,6 +76,28 @@ class ProofOfSpace(Streamable):
         )
         return plot_filter[: constants.NUMBER_ZERO_BITS_PLOT_FILTER].uint == 0
 
+    @staticmethod
+    def plots_passing_filter(
+        constants: ConsensusConstants,
+        plot_ids: bytes,
+        challenge_hash: bytes32,
+        signage_point: bytes32,
+    ) -> List[int]:
+        """
+        Applies passes_plot_filter to plot_ids, the concatenation of many 32 byte plot ids, and returns the indices
+        of the plots that pass. This avoids building a BitArray for every plot.
+        """
+        zero_bits = constants.NUMBER_ZERO_BITS_PLOT_FILTER
+        prefix_len = (zero_bits + 7) // 8
+        shift = prefix_len * 8 - zero_bits
+        suffix = challenge_hash + signage_point
+        passing: List[int] = []
+        for index, start in enumerate(range(0, len(plot_ids) - 31, 32)):
+            digest = sha256(plot_ids[start : start + 32] + suffix).digest()
+            if int.from_bytes(digest[:prefix_len], "big") >> shift == 0:
+                passing.append(index)
+        return passing
+
     @staticmethod
     def calculate_plot_filter_input(plot_id: bytes32, challenge_hash: bytes32, signage_point: bytes32) -> bytes32:
         return std_hash(plot_id + challenge_hash + signage_point)
@@ -1,8 +1,11 @@
 import logging
+import multiprocessing
+import os
 import traceback
+from concurrent.futures import ThreadPoolExecutor
 from dataclasses import dataclass
 from enum import IntEnum
-from typing import Optional
+from typing import Dict, List, Optional, Tuple
 from functools import lru_cache
 
 from chiavdf import create_discriminant, verify_n_wesolowski
@@ -15,6 +18,10 @@ from chia.util.streamable import Streamable, streamable
 
 log = logging.getLogger(__name__)
 
+# Batches smaller than this are verified on the calling thread
+MIN_PARALLEL_VDF_BATCH = 2
+_vdf_executor: Optional[ThreadPoolExecutor] = None
+
 
 @lru_cache(maxsize=20)
 def get_discriminant(challenge, size_bites) -> int:
@@ -73,21 +80,66 @@ class VDFProof(Streamable):
             tb = traceback.format_stack()
             log.error(f"{tb} INVALID VDF INFO. Have: {info} Expected: {target_vdf_info}")
             return False
-        if self.witness_type + 1 > constants.MAX_VDF_WITNESS_SIZE:
-            return False
+        return batch_verify_vdfs(constants, [(self, input_el, info)])[0]
+
+
+def _get_vdf_executor() -> Optional[ThreadPoolExecutor]:
+    """
+    verify_n_wesolowski releases the GIL, so the threads verify in parallel. Only the main process gets a pool: the
+    block validation workers already run one process per core, and a pool in each of them would start cores^2 threads.
+    """
+    global _vdf_executor
+    if multiprocessing.current_process().name != "MainProcess":
+        return None
+    if _vdf_executor is None:
+        _vdf_executor = ThreadPoolExecutor(max_workers=os.cpu_count(), thread_name_prefix="vdf-verify-")
+    return _vdf_executor
+
+
+def _verify_vdf_args(args: Tuple[int, bytes100, bytes, uint64, int, uint8]) -> bool:
+    try:
+        return verify_vdf(*args)
+    except Exception:
+        return False
+
+
+def batch_verify_vdfs(
+    constants: ConsensusConstants,
+    proofs: List[Tuple[VDFProof, ClassgroupElement, VDFInfo]],
+) -> List[bool]:
+    """
+    Verifies many (proof, input, info) VDFs, returning one result per entry. Each discriminant is only created once
+    per batch, and in the main process the n-wesolowski verifications run on a thread pool.
+    """
+    results: List[bool] = [False] * len(proofs)
+    discriminants: Dict[bytes32, int] = {}
+    to_verify: List[Tuple[int, Tuple[int, bytes100, bytes, uint64, int, uint8]]] = []
+    for idx, (proof, input_el, info) in enumerate(proofs):
+        if proof.witness_type + 1 > constants.MAX_VDF_WITNESS_SIZE:
+            continue
         try:
-            disc: int = get_discriminant(info.challenge, constants.DISCRIMINANT_SIZE_BITS)
-            # TODO: parallelize somehow, this might included multiple mini proofs (n weso)
-            return verify_vdf(
-                disc,
+            if info.challenge not in discriminants:
+                discriminants[info.challenge] = get_discriminant(info.challenge, constants.DISCRIMINANT_SIZE_BITS)
+            args = (
+                discriminants[info.challenge],
                 input_el.data,
-                info.output.data + bytes(self.witness),
+                info.output.data + bytes(proof.witness),
                 info.number_of_iterations,
                 constants.DISCRIMINANT_SIZE_BITS,
-                self.witness_type,
+                proof.witness_type,
             )
         except Exception:
-            return False
+            continue
+        to_verify.append((idx, args))
+
+    executor = _get_vdf_executor() if len(to_verify) >= MIN_PARALLEL_VDF_BATCH else None
+    if executor is None:
+        verified = [_verify_vdf_args(args) for _, args in to_verify]
+    else:
+        verified = list(executor.map(_verify_vdf_args, [args for _, args in to_verify]))
+    for (idx, _), valid in zip(to_verify, verified):
+        results[idx] = valid
+    return results
 
 
 # Stores, for a given VDF, the field that uses it.
@@ -1,10 +1,10 @@
 from dataclasses import dataclass
-from typing import List, Optional, Set
+from typing import List, Optional, Set, Tuple
 from chia.types.blockchain_format.coin import Coin
 from chia.types.blockchain_format.foliage import Foliage, FoliageTransactionBlock, TransactionsInfo
 from chia.types.blockchain_format.program import SerializedProgram
 from chia.types.blockchain_format.reward_chain_block import RewardChainBlock
-from chia.types.blockchain_format.vdf import VDFProof
+from chia.types.blockchain_format.vdf import CompressibleVDFField, VDFInfo, VDFProof
 from chia.types.end_of_slot_bundle import EndOfSubSlotBundle
 from chia.util.ints import uint32
 from chia.util.streamable import Streamable, streamable
@@ -77,3 +77,37 @@ class FullBlock(Streamable):
         if self.challenge_chain_ip_proof.witness_type != 0 or not self.challenge_chain_ip_proof.normalized_to_identity:
             return False
         return True
+
+    def get_uncompact_vdfs(self) -> List[Tuple[CompressibleVDFField, VDFInfo]]:
+        """
+        The VDFs of the block whose proofs can still be replaced by compact ones, in the same order as the checks in
+        is_fully_compactified.
+        """
+        uncompact: List[Tuple[CompressibleVDFField, VDFInfo]] = []
+        for sub_slot in self.finished_sub_slots:
+            if (
+                sub_slot.proofs.challenge_chain_slot_proof.witness_type != 0
+                or not sub_slot.proofs.challenge_chain_slot_proof.normalized_to_identity
+            ):
+                uncompact.append(
+                    (CompressibleVDFField.CC_EOS_VDF, sub_slot.challenge_chain.challenge_chain_end_of_slot_vdf)
+                )
+            if sub_slot.proofs.infused_challenge_chain_slot_proof is not None and (
+                sub_slot.proofs.infused_challenge_chain_slot_proof.witness_type != 0
+                or not sub_slot.proofs.infused_challenge_chain_slot_proof.normalized_to_identity
+            ):
+                assert sub_slot.infused_challenge_chain is not None
+                uncompact.append(
+                    (
+                        CompressibleVDFField.ICC_EOS_VDF,
+                        sub_slot.infused_challenge_chain.infused_challenge_chain_end_of_slot_vdf,
+                    )
+                )
+        if self.challenge_chain_sp_proof is not None and (
+            self.challenge_chain_sp_proof.witness_type != 0 or not self.challenge_chain_sp_proof.normalized_to_identity
+        ):
+            assert self.reward_chain_block.challenge_chain_sp_vdf is not None
+            uncompact.append((CompressibleVDFField.CC_SP_VDF, self.reward_chain_block.challenge_chain_sp_vdf))
+        if self.challenge_chain_ip_proof.witness_type != 0 or not self.challenge_chain_ip_proof.normalized_to_identity:
+            uncompact.append((CompressibleVDFField.CC_IP_VDF, self.reward_chain_block.challenge_chain_ip_vdf))
+        return uncompact
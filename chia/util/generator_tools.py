@@ -37,6 +37,20 @@ def get_block_header(block: FullBlock, tx_addition_coins: List[Coin], removals_n
     )
 
 
+def batch_get_block_headers(
+    blocks_bytes: List[bytes], tx_additions: List[List[Coin]], removals: List[List[bytes32]]
+) -> List[bytes]:
+    """
+    Builds the serialized header blocks of serialized full blocks, to be run in a worker process
+    """
+    header_blocks: List[bytes] = []
+    for block_bytes, tx_addition_coins, removals_names in zip(blocks_bytes, tx_additions, removals):
+        header_blocks.append(
+            bytes(get_block_header(FullBlock.from_bytes(block_bytes), tx_addition_coins, removals_names))
+        )
+    return header_blocks
+
+
 def additions_for_npc(npc_list: List[NPC]) -> List[Coin]:
     additions: List[Coin] = []
 
@@ -0,0 +1,102 @@
+from bisect import bisect_left
+from typing import Dict, List, Optional, Sequence, Tuple
+
+# Upper bounds (in seconds) of the default latency buckets, the last bucket is unbounded
+DEFAULT_LATENCY_BUCKETS: List[float] = [0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60]
+
+
+class Histogram:
+    """
+    Fixed bucket histogram, with the same semantics as a Prometheus histogram. Adding a value is a binary search over
+    the bucket bounds, so it is cheap enough to call on every message.
+    """
+
+    def __init__(self, bounds: Optional[Sequence[float]] = None):
+        self.bounds: List[float] = list(DEFAULT_LATENCY_BUCKETS if bounds is None else bounds)
+        self.counts: List[int] = [0] * (len(self.bounds) + 1)
+        self.count: int = 0
+        self.total: float = 0
+        self.max: float = 0
+
+    def add(self, value: float) -> None:
+        self.counts[bisect_left(self.bounds, value)] += 1
+        self.count += 1
+        self.total += value
+        if value > self.max:
+            self.max = value
+
+    def mean(self) -> float:
+        if self.count == 0:
+            return 0
+        return self.total / self.count
+
+    def quantile(self, q: float) -> float:
+        """
+        Returns the upper bound of the bucket containing the q quantile (or the largest value seen, if it falls in
+        the last bucket).
+        """
+        if self.count == 0:
+            return 0
+        target = q * self.count
+        seen = 0
+        for i, bucket_count in enumerate(self.counts):
+            seen += bucket_count
+            if seen >= target and bucket_count > 0:
+                return self.bounds[i] if i < len(self.bounds) else self.max
+        return self.max
+
+    def to_json_dict(self) -> Dict:
+        return {
+            "bounds": self.bounds,
+            "counts": self.counts,
+            "count": self.count,
+            "sum": self.total,
+            "max": self.max,
+        }
+
+    def prometheus_lines(self, name: str, labels: str) -> List[str]:
+        lines = []
+        cumulative = 0
+        separator = "," if len(labels) > 0 else ""
+        for bound, bucket_count in zip(self.bounds + [float("inf")], self.counts):
+            cumulative += bucket_count
+            le = "+Inf" if bound == float("inf") else f"{bound}"
+            lines.append(f'{name}_bucket{{{labels}{separator}le="{le}"}} {cumulative}')
+        lines.append(f"{name}_sum{{{labels}}} {self.total}")
+        lines.append(f"{name}_count{{{labels}}} {self.count}")
+        return lines
+
+    def merge(self, other: "Histogram") -> None:
+        assert self.bounds == other.bounds
+        for i, bucket_count in enumerate(other.counts):
+            self.counts[i] += bucket_count
+        self.count += other.count
+        self.total += other.total
+        self.max = max(self.max, other.max)
+
+
+class RollingHistogram:
+    """
+    Histogram of the values added in the last window_seconds. It is kept as num_windows histograms that each cover a
+    part of the window, so old values are dropped a part at a time.
+    """
+
+    def __init__(self, window_seconds: float, num_windows: int = 6, bounds: Optional[Sequence[float]] = None):
+        self.bounds = bounds
+        self.window_seconds = window_seconds
+        self.part_seconds = window_seconds / num_windows
+        # (start time, histogram) of each part, oldest first
+        self.parts: List[Tuple[float, Histogram]] = []
+
+    def add(self, value: float, now: float) -> None:
+        if len(self.parts) == 0 or now - self.parts[-1][0] >= self.part_seconds:
+            self.parts = [part for part in self.parts if part[0] > now - self.window_seconds]
+            self.parts.append((now, Histogram(self.bounds)))
+        self.parts[-1][1].add(value)
+
+    def histogram(self, now: float) -> Histogram:
+        merged = Histogram(self.bounds)
+        for start, part in self.parts:
+            if start > now - self.window_seconds:
+                merged.merge(part)
+        return merged
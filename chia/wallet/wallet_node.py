@@ -4,10 +4,12 @@ import logging
 import socket
 import time
 import traceback
+from dataclasses import dataclass
 from pathlib import Path
 from typing import Callable, Dict, List, Optional, Set, Tuple, Union, Any
 
 from blspy import PrivateKey
+from chiabip158 import PyBIP158
 
 from chia.consensus.block_record import BlockRecord
 from chia.consensus.constants import ConsensusConstants
@@ -50,6 +52,15 @@ from chia.wallet.wallet_blockchain import ReceiveBlockResult
 from chia.wallet.wallet_state_manager import WalletStateManager
 
 
+@dataclass
+class PrefetchedCoins:
+    # Puzzle hashes and coin names that were requested for a block, and the coins returned, None if a request failed
+    puzzle_hashes: Set[bytes32]
+    additions: Optional[List[Coin]]
+    coin_names: Set[bytes32]
+    removals: Optional[List[Coin]]
+
+
 class WalletNode:
     key_config: Dict
     config: Dict
@@ -325,6 +336,10 @@ class WalletNode:
         if not self.has_full_node() and self.wallet_peers is not None:
             asyncio.create_task(self.wallet_peers.on_connect(peer))
 
+    def on_disconnect(self, peer: WSChiaConnection):
+        if self.wallet_state_manager is not None:
+            self.wallet_state_manager.sync_store.peer_disconnected(peer.peer_node_id)
+
     async def _periodically_check_full_node(self) -> None:
         tries = 0
         while not self._shut_down and tries < 5:
@@ -402,6 +417,7 @@ class WalletNode:
         if self.wallet_state_manager is None:
             return
 
+        self.wallet_state_manager.sync_store.peer_has_peak(peer.peer_node_id, peak.height)
         curr_peak = self.wallet_state_manager.blockchain.get_peak()
         if curr_peak is not None and curr_peak.weight >= peak.weight:
             return
@@ -585,34 +601,117 @@ class WalletNode:
                 fork_height = uint32(0)
             await self.wallet_state_manager.blockchain.warmup(fork_height)
             batch_size = self.constants.MAX_BLOCK_COUNT_PER_REQUESTS
+            batches = [
+                (uint32(i), uint32(min(peak_height, i + batch_size)))
+                for i in range(max(0, fork_height - 1), peak_height, batch_size)
+            ]
+            # Header blocks of the next batches are downloaded while a batch is validated, spread over the peers
+            lookahead = self.config.get("sync_lookahead_batches", 4)
+            prefetch: Dict[int, Tuple[WSChiaConnection, asyncio.Task]] = {}
             advanced_peak = False
-            for i in range(max(0, fork_height - 1), peak_height, batch_size):
-                start_height = i
-                end_height = min(peak_height, start_height + batch_size)
-                peers = self.server.get_full_node_connections()
-                added = False
-                for peer in peers:
-                    try:
-                        added, advanced_peak = await self.fetch_blocks_and_validate(
-                            peer, uint32(start_height), uint32(end_height), None if advanced_peak else fork_height
+            try:
+                for index, (start_height, end_height) in enumerate(batches):
+                    for ahead in range(index, min(len(batches), index + max(1, lookahead))):
+                        if ahead not in prefetch:
+                            self._prefetch_header_blocks(prefetch, ahead, *batches[ahead])
+                    added = False
+                    if index in prefetch:
+                        peer, task = prefetch.pop(index)
+                        try:
+                            header_blocks = await task
+                            if not peer.closed:
+                                added, advanced_peak = await self.fetch_blocks_and_validate(
+                                    peer,
+                                    start_height,
+                                    end_height,
+                                    None if advanced_peak else fork_height,
+                                    header_blocks,
+                                )
+                        except Exception as e:
+                            await peer.close()
+                            exc = traceback.format_exc()
+                            self.log.error(f"Error while trying to fetch from peer:{e} {exc}")
+                    if not added:
+                        for peer in self._peers_with_blocks(end_height):
+                            try:
+                                added, advanced_peak = await self.fetch_blocks_and_validate(
+                                    peer, start_height, end_height, None if advanced_peak else fork_height
+                                )
+                                if added:
+                                    break
+                            except Exception as e:
+                                await peer.close()
+                                exc = traceback.format_exc()
+                                self.log.error(f"Error while trying to fetch from peer:{e} {exc}")
+                    if not added:
+                        raise RuntimeError(f"Was not able to add blocks {start_height}-{end_height}")
+
+                    peak = self.wallet_state_manager.blockchain.get_peak()
+                    assert peak is not None
+                    self.wallet_state_manager.blockchain.clean_block_record(
+                        min(
+                            end_height - self.constants.BLOCKS_CACHE_SIZE,
+                            peak.height - self.constants.BLOCKS_CACHE_SIZE,
                         )
-                        if added:
-                            break
-                    except Exception as e:
-                        await peer.close()
-                        exc = traceback.format_exc()
-                        self.log.error(f"Error while trying to fetch from peer:{e} {exc}")
-                if not added:
-                    raise RuntimeError(f"Was not able to add blocks {start_height}-{end_height}")
-
-                peak = self.wallet_state_manager.blockchain.get_peak()
-                assert peak is not None
-                self.wallet_state_manager.blockchain.clean_block_record(
-                    min(
-                        end_height - self.constants.BLOCKS_CACHE_SIZE,
-                        peak.height - self.constants.BLOCKS_CACHE_SIZE,
                     )
-                )
+            finally:
+                for _, task in prefetch.values():
+                    task.cancel()
+                # Retrieves the errors of downloads that failed or were cancelled, so they are not logged as unhandled
+                await asyncio.gather(*[task for _, task in prefetch.values()], return_exceptions=True)
+
+    def _is_trusted(self, peer: WSChiaConnection) -> bool:
+        return (
+            self.full_node_peer is not None
+            and peer.peer_host == self.full_node_peer.host
+            or peer.peer_host == "127.0.0.1"
+        )
+
+    def _peers_with_blocks(self, end_height: uint32) -> List[WSChiaConnection]:
+        """
+        Full node peers that announced a peak at or above end_height. Any other peer would reject a request for the
+        blocks, and must not be disconnected for not having them.
+        """
+        assert self.server is not None and self.wallet_state_manager is not None
+        sync_store = self.wallet_state_manager.sync_store
+        peers: List[WSChiaConnection] = []
+        for peer in self.server.get_full_node_connections():
+            peak_height = sync_store.get_peer_peak_height(peer.peer_node_id)
+            if peak_height is not None and peak_height >= end_height:
+                peers.append(peer)
+        return peers
+
+    def _prefetch_header_blocks(
+        self,
+        prefetch: Dict[int, Tuple[WSChiaConnection, asyncio.Task]],
+        index: int,
+        start_height: uint32,
+        end_height: uint32,
+    ) -> None:
+        """
+        Starts downloading a batch of header blocks from a peer that has them. Trusted peers are preferred, since their
+        blocks are not pre-validated, otherwise consecutive batches come from different peers.
+        """
+        peers = self._peers_with_blocks(end_height)
+        trusted_peers = [peer for peer in peers if self._is_trusted(peer)]
+        if len(trusted_peers) > 0:
+            peers = trusted_peers
+        if len(peers) == 0:
+            return
+        peer = peers[index % len(peers)]
+        prefetch[index] = (peer, asyncio.create_task(self._fetch_header_blocks(peer, start_height, end_height)))
+
+    async def _fetch_header_blocks(
+        self, peer: WSChiaConnection, height_start: uint32, height_end: uint32
+    ) -> List[HeaderBlock]:
+        self.log.info(f"Requesting blocks {height_start}-{height_end}")
+        request = RequestHeaderBlocks(uint32(height_start), uint32(height_end))
+        res: Optional[RespondHeaderBlocks] = await peer.request_header_blocks(request)
+        if res is None or not isinstance(res, RespondHeaderBlocks):
+            raise ValueError("Peer returned no response")
+        if res.header_blocks is None:
+            raise ValueError(f"No response from peer {peer}")
+        return res.header_blocks
 
     async def fetch_blocks_and_validate(
         self,
@@ -620,28 +719,19 @@ class WalletNode:
         height_start: uint32,
         height_end: uint32,
         fork_point_with_peak: Optional[uint32],
+        header_blocks: Optional[List[HeaderBlock]] = None,
     ) -> Tuple[bool, bool]:
         """
-        Returns whether the blocks validated, and whether the peak was advanced
-
+        Returns whether the blocks validated, and whether the peak was advanced. header_blocks are requested from the
+        peer, unless they were already downloaded from it.
         """
         if self.wallet_state_manager is None:
             return False, False
 
-        self.log.info(f"Requesting blocks {height_start}-{height_end}")
-        request = RequestHeaderBlocks(uint32(height_start), uint32(height_end))
-        res: Optional[RespondHeaderBlocks] = await peer.request_header_blocks(request)
-        if res is None or not isinstance(res, RespondHeaderBlocks):
-            raise ValueError("Peer returned no response")
-        header_blocks: List[HeaderBlock] = res.header_blocks
-        advanced_peak = False
         if header_blocks is None:
-            raise ValueError(f"No response from peer {peer}")
-        if (
-            self.full_node_peer is not None
-            and peer.peer_host == self.full_node_peer.host
-            or peer.peer_host == "127.0.0.1"
-        ):
+            header_blocks = await self._fetch_header_blocks(peer, height_start, height_end)
+        advanced_peak = False
+        if self._is_trusted(peer):
             trusted = True
             pre_validation_results: Optional[List[PreValidationResult]] = None
         else:
@@ -653,6 +743,7 @@ class WalletNode:
                 return False, advanced_peak
             assert len(header_blocks) == len(pre_validation_results)
 
+        prefetched = await self._prefetch_additions_removals(peer, header_blocks, fork_point_with_peak)
         for i in range(len(header_blocks)):
             header_block = header_blocks[i]
             if not trusted and pre_validation_results is not None and pre_validation_results[i].error is not None:
@@ -666,12 +757,27 @@ class WalletNode:
                 )
 
                 # Get Additions
-                added_coins = await self.get_additions(peer, header_block, additions)
+                block_prefetched = prefetched.get(header_block.header_hash)
+                added_coins: Optional[List[Coin]] = None
+                if block_prefetched is not None and block_prefetched.additions is not None:
+                    if block_prefetched.puzzle_hashes.issuperset(additions):
+                        added_puzzle_hashes = set(additions)
+                        added_coins = [c for c in block_prefetched.additions if c.puzzle_hash in added_puzzle_hashes]
+                if added_coins is None:
+                    added_coins = await self.get_additions(peer, header_block, additions)
                 if added_coins is None:
                     raise ValueError("Failed to fetch additions")
 
                 # Get removals
-                removed_coins = await self.get_removals(peer, header_block, added_coins, removals)
+                removed_coins: Optional[List[Coin]] = None
+                if block_prefetched is not None and block_prefetched.removals is not None:
+                    if block_prefetched.coin_names.issuperset(removals) and not await self._needs_all_removals(
+                        added_coins
+                    ):
+                        removed_names = set(removals)
+                        removed_coins = [c for c in block_prefetched.removals if c.name() in removed_names]
+                if removed_coins is None:
+                    removed_coins = await self.get_removals(peer, header_block, added_coins, removals)
                 if removed_coins is None:
                     raise ValueError("Failed to fetch removals")
 
@@ -701,6 +807,61 @@ class WalletNode:
             await self.wallet_state_manager.create_more_puzzle_hashes()
         return True, advanced_peak
 
+    async def _prefetch_additions_removals(
+        self, peer: WSChiaConnection, header_blocks: List[HeaderBlock], fork_point_with_peak: Optional[uint32]
+    ) -> Dict[bytes32, PrefetchedCoins]:
+        """
+        Requests the additions and removals of all the transaction blocks in a batch at the same time, with at most
+        sync_parallel_requests requests in flight. Which coins are of interest depends on the blocks before, so this
+        requests every puzzle hash and coin that might be. Before a block is added, the coins it really needs are
+        taken from here if they were all requested, and requested on their own otherwise.
+        """
+        assert self.wallet_state_manager is not None
+        parallel_requests = self.config.get("sync_parallel_requests", 10)
+        transaction_blocks = [hb for hb in header_blocks if hb.is_transaction_block]
+        if parallel_requests <= 1 or len(transaction_blocks) == 0:
+            return {}
+        semaphore = asyncio.Semaphore(parallel_requests)
+
+        trade_removals, trade_additions = await self.wallet_state_manager.trade_manager.get_coins_of_interest()
+        puzzle_hashes: Set[bytes32] = set(self.wallet_state_manager.puzzle_store.all_puzzle_hashes)
+        puzzle_hashes.update(coin.puzzle_hash for coin in trade_additions.values())
+        coin_records = await self.wallet_state_manager.coin_store.get_unspent_coins_at_height(fork_point_with_peak)
+        coin_names: Set[bytes32] = {record.name() for record in coin_records}
+        coin_names.update(trade_removals.keys())
+
+        filters = {hb.header_hash: PyBIP158([b for b in hb.transactions_filter]) for hb in transaction_blocks}
+        prefetched: Dict[bytes32, PrefetchedCoins] = {
+            hb.header_hash: PrefetchedCoins(
+                {ph for ph in puzzle_hashes if filters[hb.header_hash].Match(bytearray(ph))}, None, set(), None
+            )
+            for hb in transaction_blocks
+        }
+
+        async def fetch_additions(header_block: HeaderBlock) -> None:
+            entry = prefetched[header_block.header_hash]
+            async with semaphore:
+                entry.additions = await self.get_additions(peer, header_block, list(entry.puzzle_hashes))
+
+        await asyncio.gather(*[fetch_additions(hb) for hb in transaction_blocks])
+
+        async def fetch_removals(header_block: HeaderBlock) -> None:
+            entry = prefetched[header_block.header_hash]
+            async with semaphore:
+                entry.removals = await self.get_removals(peer, header_block, [], list(entry.coin_names))
+
+        # Coins added earlier in the batch can be spent by a later block
+        for hb in transaction_blocks:
+            tx_filter = filters[hb.header_hash]
+            entry = prefetched[hb.header_hash]
+            entry.coin_names = {name for name in coin_names if tx_filter.Match(bytearray(name))}
+            if entry.additions is None:
+                # The additions request failed, so the coins of interest are not known
+                break
+            coin_names.update(coin.name() for coin in entry.additions)
+        await asyncio.gather(*[fetch_removals(hb) for hb in transaction_blocks])
+        return prefetched
+
     def validate_additions(
         self,
         coins: List[Tuple[bytes32, List[Coin]]],
@@ -838,10 +999,8 @@ class WalletNode:
             added_coins = []
             return added_coins
 
-    async def get_removals(self, peer: WSChiaConnection, block_i, additions, removals) -> Optional[List[Coin]]:
+    async def _needs_all_removals(self, additions: List[Coin]) -> bool:
         assert self.wallet_state_manager is not None
-        request_all_removals = False
-        # Check if we need all removals
         for coin in additions:
             puzzle_store = self.wallet_state_manager.puzzle_store
             record_info: Optional[DerivationRecord] = await puzzle_store.get_derivation_record_for_puzzle_hash(
@@ -849,11 +1008,14 @@ class WalletNode:
             )
             if record_info is not None and record_info.wallet_type == WalletType.COLOURED_COIN:
                 # TODO why ?
-                request_all_removals = True
-                break
+                return True
             if record_info is not None and record_info.wallet_type == WalletType.DISTRIBUTED_ID:
-                request_all_removals = True
-                break
+                return True
+        return False
+
+    async def get_removals(self, peer: WSChiaConnection, block_i, additions, removals) -> Optional[List[Coin]]:
+        # Check if we need all removals
+        request_all_removals = await self._needs_all_removals(additions)
 
         if len(removals) > 0 or request_all_removals:
             if request_all_removals:
@@ -142,7 +142,7 @@ class WalletStateManager:
             self.reorg_rollback,
             self.lock,
         )
-        self.weight_proof_handler = WeightProofHandler(self.constants, self.blockchain)
+        self.weight_proof_handler = WeightProofHandler(self.constants, self.blockchain, self.blockchain.pool)
 
         self.sync_mode = False
         self.sync_store = await WalletSyncStore.create()
@@ -940,6 +940,8 @@ class WalletStateManager:
     async def close_all_stores(self) -> None:
         if self.blockchain is not None:
             self.blockchain.shut_down()
+        if self.weight_proof_handler is not None:
+            self.weight_proof_handler.shut_down()
         await self.db_connection.close()
 
     async def clear_all_stores(self):
@@ -26,6 +26,8 @@ class WalletSyncStore:
     header_hashes_added: Dict[uint32, bytes32]
     # map from potential peak to fork point
     peak_fork_point: Dict[bytes32, uint32]
+    # Height of the last peak each full node peer announced, only those peers are asked for blocks up to it
+    peer_to_peak_height: Dict[bytes32, uint32]
 
     @classmethod
     async def create(cls) -> "WalletSyncStore":
@@ -39,6 +41,7 @@ class WalletSyncStore:
         self.potential_future_blocks = []
         self.header_hashes_added = {}
         self.peak_fork_point = {}
+        self.peer_to_peak_height = {}
         return self
 
     def set_sync_mode(self, sync_mode: bool) -> None:
@@ -85,3 +88,12 @@ class WalletSyncStore:
 
     def get_header_hashes_added(self, height: uint32) -> Optional[bytes32]:
         return self.header_hashes_added.get(height, None)
+
+    def peer_has_peak(self, peer_id: bytes32, height: uint32) -> None:
+        self.peer_to_peak_height[peer_id] = height
+
+    def get_peer_peak_height(self, peer_id: bytes32) -> Optional[uint32]:
+        return self.peer_to_peak_height.get(peer_id, None)
+
+    def peer_disconnected(self, peer_id: bytes32) -> None:
+        self.peer_to_peak_height.pop(peer_id, None)
@@ -10,6 +10,7 @@ from chia.consensus.blockchain import Blockchain
 from chia.full_node.block_store import BlockStore
 from chia.full_node.coin_store import CoinStore
 from chia.util.db_wrapper import DBWrapper
+from chia.util.ints import uint32
 from tests.setup_nodes import bt, test_constants
 
 
@@ -82,6 +83,44 @@ class TestBlockStore:
         db_filename.unlink()
         db_filename_2.unlink()
 
+    @pytest.mark.asyncio
+    async def test_uncompact_vdfs(self):
+        blocks = bt.get_consecutive_blocks(10)
+        db_filename = Path("blockchain_test.db")
+        if db_filename.exists():
+            db_filename.unlink()
+        connection = await aiosqlite.connect(db_filename)
+        try:
+            db_wrapper = DBWrapper(connection)
+            coin_store = await CoinStore.create(db_wrapper)
+            store = await BlockStore.create(db_wrapper)
+            bc = await Blockchain.create(coin_store, store, test_constants)
+            for block in blocks:
+                await bc.receive_block(block)
+
+            expected = set()
+            for block in blocks:
+                for field_vdf, vdf_info in block.get_uncompact_vdfs():
+                    expected.add((block.header_hash, block.height, field_vdf, vdf_info))
+            assert len(expected) > 0
+            assert set(await store.get_uncompact_vdfs(blocks[-1].height, 1000)) == expected
+            assert len(await store.get_uncompact_vdfs(blocks[-1].height, 3)) == 3
+            assert all(height <= 4 for _, height, _, _ in await store.get_uncompact_vdfs(uint32(4), 1000))
+
+            # The index of a new database is filled as blocks are added, backfilling finds nothing new
+            assert await store.backfill_uncompact_vdfs(uint32(0), 1000) is None
+            assert await store.get_uncompact_vdfs_backfill_height() is None
+            assert set(await store.get_uncompact_vdfs(blocks[-1].height, 1000)) == expected
+
+            await store.remove_uncompact_vdfs([blocks[1].header_hash])
+            assert all(hh != blocks[1].header_hash for hh, _, _, _ in await store.get_uncompact_vdfs(uint32(10), 1000))
+            # Backfilling in small steps indexes the blocks again
+            assert await store.backfill_uncompact_vdfs(uint32(0), 2) == 2
+            assert set(await store.get_uncompact_vdfs(blocks[-1].height, 1000)) == expected
+        finally:
+            await connection.close()
+            db_filename.unlink()
+
     @pytest.mark.asyncio
     async def test_deadlock(self):
         """
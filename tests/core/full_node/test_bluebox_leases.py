@@ -0,0 +1,157 @@
+import asyncio
+from secrets import token_bytes
+from typing import Dict, List
+
+import pytest
+
+from chia.full_node.bluebox_leases import BlueboxLeases
+from chia.full_node.compact_proof_queue import CompactProofQueue
+from chia.full_node.full_node import FullNode
+from chia.protocols.full_node_protocol import RespondCompactVDF
+from chia.protocols.timelord_protocol import RequestCompactProofOfTime
+from chia.server.outbound_message import Message, NodeType
+from chia.server.server import capabilities_from_config
+from chia.server.ws_connection import WSChiaConnection
+from chia.types.blockchain_format.classgroup import ClassgroupElement
+from chia.types.blockchain_format.sized_bytes import bytes32
+from chia.types.blockchain_format.vdf import CompressibleVDFField, VDFInfo, VDFProof
+from chia.util.ints import uint8, uint32, uint64
+
+
+def make_work(count: int):
+    return [
+        RequestCompactProofOfTime(
+            VDFInfo(bytes32(token_bytes(32)), uint64(1000), ClassgroupElement.get_default_element()),
+            bytes32(token_bytes(32)),
+            uint32(i),
+            uint8(CompressibleVDFField.CC_IP_VDF),
+        )
+        for i in range(count)
+    ]
+
+
+FULL_NODE_CONFIG = {"send_uncompact_interval": 30}
+
+
+class FakeTimelordConnection:
+    has_capability = WSChiaConnection.has_capability
+
+    def __init__(self, timelord_config: Dict):
+        self.peer_node_id = bytes32(token_bytes(32))
+        self.connection_type = NodeType.TIMELORD
+        self.local_capabilities = capabilities_from_config(FULL_NODE_CONFIG)
+        self.peer_capabilities = capabilities_from_config(timelord_config)
+
+
+class FakeBlockchain:
+    def seen_compact_proofs(self, vdf_info: VDFInfo, height: uint32) -> bool:
+        return False
+
+
+class FakeServer:
+    def __init__(self, connections: List[FakeTimelordConnection]):
+        self.connections = connections
+        self.sent: Dict[bytes32, List[Message]] = {}
+
+    def get_connections(self):
+        return self.connections
+
+    async def send_to_specific(self, messages: List[Message], node_id: bytes32):
+        self.sent.setdefault(node_id, []).extend(messages)
+
+
+@pytest.fixture(scope="module")
+def event_loop():
+    loop = asyncio.get_event_loop()
+    yield loop
+
+
+class TestBlueboxLeases:
+    def test_disjoint_leases(self):
+        leases = BlueboxLeases(lease_seconds=100)
+        work = make_work(10)
+        timelord_1, timelord_2 = bytes32(token_bytes(32)), bytes32(token_bytes(32))
+        assignments = leases.assign(work, [timelord_1, timelord_2], 4, now=1000)
+        assert len(assignments[timelord_1]) == 4
+        assert len(assignments[timelord_2]) == 4
+        assert len(set(assignments[timelord_1]) & set(assignments[timelord_2])) == 0
+
+        # Both are at capacity, so nothing is leased until work completes
+        assert leases.assign(work, [timelord_1, timelord_2], 4, now=1001) == {timelord_1: [], timelord_2: []}
+        done = assignments[timelord_1][0]
+        leases.complete(done.header_hash, done.field_vdf, done.new_proof_of_time, None, now=1002)
+        work.remove(done)
+        reassigned = leases.assign(work, [timelord_1, timelord_2], 4, now=1003)[timelord_1]
+        assert len(reassigned) == 1
+        assert reassigned[0] not in assignments[timelord_2]
+        assert len(leases.unleased(work)) == 1
+
+        stats = leases.to_json_dict(now=1004)["timelords"][timelord_1.hex()]
+        assert stats["completed"] == 1
+        assert stats["proofs_per_hour"] == 1
+
+    def test_expiry_and_disconnect(self):
+        leases = BlueboxLeases(lease_seconds=100)
+        work = make_work(4)
+        timelord_1, timelord_2 = bytes32(token_bytes(32)), bytes32(token_bytes(32))
+        assert len(leases.assign(work, [timelord_1], 2, now=1000)[timelord_1]) == 2
+
+        # Expired leases are given to another timelord
+        assert len(leases.assign(work, [timelord_2], 4, now=1100)[timelord_2]) == 4
+        assert leases.to_json_dict(now=1100)["timelords"][timelord_1.hex()]["expired"] == 2
+
+        leases.remove_timelord(timelord_2)
+        assert len(leases.unleased(work)) == 4
+
+    @pytest.mark.asyncio
+    async def test_proof_from_full_node_releases_lease(self):
+        full_node = FullNode.__new__(FullNode)
+        full_node.bluebox_leases = BlueboxLeases(lease_seconds=100)
+        full_node.compact_proof_queue = CompactProofQueue()
+        full_node.blockchain = FakeBlockchain()
+
+        async def can_accept_compact_proof(*args):
+            return True
+
+        full_node._can_accept_compact_proof = can_accept_compact_proof
+        work = make_work(2)
+        timelord = bytes32(token_bytes(32))
+        full_node.bluebox_leases.assign(work, [timelord], 2)
+
+        done = work[0]
+        request = RespondCompactVDF(
+            done.height,
+            done.header_hash,
+            done.field_vdf,
+            done.new_proof_of_time,
+            VDFProof(uint8(0), b"", True),
+        )
+        await full_node.respond_compact_vdf(request, FakeTimelordConnection({}))
+        assert len(full_node.compact_proof_queue) == 1
+        assert full_node.bluebox_leases.unleased(work) == [done]
+        # The bluebox did not make the proof, so it gets no credit
+        stats = full_node.bluebox_leases.to_json_dict()["timelords"][timelord.hex()]
+        assert stats["active_leases"] == 1
+        assert stats["completed"] == 0
+
+    @pytest.mark.asyncio
+    async def test_only_blueboxes_get_leases(self):
+        bluebox = FakeTimelordConnection({"sanitizer_mode": True, "bluebox_leases": True})
+        timelord = FakeTimelordConnection({"sanitizer_mode": False, "bluebox_leases": True})
+        full_node = FullNode.__new__(FullNode)
+        full_node.bluebox_leases = BlueboxLeases(lease_seconds=100)
+        full_node.server = FakeServer([bluebox, timelord])
+
+        work = make_work(10)
+        await full_node._send_uncompact_vdfs(work, 4)
+        assert full_node.bluebox_leases.active_leases(bluebox.peer_node_id) == 4
+        assert full_node.bluebox_leases.active_leases(timelord.peer_node_id) == 0
+        assert timelord.peer_node_id.hex() not in full_node.bluebox_leases.to_json_dict()["timelords"]
+        # The timelord that does not take leases only gets unleased work
+        sent = full_node.server.sent
+        leased = {m.data for m in sent[bluebox.peer_node_id]}
+        unleased = {m.data for m in sent[timelord.peer_node_id]}
+        assert leased | unleased <= {bytes(w) for w in work}
+        assert len(leased) == 4
+        assert len(unleased) == 4
+        assert len(leased & unleased) == 0
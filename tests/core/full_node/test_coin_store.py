@@ -171,6 +171,34 @@ class TestCoinStore:
             await connection.close()
             Path("fndb_test.db").unlink()
 
+    @pytest.mark.asyncio
+    async def test_get_coins_in_range(self):
+        blocks = bt.get_consecutive_blocks(9, [])
+
+        db_path = Path("fndb_test.db")
+        if db_path.exists():
+            db_path.unlink()
+        connection = await aiosqlite.connect(db_path)
+        db_wrapper = DBWrapper(connection)
+        coin_store = await CoinStore.create(db_wrapper, cache_size=uint32(0))
+
+        for block in blocks:
+            if block.is_transaction_block():
+                await coin_store.new_block(block, [], [])
+                # Spend the reward coins of the block at the next height
+                for coin in block.get_included_reward_coins():
+                    await coin_store._set_spent(coin.name(), uint32(block.height + 1))
+
+        added = await coin_store.get_coins_added_in_range(uint32(0), uint32(len(blocks)))
+        removed = await coin_store.get_coins_removed_in_range(uint32(0), uint32(len(blocks)))
+        for height in range(len(blocks) + 1):
+            assert added.get(uint32(height), []) == await coin_store.get_coins_added_at_height(uint32(height))
+            assert removed.get(uint32(height), []) == await coin_store.get_coins_removed_at_height(uint32(height))
+        assert len(removed) > 0
+
+        await connection.close()
+        Path("fndb_test.db").unlink()
+
     @pytest.mark.asyncio
     async def test_rollback(self):
         blocks = bt.get_consecutive_blocks(20)
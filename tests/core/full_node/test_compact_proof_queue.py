@@ -0,0 +1,37 @@
+from secrets import token_bytes
+
+from chia.full_node.compact_proof_queue import MAX_BLOCKS_PER_BATCH, CompactProofQueue, PendingCompactProof
+from chia.types.blockchain_format.classgroup import ClassgroupElement
+from chia.types.blockchain_format.sized_bytes import bytes32
+from chia.types.blockchain_format.vdf import CompressibleVDFField, VDFInfo, VDFProof
+from chia.util.ints import uint8, uint32, uint64
+
+
+def queue_proofs(queue: CompactProofQueue, block_count: int):
+    header_hashes = []
+    for height in range(block_count):
+        header_hash = bytes32(token_bytes(32))
+        vdf_info = VDFInfo(bytes32(token_bytes(32)), uint64(1000), ClassgroupElement.get_default_element())
+        proof = PendingCompactProof(VDFProof(uint8(0), b"", True), uint32(height), None)
+        assert queue.add(header_hash, CompressibleVDFField.CC_IP_VDF, vdf_info, proof)
+        header_hashes.append(header_hash)
+    return header_hashes
+
+
+class TestCompactProofQueue:
+    def test_batches_are_limited(self):
+        queue = CompactProofQueue()
+        header_hashes = queue_proofs(queue, MAX_BLOCKS_PER_BATCH + 50)
+
+        # The blocks queued first are written first, the rest is left for the next batch
+        batch = queue.pop_batch()
+        assert list(batch.keys()) == header_hashes[:MAX_BLOCKS_PER_BATCH]
+        assert len(queue) == 50
+
+        queue.requeue(batch)
+        assert len(queue) == MAX_BLOCKS_PER_BATCH + 50
+
+        assert len(queue.pop_batch(10)) == 10
+        assert len(queue.pop_batch()) == MAX_BLOCKS_PER_BATCH
+        assert len(queue.pop_batch()) == 40
+        assert len(queue) == 0
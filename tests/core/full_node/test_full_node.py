@@ -14,7 +14,7 @@ from chia.full_node.bundle_tools import detect_potential_template_generator
 from chia.full_node.full_node_api import FullNodeAPI
 from chia.full_node.signage_point import SignagePoint
 from chia.protocols import full_node_protocol as fnp, full_node_protocol
-from chia.protocols import timelord_protocol
+from chia.protocols import timelord_protocol, wallet_protocol
 from chia.protocols.full_node_protocol import RespondTransaction
 from chia.protocols.protocol_message_types import ProtocolMessageTypes
 from chia.server.address_manager import AddressManager
@@ -1088,6 +1088,36 @@ class TestFullNodeProtocol:
         assert fetched_blocks[-1].transactions_generator is not None
         assert std_hash(fetched_blocks[-1]) == std_hash(blocks_t[-1])
 
+    @pytest.mark.asyncio
+    async def test_request_header_blocks(self, wallet_nodes):
+        full_node_1, full_node_2, server_1, server_2, wallet_a, wallet_receiver = wallet_nodes
+        blockchain = full_node_1.full_node.blockchain
+        peak_height = blockchain.get_peak_height()
+        start, end = uint32(peak_height - 5), uint32(peak_height)
+        built = await blockchain.get_header_blocks_in_range(start, end)
+        header_blocks = [built[blockchain.height_to_hash(uint32(h))] for h in range(start, end + 1)]
+        assert any(hb.is_transaction_block for hb in header_blocks)
+
+        # The responses are serialized from the stored bytes, the first request also builds and stores them
+        for _ in range(2):
+            res = await full_node_1.request_header_blocks(wallet_protocol.RequestHeaderBlocks(start, end))
+            assert res.type == ProtocolMessageTypes.respond_header_blocks.value
+            assert res.data == bytes(wallet_protocol.RespondHeaderBlocks(start, end, header_blocks))
+
+            res = await full_node_1.request_block_header(wallet_protocol.RequestBlockHeader(end))
+            assert res.type == ProtocolMessageTypes.respond_block_header.value
+            assert res.data == bytes(wallet_protocol.RespondBlockHeader(header_blocks[-1]))
+
+        # Header blocks built while compact proofs are written to their blocks are served, but not stored
+        full_node = full_node_1.full_node
+        older = [blockchain.height_to_hash(uint32(h)) for h in range(start - 6, start - 1)]
+        await full_node.header_block_store.remove_header_blocks(older)
+        full_node.compact_proof_writes += 1
+        res = await full_node_1.request_header_blocks(wallet_protocol.RequestHeaderBlocks(start - 6, start - 2))
+        full_node.compact_proof_writes += 1
+        assert res.type == ProtocolMessageTypes.respond_header_blocks.value
+        assert await full_node.header_block_store.get_header_blocks_bytes(older) == {}
+
     @pytest.mark.asyncio
     async def test_new_unfinished_block(self, wallet_nodes):
         full_node_1, full_node_2, server_1, server_2, wallet_a, wallet_receiver = wallet_nodes
@@ -1484,6 +1514,23 @@ class TestFullNodeProtocol:
         assert cc_eos_count == 3 and icc_eos_count == 3
         for compact_proof in timelord_protocol_finished:
             await full_node_1.full_node.respond_compact_proof_of_time(compact_proof)
+        # Queued, and written to the blocks in one batch
+        assert len(full_node_1.full_node.compact_proof_queue) == len(timelord_protocol_finished)
+
+        # Proofs that fail to be written are kept for the next batch
+        block_store = full_node_1.full_node.block_store
+
+        async def add_full_block_fails(*args):
+            raise RuntimeError("disk full")
+
+        block_store.add_full_block = add_full_block_fails
+        with pytest.raises(RuntimeError):
+            await full_node_1.full_node._apply_compact_proofs()
+        del block_store.add_full_block
+        assert len(full_node_1.full_node.compact_proof_queue) == len(timelord_protocol_finished)
+
+        await full_node_1.full_node._apply_compact_proofs()
+        assert len(full_node_1.full_node.compact_proof_queue) == 0
         stored_blocks = await full_node_1.get_all_full_blocks()
         cc_eos_compact_count = 0
         icc_eos_compact_count = 0
@@ -1727,6 +1774,7 @@ class TestFullNodeProtocol:
             await full_node_1.full_node.respond_compact_proof_of_time(invalid_compact_proof)
         for invalid_compact_proof in full_node_protocol_invalid_messaages:
             await full_node_1.full_node.respond_compact_vdf(invalid_compact_proof, peer)
+        assert len(full_node_1.full_node.compact_proof_queue) == 0
         stored_blocks = await full_node_1.get_all_full_blocks()
         for block in stored_blocks:
             for sub_slot in block.finished_sub_slots:
@@ -0,0 +1,46 @@
+import asyncio
+from pathlib import Path
+from secrets import token_bytes
+
+import aiosqlite
+import pytest
+
+from chia.full_node.header_block_store import HeaderBlockStore
+from chia.types.blockchain_format.sized_bytes import bytes32
+from chia.util.db_wrapper import DBWrapper
+from chia.util.ints import uint32
+
+
+@pytest.fixture(scope="module")
+def event_loop():
+    loop = asyncio.get_event_loop()
+    yield loop
+
+
+class TestHeaderBlockStore:
+    @pytest.mark.asyncio
+    async def test_rollback_and_remove(self):
+        db_filename = Path("header_block_store_test.db")
+        if db_filename.exists():
+            db_filename.unlink()
+        connection = await aiosqlite.connect(db_filename)
+        try:
+            store = await HeaderBlockStore.create(DBWrapper(connection))
+            header_hashes = [bytes32(token_bytes(32)) for _ in range(5)]
+            await store.add_header_blocks(
+                [(header_hash, uint32(height), bytes([height])) for height, header_hash in enumerate(header_hashes)]
+            )
+            stored = await store.get_header_blocks_bytes(header_hashes)
+            assert [stored[header_hash] for header_hash in header_hashes] == [bytes([h]) for h in range(5)]
+
+            await store.rollback_to_height(uint32(2))
+            assert set((await store.get_header_blocks_bytes(header_hashes)).keys()) == set(header_hashes[:3])
+
+            await store.remove_header_blocks([header_hashes[1]])
+            assert set((await store.get_header_blocks_bytes(header_hashes)).keys()) == {
+                header_hashes[0],
+                header_hashes[2],
+            }
+        finally:
+            await connection.close()
+            db_filename.unlink()
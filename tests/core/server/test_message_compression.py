@@ -0,0 +1,57 @@
+import unittest
+import zlib
+from hashlib import sha256
+
+from chia.protocols.protocol_message_types import ProtocolMessageTypes
+from chia.server.message_compression import (
+    COMPRESSION_THRESHOLD,
+    MAX_DECOMPRESSED_SIZE,
+    Codec,
+    compress_payload,
+    decompress_payload,
+    should_compress,
+    uncompressed_payload,
+)
+
+
+class TestMessageCompression(unittest.TestCase):
+    def test_should_compress(self):
+        assert should_compress(ProtocolMessageTypes.respond_blocks.value, COMPRESSION_THRESHOLD)
+        assert not should_compress(ProtocolMessageTypes.respond_blocks.value, COMPRESSION_THRESHOLD - 1)
+        assert not should_compress(ProtocolMessageTypes.new_peak.value, 10 * COMPRESSION_THRESHOLD)
+
+    def test_round_trip(self):
+        data = bytes(range(256)) * 1000
+        compressed, _ = compress_payload(data)
+        assert compressed[0] == Codec.ZLIB
+        assert len(compressed) < len(data)
+        assert decompress_payload(compressed)[0] == data
+
+        assert decompress_payload(uncompressed_payload(data))[0] == data
+        assert decompress_payload(uncompressed_payload(b""))[0] == b""
+
+    def test_incompressible(self):
+        data = b"".join(sha256(bytes([i % 256, i // 256])).digest() for i in range(2000))
+        compressed, _ = compress_payload(data)
+        assert compressed[0] == Codec.NONE
+        assert decompress_payload(compressed)[0] == data
+
+    def test_invalid(self):
+        assert decompress_payload(b"")[0] is None
+        assert decompress_payload(bytes([5]) + b"abc")[0] is None
+        assert decompress_payload(bytes([Codec.ZLIB]) + b"not zlib")[0] is None
+        truncated, _ = compress_payload(bytes(100000))
+        assert decompress_payload(truncated[:-10])[0] is None
+
+        # Decompression bombs are rejected
+        bomb = bytes([Codec.ZLIB]) + zlib.compress(bytes(MAX_DECOMPRESSED_SIZE + 1))
+        assert decompress_payload(bomb)[0] is None
+
+    def test_max_size(self):
+        data = bytes(1000)
+        compressed, _ = compress_payload(data)
+        assert decompress_payload(compressed, 1000)[0] == data
+        assert decompress_payload(compressed, 999)[0] is None
+        # Only the message type's max size is inflated, not the whole bomb
+        bomb = bytes([Codec.ZLIB]) + zlib.compress(bytes(10 * 1024 * 1024))
+        assert decompress_payload(bomb, 512)[0] is None
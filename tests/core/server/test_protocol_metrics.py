@@ -0,0 +1,50 @@
+import unittest
+
+from chia.protocols.protocol_message_types import ProtocolMessageTypes
+from chia.server.protocol_metrics import ProtocolMetrics
+from chia.util.histogram import Histogram
+
+
+class TestProtocolMetrics(unittest.TestCase):
+    def test_histogram(self):
+        histogram = Histogram([0.1, 1, 10])
+        assert histogram.quantile(0.5) == 0
+        for value in [0.05, 0.1, 0.5, 5, 50]:
+            histogram.add(value)
+        assert histogram.counts == [2, 1, 1, 1]
+        assert histogram.count == 5
+        assert histogram.max == 50
+        assert histogram.quantile(0.4) == 0.1
+        assert histogram.quantile(0.6) == 1
+        assert histogram.quantile(1) == 50
+
+        lines = histogram.prometheus_lines("latency", 'a="b"')
+        assert 'latency_bucket{a="b",le="0.1"} 2' in lines
+        assert 'latency_bucket{a="b",le="+Inf"} 5' in lines
+        assert 'latency_count{a="b"} 5' in lines
+
+    def test_protocol_metrics(self):
+        metrics = ProtocolMetrics()
+        peak = ProtocolMessageTypes.new_peak.value
+        blocks = ProtocolMessageTypes.request_blocks.value
+        metrics.message_received(peak, 100)
+        metrics.message_received(peak, 50)
+        metrics.handler_finished(peak, 0.002, False)
+        metrics.handler_finished(peak, 0.2, True)
+        metrics.message_sent(blocks, 10)
+        metrics.request_finished(blocks, 1.5, False)
+        metrics.request_finished(blocks, 60, True)
+
+        json_dict = metrics.to_json_dict()
+        assert json_dict["new_peak"]["messages_received"] == 2
+        assert json_dict["new_peak"]["bytes_received"] == 150
+        assert json_dict["new_peak"]["handler_latency"]["count"] == 2
+        assert json_dict["new_peak"]["handler_errors"] == 1
+        assert json_dict["request_blocks"]["bytes_sent"] == 10
+        assert json_dict["request_blocks"]["request_rtt"]["count"] == 1
+        assert json_dict["request_blocks"]["request_timeouts"] == 1
+
+        text = metrics.to_prometheus()
+        assert 'chia_protocol_bytes_received_total{message_type="new_peak"} 150' in text
+        assert 'chia_protocol_handler_latency_seconds_count{message_type="new_peak"} 2' in text
+        assert 'chia_protocol_request_rtt_seconds_count{message_type="request_blocks"} 1' in text
@@ -261,3 +261,37 @@ class TestRateLimits:
 
         new_signatures_message = make_msg(ProtocolMessageTypes.respond_signatures, bytes([1]))
         assert not r.process_msg_and_check(new_signatures_message)
+
+    @pytest.mark.asyncio
+    async def test_continuous_refill(self):
+        # Tokens come back gradually, not all at once at the end of the period
+        r = RateLimiter(True, 10)
+        new_peak_message = make_msg(ProtocolMessageTypes.new_peak, bytes([1] * 40))
+        for i in range(200):
+            assert r.process_msg_and_check(new_peak_message)
+        assert not r.process_msg_and_check(new_peak_message)
+
+        # Incoming messages that were over the limit are still counted, so we need to wait a bit longer than one
+        # message's worth of tokens
+        await asyncio.sleep(1)
+        assert r.process_msg_and_check(new_peak_message)
+
+    @pytest.mark.asyncio
+    async def test_burst_percentage(self):
+        r = RateLimiter(False, 60, 100, 10)
+        new_peak_message = make_msg(ProtocolMessageTypes.new_peak, bytes([1] * 40))
+        for i in range(20):
+            assert r.process_msg_and_check(new_peak_message)
+        assert not r.process_msg_and_check(new_peak_message)
+        assert r.seconds_until_allowed(new_peak_message) > 0
+
+        # A single message larger than the burst can still be sent, once the bucket is full
+        r = RateLimiter(False, 60, 30, 10)
+        block_message = make_msg(ProtocolMessageTypes.respond_block, bytes([1] * 2 * 1024 * 1024))
+        assert r.seconds_until_allowed(block_message) == 0
+        assert r.process_msg_and_check(block_message)
+        assert not r.process_msg_and_check(block_message)
+
+        # Messages above the maximum size are never allowed
+        too_large_message = make_msg(ProtocolMessageTypes.respond_block, bytes([1] * 3 * 1024 * 1024))
+        assert r.seconds_until_allowed(too_large_message) is None
@@ -0,0 +1,145 @@
+import asyncio
+import logging
+import zlib
+from collections import deque
+from secrets import token_bytes
+from typing import Deque, List, Optional
+
+import pytest
+from aiohttp import WSCloseCode, WSMessage, WSMsgType
+
+from chia.protocols.protocol_message_types import ProtocolMessageTypes
+from chia.server.message_compression import Codec, compress_payload
+from chia.server.outbound_message import Message, NodeType
+from chia.server.ws_connection import WSChiaConnection
+from chia.types.blockchain_format.sized_bytes import bytes32
+from chia.util.ints import uint8, uint16
+
+
+class FakeTransport:
+    def get_extra_info(self, name: str):
+        return ("1.2.3.4", 8444)
+
+
+class FakeWriter:
+    transport = FakeTransport()
+
+
+class FakeWebSocket:
+    def __init__(self):
+        self._writer = FakeWriter()
+        self._closed = False
+        self.close_code: Optional[WSCloseCode] = None
+        self.received: Deque[WSMessage] = deque()
+
+    async def receive(self, timeout: float) -> WSMessage:
+        return self.received.popleft()
+
+    async def close(self, code: WSCloseCode, message: bytes):
+        self._closed = True
+        self.close_code = code
+
+
+def make_connection() -> WSChiaConnection:
+    closed: List[WSChiaConnection] = []
+    connection = WSChiaConnection(
+        NodeType.FULL_NODE,
+        FakeWebSocket(),
+        8444,
+        logging.getLogger(__name__),
+        True,
+        False,
+        "1.2.3.4",
+        asyncio.Queue(),
+        lambda c, ban_time: closed.append(c),
+        bytes32(token_bytes(32)),
+        100,
+        30,
+        message_compression=True,
+    )
+    connection.compression_negotiated = True
+    return connection
+
+
+async def receive(connection: WSChiaConnection, message_type: ProtocolMessageTypes, payload: bytes):
+    message = Message(uint8(message_type.value), None, payload)
+    connection.ws.received.append(WSMessage(WSMsgType.BINARY, bytes(message), None))
+    return await connection._read_one_message()
+
+
+@pytest.fixture(scope="module")
+def event_loop():
+    loop = asyncio.get_event_loop()
+    yield loop
+
+
+class TestWSConnection:
+    @pytest.mark.asyncio
+    async def test_compressed_message(self):
+        connection = make_connection()
+        data = bytes(100000)
+        compressed, _ = compress_payload(data)
+        message = await receive(connection, ProtocolMessageTypes.respond_block_header, compressed)
+        assert message is not None
+        assert message.data == data
+        assert not connection.closed
+
+    @pytest.mark.asyncio
+    async def test_decompression_bomb(self):
+        # Decompresses to one byte more than the max size of the message type
+        connection = make_connection()
+        bomb = bytes([Codec.ZLIB]) + zlib.compress(bytes(500 * 1024 + 1))
+        assert await receive(connection, ProtocolMessageTypes.respond_block_header, bomb) is None
+        assert connection.closed
+        assert connection.ws.close_code == WSCloseCode.PROTOCOL_ERROR
+
+    @pytest.mark.asyncio
+    async def test_compressed_message_of_type_never_compressed(self):
+        connection = make_connection()
+        payload = bytes([Codec.ZLIB]) + zlib.compress(bytes(100))
+        assert await receive(connection, ProtocolMessageTypes.new_peak, payload) is None
+        assert connection.closed
+        assert connection.ws.close_code == WSCloseCode.PROTOCOL_ERROR
+
+    @pytest.mark.asyncio
+    async def test_uncompressed_message(self):
+        connection = make_connection()
+        message = Message(uint8(ProtocolMessageTypes.new_peak.value), uint16(5), bytes([Codec.NONE]) + b"peak")
+        connection.ws.received.append(WSMessage(WSMsgType.BINARY, bytes(message), None))
+        received = await connection._read_one_message()
+        assert received == Message(uint8(ProtocolMessageTypes.new_peak.value), uint16(5), b"peak")
+
+    @pytest.mark.asyncio
+    async def test_request_timeout(self):
+        connection = make_connection()
+        message = Message(uint8(ProtocolMessageTypes.request_peers.value), None, b"")
+        request = asyncio.create_task(connection.create_request(message, 1))
+        await asyncio.sleep(0.1)
+        assert len(connection.pending_requests) == 1
+        future = next(iter(connection.pending_requests.values()))
+        assert not future.done()
+
+        assert await request is None
+        assert future.done() and future.result() is None
+        assert connection.pending_requests == {}
+        assert connection.request_deadlines == []
+        assert connection.request_timeout_handle is None
+
+    @pytest.mark.asyncio
+    async def test_request_nonces_in_use_are_skipped(self):
+        connection = make_connection()
+        loop = asyncio.get_running_loop()
+        # Outbound connections use the nonces 0 to 2**15 - 1, only 100 is free
+        for nonce in range(2 ** 15):
+            if nonce != 100:
+                connection.pending_requests[uint16(nonce)] = loop.create_future()
+        message = Message(uint8(ProtocolMessageTypes.request_peers.value), None, b"")
+        request = asyncio.create_task(connection.create_request(message, 1))
+        sent = await connection.outgoing_queue.get()
+        assert sent.id == 100
+        assert await request is None
+
+        # Every nonce is in use
+        connection.pending_requests[uint16(100)] = loop.create_future()
+        with pytest.raises(ValueError):
+            await connection.create_request(message, 1)
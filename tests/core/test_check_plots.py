@@ -0,0 +1,48 @@
+import os
+
+from chia.plotting.check_plots import PlotCheckCheckpoint
+
+
+def make_result(plot_path, num_start: int, num_end: int):
+    stat_info = os.stat(plot_path)
+    return {
+        "filename": str(plot_path),
+        "file_size": stat_info.st_size,
+        "mtime_ns": stat_info.st_mtime_ns,
+        "challenge_start": num_start,
+        "challenge_end": num_end,
+        "valid": True,
+    }
+
+
+class TestPlotCheckCheckpoint:
+    def test_resume(self, tmp_path):
+        plot_1 = tmp_path / "plot-1.plot"
+        plot_2 = tmp_path / "plot-2.plot"
+        plot_1.write_bytes(b"1")
+        plot_2.write_bytes(b"2")
+        checkpoint = PlotCheckCheckpoint(tmp_path / "checkpoint.jsonl", 0, 30)
+        checkpoint.add(make_result(plot_1, 0, 30))
+        checkpoint.add(make_result(plot_2, 0, 30))
+        with open(tmp_path / "checkpoint.jsonl", "a") as f:
+            f.write('{"filename": "cut off')
+
+        plot_2.write_bytes(b"22")
+        resumed = PlotCheckCheckpoint(tmp_path / "checkpoint.jsonl", 0, 30)
+        resumed.load()
+        assert resumed.get(plot_1)["valid"]
+        # Changed since it was checked
+        assert resumed.get(plot_2) is None
+
+        # Results added after resuming are not lost to the cut off line
+        plot_3 = tmp_path / "plot-3.plot"
+        plot_3.write_bytes(b"3")
+        resumed.add(make_result(plot_3, 0, 30))
+        resumed_again = PlotCheckCheckpoint(tmp_path / "checkpoint.jsonl", 0, 30)
+        resumed_again.load()
+        assert resumed_again.get(plot_1)["valid"]
+        assert resumed_again.get(plot_3)["valid"]
+
+        other_challenges = PlotCheckCheckpoint(tmp_path / "checkpoint.jsonl", 30, 60)
+        other_challenges.load()
+        assert other_challenges.get(plot_1) is None
@@ -0,0 +1,164 @@
+import asyncio
+import logging
+import time
+from secrets import token_bytes
+from typing import Dict, List
+
+import pytest
+from blspy import G1Element
+
+from chia.farmer.farmer import SIGNATURE_BATCH_DELAY, Farmer
+from chia.farmer.farmer_api import FarmerAPI
+from chia.farmer.signage_point_store import SignagePointStore
+from chia.harvester.harvester_api import HarvesterAPI
+from chia.protocols.farmer_protocol import NewSignagePoint, RequestSignedValues
+from chia.protocols.harvester_protocol import (
+    RequestSignatures,
+    RequestSignaturesBatch,
+    RespondSignatures,
+    RespondSignaturesBatch,
+)
+from chia.protocols.protocol_message_types import ProtocolMessageTypes
+from chia.server.outbound_message import Message
+from chia.server.server import capabilities_from_config
+from chia.server.ws_connection import WSChiaConnection
+from chia.types.blockchain_format.sized_bytes import bytes32
+from chia.util.histogram import Histogram
+from chia.util.ints import uint8, uint64
+
+
+class FakeHarvesterConnection:
+    has_capability = WSChiaConnection.has_capability
+
+    def __init__(self, harvester_config: Dict, fail: bool = False):
+        self.peer_node_id = bytes32(token_bytes(32))
+        self.local_capabilities = capabilities_from_config({"batch_signatures": True})
+        self.peer_capabilities = capabilities_from_config(harvester_config)
+        self.fail = fail
+        self.sent: List[Message] = []
+
+    async def send_message(self, message: Message):
+        if self.fail:
+            raise ConnectionError("closed")
+        self.sent.append(message)
+
+
+class FakeServer:
+    def __init__(self, connections: List[FakeHarvesterConnection]):
+        self.all_connections = {connection.peer_node_id: connection for connection in connections}
+
+
+def make_farmer(connections: List[FakeHarvesterConnection]) -> Farmer:
+    farmer = Farmer.__new__(Farmer)
+    farmer.log = logging.getLogger(__name__)
+    farmer.server = FakeServer(connections)
+    farmer.sp_store = SignagePointStore(expiry_seconds=100, bucket_seconds=10, max_signage_points=100)
+    farmer.pending_signature_requests = {}
+    farmer.declare_proof_latency = Histogram()
+    return farmer
+
+
+def make_request(sp_hash: bytes32) -> RequestSignatures:
+    return RequestSignatures(token_bytes(32).hex(), bytes32(token_bytes(32)), sp_hash, [bytes32(token_bytes(32))])
+
+
+def make_response(plot_identifier: str) -> RespondSignatures:
+    return RespondSignatures(
+        plot_identifier, bytes32(token_bytes(32)), bytes32(token_bytes(32)), G1Element(), G1Element(), []
+    )
+
+
+@pytest.fixture(scope="module")
+def event_loop():
+    loop = asyncio.get_event_loop()
+    yield loop
+
+
+class TestFarmerSignatureBatch:
+    @pytest.mark.asyncio
+    async def test_batches_proofs_of_one_sp(self):
+        harvester = FakeHarvesterConnection({"batch_signatures": True})
+        farmer = make_farmer([harvester])
+        sp_hash_1, sp_hash_2 = bytes32(token_bytes(32)), bytes32(token_bytes(32))
+        requests = [make_request(sp_hash_1) for _ in range(3)]
+        for request in requests:
+            await farmer.request_signatures(harvester.peer_node_id, request)
+        await farmer.request_signatures(harvester.peer_node_id, make_request(sp_hash_2))
+        assert len(harvester.sent) == 0
+
+        await asyncio.sleep(SIGNATURE_BATCH_DELAY * 5)
+        assert [m.type for m in harvester.sent] == [ProtocolMessageTypes.request_signatures_batch.value] * 2
+        assert RequestSignaturesBatch.from_bytes(harvester.sent[0].data).requests == requests
+        assert farmer.pending_signature_requests == {}
+
+    @pytest.mark.asyncio
+    async def test_no_capability_and_block_signatures_are_not_batched(self):
+        old_harvester = FakeHarvesterConnection({})
+        harvester = FakeHarvesterConnection({"batch_signatures": True})
+        farmer = make_farmer([old_harvester, harvester])
+        sp_hash = bytes32(token_bytes(32))
+        await farmer.request_signatures(old_harvester.peer_node_id, make_request(sp_hash))
+        await farmer.request_signatures(old_harvester.peer_node_id, make_request(sp_hash))
+        assert [m.type for m in old_harvester.sent] == [ProtocolMessageTypes.request_signatures.value] * 2
+
+        # The signatures of a block go out right away, even to a harvester that takes batches
+        sp = NewSignagePoint(
+            bytes32(token_bytes(32)), sp_hash, bytes32(token_bytes(32)), uint64(1), uint64(1024), uint8(1)
+        )
+        farmer.sp_store.add_signage_point(sp)
+        quality = bytes32(token_bytes(32))
+        identifiers = ("plot", sp.challenge_hash, sp_hash, harvester.peer_node_id)
+        farmer.sp_store.add_proof(farmer.sp_store.get(sp_hash), "plot", None, quality, identifiers)
+        await FarmerAPI(farmer).request_signed_values(
+            RequestSignedValues(quality, bytes32(token_bytes(32)), bytes32(token_bytes(32)))
+        )
+        assert [m.type for m in harvester.sent] == [ProtocolMessageTypes.request_signatures.value]
+
+    @pytest.mark.asyncio
+    async def test_send_error_is_logged(self, caplog):
+        harvester = FakeHarvesterConnection({"batch_signatures": True}, fail=True)
+        farmer = make_farmer([harvester])
+        await farmer.request_signatures(harvester.peer_node_id, make_request(bytes32(token_bytes(32))))
+        await asyncio.sleep(SIGNATURE_BATCH_DELAY * 5)
+        assert "Error sending 1 signature requests" in caplog.text
+
+    @pytest.mark.asyncio
+    async def test_harvester_signs_batch(self):
+        harvester_api = HarvesterAPI(None)
+        # Plots that are gone are left out of the response
+        harvester_api._sign = lambda request: (
+            None if request.plot_identifier == "missing" else make_response(request.plot_identifier)
+        )
+        sp_hash = bytes32(token_bytes(32))
+        requests = [make_request(sp_hash), make_request(sp_hash)]
+        missing = RequestSignatures("missing", bytes32(token_bytes(32)), sp_hash, [])
+        msg = await harvester_api.request_signatures_batch(RequestSignaturesBatch(requests + [missing]))
+        assert msg.type == ProtocolMessageTypes.respond_signatures_batch.value
+        responses = RespondSignaturesBatch.from_bytes(msg.data).responses
+        assert [r.plot_identifier for r in responses] == [r.plot_identifier for r in requests]
+
+        assert await harvester_api.request_signatures_batch(RequestSignaturesBatch([missing])) is None
+
+    @pytest.mark.asyncio
+    async def test_farmer_handles_batch_response(self):
+        farmer = make_farmer([])
+        farmer_api = FarmerAPI(farmer)
+        handled: List[str] = []
+
+        async def respond_signatures(response: RespondSignatures):
+            if response.plot_identifier == "bad":
+                raise ValueError("bad signature")
+            handled.append(response.plot_identifier)
+
+        farmer_api.respond_signatures = respond_signatures
+        # One bad response does not lose the others
+        await farmer_api.respond_signatures_batch(
+            RespondSignaturesBatch([make_response("a"), make_response("bad"), make_response("b")])
+        )
+        assert handled == ["a", "b"]
+
+    def test_declare_proof_latency(self):
+        farmer = make_farmer([])
+        farmer.add_declare_proof_latency(time.time() - 0.3)
+        assert farmer.declare_proof_latency.count == 1
+        assert 0.3 <= farmer.declare_proof_latency.max < 10
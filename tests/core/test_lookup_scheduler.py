@@ -0,0 +1,100 @@
+import asyncio
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+import pytest
+
+from chia.harvester.lookup_scheduler import (
+    PRIORITY_FULL_PROOF,
+    PRIORITY_QUALITIES,
+    LookupScheduler,
+    max_lookups_per_device,
+)
+
+
+class TestLookupScheduler:
+    @pytest.mark.asyncio
+    async def test_limits_lookups_per_device(self):
+        running = {1: 0, 2: 0}
+        most_running = {1: 0, 2: 0}
+        lock = threading.Lock()
+
+        def lookup(device: int) -> int:
+            with lock:
+                running[device] += 1
+                most_running[device] = max(most_running[device], running[device])
+            time.sleep(0.01)
+            with lock:
+                running[device] -= 1
+            return device
+
+        with ThreadPoolExecutor(max_workers=8) as executor:
+            scheduler = LookupScheduler(executor, 2)
+            results = await asyncio.gather(
+                *[scheduler.run(device, "plots", PRIORITY_QUALITIES, lookup, device) for device in [1, 2] * 6]
+            )
+        assert results == [1, 2] * 6
+        assert most_running == {1: 2, 2: 2}
+        stats = {disk["device"]: disk for disk in scheduler.get_device_stats()}
+        assert stats["0:1"]["latencies"]["qualities"]["count"] == 6
+        assert stats["0:2"]["directories"] == ["plots"]
+
+    @pytest.mark.asyncio
+    async def test_single_device(self):
+        # All plots behind one mount share a device, the default limit then still uses every thread
+        config = {"num_threads": 6}
+        assert max_lookups_per_device(config) == 6
+        assert max_lookups_per_device({"num_threads": 6, "max_lookups_per_disk": 2}) == 2
+        assert max_lookups_per_device({"num_threads": 6, "max_lookups_per_disk": 10}) == 6
+
+        running = 0
+        most_running = 0
+        lock = threading.Lock()
+        all_running = threading.Barrier(6, timeout=10)
+
+        def lookup() -> None:
+            nonlocal running, most_running
+            with lock:
+                running += 1
+                most_running = max(most_running, running)
+            all_running.wait()
+            with lock:
+                running -= 1
+
+        with ThreadPoolExecutor(max_workers=config["num_threads"]) as executor:
+            scheduler = LookupScheduler(executor, max_lookups_per_device(config))
+            await asyncio.gather(*[scheduler.run(1, "mergerfs", PRIORITY_QUALITIES, lookup) for _ in range(12)])
+        assert most_running == 6
+
+    @pytest.mark.asyncio
+    async def test_qualities_before_full_proofs(self):
+        order = []
+        release = threading.Event()
+
+        def block():
+            release.wait()
+
+        with ThreadPoolExecutor(max_workers=2) as executor:
+            scheduler = LookupScheduler(executor, 1)
+            blocker = asyncio.ensure_future(scheduler.run(1, "plots", PRIORITY_QUALITIES, block))
+            await asyncio.sleep(0)
+            lookups = [
+                asyncio.ensure_future(scheduler.run(1, "plots", PRIORITY_FULL_PROOF, order.append, "proof")),
+                asyncio.ensure_future(scheduler.run(1, "plots", PRIORITY_QUALITIES, order.append, "qualities")),
+            ]
+            await asyncio.sleep(0)
+            release.set()
+            await asyncio.gather(blocker, *lookups)
+        assert order == ["qualities", "proof"]
+
+    @pytest.mark.asyncio
+    async def test_exceptions_are_raised(self):
+        def fail():
+            raise ValueError("bad plot")
+
+        with ThreadPoolExecutor(max_workers=1) as executor:
+            scheduler = LookupScheduler(executor, 1)
+            with pytest.raises(ValueError):
+                await scheduler.run(1, "plots", PRIORITY_QUALITIES, fail)
+            assert await scheduler.run(1, "plots", PRIORITY_QUALITIES, len, "ok") == 2
@@ -0,0 +1,51 @@
+from pathlib import Path
+
+from chia.harvester.lookup_stats import MIN_LOOKUPS, LookupStats
+from chia.util.histogram import RollingHistogram
+
+
+class TestLookupStats:
+    def test_slow_plots_and_directories(self):
+        stats = LookupStats(budget=1.0)
+        fast_plot = Path("/fast/plot-1.plot")
+        slow_plot = Path("/slow/plot-2.plot")
+        for _ in range(MIN_LOOKUPS):
+            stats.add(fast_plot, 0.1, None, 0.2)
+            stats.add(slow_plot, 1.5, 0.5, 2.5)
+
+        result = stats.to_json_dict()
+        assert list(result["slow_plots"].keys()) == [str(slow_plot)]
+        directories = {directory["directory"]: directory for directory in result["directories"]}
+        assert not directories["/fast"]["slow"]
+        assert directories["/slow"]["slow"] and directories["/slow"]["slow_plots"] == 1
+        assert directories["/slow"]["full_proof"]["count"] == MIN_LOOKUPS
+        assert directories["/fast"]["full_proof"]["count"] == 0
+
+        # Once most recent lookups are fast again, the plot is no longer slow
+        for _ in range(MIN_LOOKUPS + 1):
+            stats.add(slow_plot, 0.1, None, 0.2)
+        assert stats.to_json_dict()["slow_plots"] == {}
+
+    def test_removed_plots_are_forgotten(self):
+        stats = LookupStats(budget=1.0)
+        stats.add(Path("/plots/plot-1.plot"), 0.1, None, 0.2)
+        stats.add(Path("/plots/plot-2.plot"), 0.1, None, 0.2)
+        stats.add(Path("/removed/plot-3.plot"), 0.1, None, 0.2)
+        stats.remove_missing({Path("/plots/plot-2.plot")})
+        assert stats.get_plot(Path("/plots/plot-1.plot")) is None
+        assert stats.get_plot(Path("/plots/plot-2.plot")) is not None
+        assert stats.get_plot(Path("/removed/plot-3.plot")) is None
+        assert [directory["directory"] for directory in stats.to_json_dict()["directories"]] == ["/plots"]
+
+        stats.remove_missing(set())
+        assert stats.plots == {} and stats.directories == {}
+
+    def test_rolling_histogram_drops_old_values(self):
+        histogram = RollingHistogram(60, num_windows=6)
+        histogram.add(1, now=0)
+        histogram.add(2, now=30)
+        assert histogram.histogram(now=30).count == 2
+        assert histogram.histogram(now=65).count == 1
+        histogram.add(3, now=100)
+        assert histogram.histogram(now=100).count == 1
+        assert len(histogram.parts) == 1
@@ -0,0 +1,67 @@
+import os
+from secrets import token_bytes
+
+from blspy import AugSchemeMPL
+
+from chia.plotting.plot_cache import PlotCache, PlotCacheEntry
+from chia.types.blockchain_format.sized_bytes import bytes32
+from chia.util.ints import uint8, uint64
+
+
+def make_entry(plot_path, plot_id: bytes32) -> PlotCacheEntry:
+    stat_info = os.stat(plot_path)
+    return PlotCacheEntry(
+        str(plot_path),
+        uint64(stat_info.st_size),
+        uint64(stat_info.st_mtime_ns),
+        plot_id,
+        uint8(32),
+        None,
+        bytes32(token_bytes(32)),
+        AugSchemeMPL.key_gen(token_bytes(32)).get_g1(),
+        AugSchemeMPL.key_gen(token_bytes(32)).get_g1(),
+    )
+
+
+class TestPlotCache:
+    def test_round_trip(self, tmp_path):
+        plot_path = tmp_path / "plot-1.plot"
+        plot_path.write_bytes(b"1")
+        entry = make_entry(plot_path, bytes32(token_bytes(32)))
+
+        cache = PlotCache(tmp_path / "cache" / "plot_cache.dat")
+        cache.put(entry)
+        cache.save()
+
+        loaded = PlotCache(tmp_path / "cache" / "plot_cache.dat")
+        loaded.load()
+        assert loaded.get(plot_path, os.stat(plot_path)) == entry
+
+    def test_changed_file_is_not_used(self, tmp_path):
+        plot_path = tmp_path / "plot-1.plot"
+        plot_path.write_bytes(b"1")
+        cache = PlotCache(tmp_path / "plot_cache.dat")
+        cache.put(make_entry(plot_path, bytes32(token_bytes(32))))
+
+        plot_path.write_bytes(b"12")
+        assert cache.get(plot_path, os.stat(plot_path)) is None
+
+    def test_remove_missing(self, tmp_path):
+        paths = [tmp_path / f"plot-{i}.plot" for i in range(3)]
+        cache = PlotCache(tmp_path / "plot_cache.dat")
+        for path in paths:
+            path.write_bytes(b"1")
+            cache.put(make_entry(path, bytes32(token_bytes(32))))
+        cache.save()
+        assert not cache.changed
+
+        cache.remove_missing({str(paths[0]), str(paths[2])})
+        assert cache.changed
+        assert set(cache.entries.keys()) == {str(paths[0]), str(paths[2])}
+
+    def test_corrupt_cache_is_ignored(self, tmp_path):
+        cache_path = tmp_path / "plot_cache.dat"
+        cache_path.write_bytes(b"not a cache")
+        cache = PlotCache(cache_path)
+        cache.load()
+        assert cache.entries == {}
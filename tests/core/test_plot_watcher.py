@@ -0,0 +1,43 @@
+import sys
+
+import pytest
+
+from chia.plotting.plot_watcher import PlotDirectoryWatcher
+
+
+@pytest.mark.skipif(not sys.platform.startswith("linux"), reason="inotify is only available on Linux")
+class TestPlotDirectoryWatcher:
+    def test_reports_plot_changes(self, tmp_path):
+        changes = []
+        watcher = PlotDirectoryWatcher.create(lambda added, removed, rescan: changes.append((added, removed, rescan)))
+        assert watcher is not None
+        try:
+            watcher.watch([tmp_path])
+            (tmp_path / "plot-1.plot").write_bytes(b"1")
+            (tmp_path / "plot-2.plot").write_bytes(b"2")
+            (tmp_path / "notes.txt").write_bytes(b"3")
+            (tmp_path / "plot-2.plot").rename(tmp_path / "plot-3.plot")
+            (tmp_path / "plot-1.plot").unlink()
+            watcher._read_events()
+
+            assert changes == [
+                ({tmp_path / "plot-3.plot"}, {tmp_path / "plot-1.plot", tmp_path / "plot-2.plot"}, False)
+            ]
+        finally:
+            watcher.close()
+
+    def test_removed_directory_needs_rescan(self, tmp_path):
+        plot_dir = tmp_path / "plots"
+        plot_dir.mkdir()
+        changes = []
+        watcher = PlotDirectoryWatcher.create(lambda added, removed, rescan: changes.append((added, removed, rescan)))
+        assert watcher is not None
+        try:
+            watcher.watch([plot_dir])
+            plot_dir.rmdir()
+            watcher._read_events()
+
+            assert changes == [(set(), set(), True)]
+            assert watcher.directories == {}
+        finally:
+            watcher.close()
@@ -0,0 +1,200 @@
+import asyncio
+import logging
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+from secrets import token_bytes
+from typing import Dict, List, Optional
+
+import pytest
+from blspy import G1Element
+
+from chia.consensus.default_constants import DEFAULT_CONSTANTS
+from chia.consensus.pot_iterations import calculate_sp_interval_iters
+from chia.farmer.farmer import Farmer
+from chia.farmer.farmer_api import MAX_POS_PER_SP, FarmerAPI
+from chia.farmer.signage_point_store import SignagePointStore
+from chia.harvester.harvester import Harvester
+from chia.harvester.harvester_api import HarvesterAPI
+from chia.harvester.lookup_scheduler import LookupScheduler
+from chia.harvester.lookup_stats import LookupStats
+from chia.plotting.plot_tools import PlotInfo
+from chia.protocols.farmer_protocol import NewSignagePoint
+from chia.protocols.harvester_protocol import NewQualityHarvester, NewSignagePointHarvester, RequestProofOfSpace
+from chia.protocols.protocol_message_types import ProtocolMessageTypes
+from chia.server.outbound_message import Message
+from chia.server.server import capabilities_from_config
+from chia.server.ws_connection import WSChiaConnection
+from chia.types.blockchain_format.proof_of_space import ProofOfSpace
+from chia.types.blockchain_format.sized_bytes import bytes32
+from chia.util.ints import uint8, uint64
+
+# Every plot passes the plot filter
+CONSTANTS = DEFAULT_CONSTANTS.replace(NUMBER_ZERO_BITS_PLOT_FILTER=0)
+# Large enough for any quality of a k32 plot at difficulty 1 to be good enough
+SUB_SLOT_ITERS = uint64(2 ** 40)
+
+
+class FakeFarmerConnection:
+    has_capability = WSChiaConnection.has_capability
+
+    def __init__(self, farmer_config: Dict):
+        self.peer_node_id = bytes32(token_bytes(32))
+        self.local_capabilities = capabilities_from_config({"quality_announce": True})
+        self.peer_capabilities = capabilities_from_config(farmer_config)
+        self.sent: List[Message] = []
+
+    async def send_message(self, message: Message):
+        self.sent.append(message)
+
+
+class FakeProver:
+    def __init__(self):
+        self.id = bytes32(token_bytes(32))
+
+    def get_id(self) -> bytes32:
+        return self.id
+
+    def get_size(self) -> int:
+        return 32
+
+    def get_qualities_for_challenge(self, challenge: bytes32) -> List[bytes32]:
+        return [bytes32(token_bytes(32))]
+
+
+def make_farmer() -> Farmer:
+    farmer = Farmer.__new__(Farmer)
+    farmer.log = logging.getLogger(__name__)
+    farmer.constants = DEFAULT_CONSTANTS
+    farmer.sp_store = SignagePointStore(expiry_seconds=100, bucket_seconds=10, max_signage_points=100)
+    return farmer
+
+
+def make_harvester_api(plot_directory: Path, plot_count: int) -> HarvesterAPI:
+    harvester = Harvester.__new__(Harvester)
+    harvester.log = logging.getLogger(__name__)
+    harvester.constants = CONSTANTS
+    harvester.farmer_public_keys = [G1Element()]
+    harvester.pool_public_keys = [G1Element()]
+    harvester._is_shutdown = False
+    harvester.provers = {}
+    for i in range(plot_count):
+        filename = (plot_directory / f"plot-{i}.plot").resolve()
+        filename.touch()
+        harvester.provers[filename] = PlotInfo(FakeProver(), G1Element(), None, G1Element(), 0, 0)
+    harvester.plot_filter_paths = list(harvester.provers.keys())
+    harvester.plot_filter_ids = b"".join(info.prover.get_id() for info in harvester.provers.values())
+    harvester.executor = ThreadPoolExecutor(max_workers=2)
+    harvester.lookup_scheduler = LookupScheduler(harvester.executor, 2)
+    harvester.lookup_stats = LookupStats(10)
+
+    harvester_api = HarvesterAPI(harvester)
+    harvester_api.proof_lookups = []
+
+    def lookup_proof(
+        filename: Path, plot_info: PlotInfo, challenge_hash: bytes32, sp_hash: bytes32, index: int
+    ) -> Optional[ProofOfSpace]:
+        harvester_api.proof_lookups.append((filename, index))
+        return ProofOfSpace(challenge_hash, G1Element(), None, G1Element(), uint8(32), b"")
+
+    harvester_api._blocking_lookup_proof = lookup_proof
+    return harvester_api
+
+
+def make_sp() -> NewSignagePoint:
+    return NewSignagePoint(
+        bytes32(token_bytes(32)), bytes32(token_bytes(32)), bytes32(token_bytes(32)), uint64(1), uint64(1024), uint8(1)
+    )
+
+
+def make_quality(sp: NewSignagePoint, required_iters: int) -> NewQualityHarvester:
+    return NewQualityHarvester(
+        sp.challenge_hash,
+        sp.challenge_chain_sp,
+        token_bytes(32).hex() + "plot",
+        uint8(0),
+        uint64(required_iters),
+        uint8(1),
+    )
+
+
+@pytest.fixture(scope="module")
+def event_loop():
+    loop = asyncio.get_event_loop()
+    yield loop
+
+
+class TestQualityAnnounce:
+    @pytest.mark.asyncio
+    async def test_farmer_caps_requested_proofs(self):
+        farmer = make_farmer()
+        farmer_api = FarmerAPI(farmer)
+        sp = make_sp()
+        farmer.sp_store.add_signage_point(sp)
+        for _ in range(MAX_POS_PER_SP):
+            msg = await farmer_api.new_quality_harvester(make_quality(sp, 0))
+            assert msg.type == ProtocolMessageTypes.request_proof_of_space.value
+        assert await farmer_api.new_quality_harvester(make_quality(sp, 0)) is None
+        assert farmer.sp_store.get(sp.challenge_chain_sp).number_of_requested_proofs == MAX_POS_PER_SP
+
+    @pytest.mark.asyncio
+    async def test_farmer_rejects_qualities_that_are_not_good_enough(self):
+        farmer = make_farmer()
+        farmer_api = FarmerAPI(farmer)
+        sp = make_sp()
+        farmer.sp_store.add_signage_point(sp)
+        sp_interval_iters = calculate_sp_interval_iters(DEFAULT_CONSTANTS, sp.sub_slot_iters)
+        assert await farmer_api.new_quality_harvester(make_quality(sp, sp_interval_iters)) is None
+        assert farmer.sp_store.get(sp.challenge_chain_sp).number_of_requested_proofs == 0
+        msg = await farmer_api.new_quality_harvester(make_quality(sp, sp_interval_iters - 1))
+        assert msg.type == ProtocolMessageTypes.request_proof_of_space.value
+
+        # Signage points we do not have are ignored
+        unknown = make_sp()
+        assert await farmer_api.new_quality_harvester(make_quality(unknown, 0)) is None
+
+    @pytest.mark.asyncio
+    async def test_harvester_looks_up_requested_proofs_only(self, tmp_path):
+        harvester_api = make_harvester_api(tmp_path, 3)
+        filenames = list(harvester_api.harvester.provers.keys())
+        challenge_hash, sp_hash = bytes32(token_bytes(32)), bytes32(token_bytes(32))
+        plot_identifier = token_bytes(32).hex() + str(filenames[1])
+        msg = await harvester_api.request_proof_of_space(
+            RequestProofOfSpace(challenge_hash, sp_hash, plot_identifier, uint8(2), uint8(1))
+        )
+        assert msg.type == ProtocolMessageTypes.new_proof_of_space.value
+        assert harvester_api.proof_lookups == [(filenames[1], 2)]
+
+        missing = token_bytes(32).hex() + str(tmp_path / "missing.plot")
+        assert (
+            await harvester_api.request_proof_of_space(
+                RequestProofOfSpace(challenge_hash, sp_hash, missing, uint8(0), uint8(1))
+            )
+            is None
+        )
+        assert len(harvester_api.proof_lookups) == 1
+        harvester_api.harvester.executor.shutdown()
+
+    @pytest.mark.asyncio
+    async def test_harvester_announces_qualities_only_to_farmers_with_capability(self, tmp_path):
+        harvester_api = make_harvester_api(tmp_path, 3)
+        new_sp = NewSignagePointHarvester(
+            bytes32(token_bytes(32)), uint64(1), SUB_SLOT_ITERS, uint8(1), bytes32(token_bytes(32))
+        )
+
+        farmer = FakeFarmerConnection({"quality_announce": True})
+        await harvester_api.new_signage_point_harvester(new_sp, farmer)
+        assert [m.type for m in farmer.sent] == [ProtocolMessageTypes.new_quality_harvester.value] * 3 + [
+            ProtocolMessageTypes.farming_info.value
+        ]
+        # No full proof is read until the farmer asks for it
+        assert harvester_api.proof_lookups == []
+
+        old_farmer = FakeFarmerConnection({})
+        await harvester_api.new_signage_point_harvester(new_sp, old_farmer)
+        assert [m.type for m in old_farmer.sent] == [ProtocolMessageTypes.new_proof_of_space.value] * 3 + [
+            ProtocolMessageTypes.farming_info.value
+        ]
+        assert sorted(harvester_api.proof_lookups) == sorted(
+            (filename, 0) for filename in harvester_api.harvester.provers
+        )
+        harvester_api.harvester.executor.shutdown()
@@ -0,0 +1,49 @@
+from secrets import token_bytes
+
+from chia.farmer.signage_point_store import SignagePointStore
+from chia.protocols.farmer_protocol import NewSignagePoint
+from chia.types.blockchain_format.sized_bytes import bytes32
+from chia.util.ints import uint8, uint64
+
+
+def make_sp() -> NewSignagePoint:
+    return NewSignagePoint(
+        bytes32(token_bytes(32)),
+        bytes32(token_bytes(32)),
+        bytes32(token_bytes(32)),
+        uint64(1),
+        uint64(1024),
+        uint8(1),
+    )
+
+
+class TestSignagePointStore:
+    def test_expires_whole_buckets(self):
+        store = SignagePointStore(expiry_seconds=100, bucket_seconds=10, max_signage_points=100)
+        old_sp = make_sp()
+        new_sp = make_sp()
+        store.add_signage_point(old_sp, now=1000)
+        store.add_signage_point(new_sp, now=1095)
+        state = store.get(old_sp.challenge_chain_sp)
+        assert state.received_time == 1000
+        quality = bytes32(token_bytes(32))
+        store.add_proof(state, "plot", None, quality, ("plot", old_sp.challenge_hash, old_sp.challenge_chain_sp, None))
+
+        assert store.expire(now=1105) == 0
+        assert store.expire(now=1111) == 1
+        assert store.get(old_sp.challenge_chain_sp) is None
+        assert quality not in store.quality_str_to_identifiers
+        assert store.get(new_sp.challenge_chain_sp) is not None
+        assert len(store.buckets) == 1
+
+    def test_bounded(self):
+        store = SignagePointStore(expiry_seconds=100, bucket_seconds=10, max_signage_points=3)
+        sps = [make_sp() for _ in range(5)]
+        for sp in sps:
+            store.add_signage_point(sp, now=1000)
+        assert [sp.challenge_chain_sp in store.states for sp in sps] == [False, False, True, True, True]
+
+        # The same challenge chain sp again only adds the sp
+        store.add_signage_point(sps[4], now=1000)
+        assert len(store.get(sps[4].challenge_chain_sp).sps) == 2
+        assert store.get_counters()["signage_points"] == 3
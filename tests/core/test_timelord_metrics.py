@@ -0,0 +1,41 @@
+from chia.timelord.timelord_metrics import TimelordMetrics
+from chia.timelord.types import Chain
+
+
+class TestTimelordMetrics:
+    def test_proof_latency(self):
+        metrics = TimelordMetrics()
+        metrics.iterations_submitted(Chain.CHALLENGE_CHAIN, 1000, now=100)
+        metrics.iterations_submitted(Chain.REWARD_CHAIN, 1000, now=100)
+        metrics.proof_received(Chain.CHALLENGE_CHAIN, 1000, 250000, now=104)
+        # Not submitted since the last reset
+        metrics.proof_received(Chain.CHALLENGE_CHAIN, 2000, 260000, now=105)
+        metrics.proof_received(Chain.BLUEBOX, 3000, 100000, submit_time=95, now=105)
+
+        chains = metrics.to_json_dict(now=106)["chains"]
+        assert chains["CHALLENGE_CHAIN"]["ips"] == 260000
+        assert chains["CHALLENGE_CHAIN"]["proofs"] == 2
+        latency = chains["CHALLENGE_CHAIN"]["proof_latency"]
+        assert latency["count"] == 1 and latency["max"] == 4
+        assert chains["BLUEBOX"]["proof_latency"]["max"] == 10
+        assert "REWARD_CHAIN" not in chains
+
+    def test_peak_reset_lag(self):
+        metrics = TimelordMetrics()
+        metrics.chains_reset(now=100)
+        metrics.new_peak_received(now=200)
+        metrics.new_peak_received(now=200.5)
+        metrics.iterations_submitted(Chain.REWARD_CHAIN, 1000, now=200)
+        metrics.chains_reset(now=201)
+        assert metrics.submitted == {}
+
+        result = metrics.to_json_dict(now=202)
+        assert result["chain_resets"] == 2
+        assert result["peak_reset_lag"]["count"] == 1
+        assert result["peak_reset_lag"]["max"] == 1
+
+    def test_vdf_client_sessions(self):
+        metrics = TimelordMetrics()
+        for ip in ["127.0.0.1", "127.0.0.1", "10.0.0.2"]:
+            metrics.vdf_client_connected(ip)
+        assert metrics.to_json_dict()["vdf_client_sessions"] == {"127.0.0.1": 2, "10.0.0.2": 1}
@@ -0,0 +1,108 @@
+import asyncio
+import time
+from secrets import token_bytes
+from typing import Dict, List
+
+import pytest
+
+from chia.consensus.default_constants import DEFAULT_CONSTANTS
+from chia.timelord.timelord import Timelord
+from chia.timelord.types import Chain
+from chia.types.blockchain_format.classgroup import ClassgroupElement
+from chia.types.blockchain_format.sized_bytes import bytes32
+from chia.util.ints import uint64
+from chia.util.vdf_prover import get_vdf_info_and_proof
+
+
+class FakeWriter:
+    def __init__(self):
+        self.written: List[bytes] = []
+
+    def write(self, data: bytes):
+        self.written.append(data)
+
+    async def drain(self):
+        pass
+
+
+def make_timelord(proof_verification_rate: float) -> Timelord:
+    config: Dict = {
+        "vdf_clients": {"ip": ["127.0.0.1"]},
+        "sanitizer_mode": False,
+        "fast_algorithm": False,
+        "vdf_binary_protocol": True,
+        "proof_verification_rate": proof_verification_rate,
+    }
+    timelord = Timelord(None, config, DEFAULT_CONSTANTS)
+    timelord.lock = asyncio.Lock()
+    return timelord
+
+
+def invalid_proof_session(iterations: int) -> bytes:
+    # A vdf_client that answers with a proof made of random bytes, then stops
+    output = ClassgroupElement.get_default_element().data
+    proof = (
+        iterations.to_bytes(8, "big")
+        + len(output).to_bytes(8, "big")
+        + output
+        + (0).to_bytes(1, "big")
+        + token_bytes(100)
+    )
+    return b"OK" + len(proof).to_bytes(4, "big") + proof + b"STOP"
+
+
+@pytest.fixture(scope="module")
+def event_loop():
+    loop = asyncio.get_event_loop()
+    yield loop
+
+
+class TestTimelordProofVerification:
+    @pytest.mark.asyncio
+    async def test_invalid_proof_is_counted_and_still_used(self):
+        timelord = make_timelord(1.0)
+        chain = Chain.CHALLENGE_CHAIN
+        timelord.chain_start_time = {chain: time.time()}
+        reader = asyncio.StreamReader()
+        reader.feed_data(invalid_proof_session(1000))
+        reader.feed_eof()
+        await timelord._do_process_communication(
+            chain,
+            bytes32(token_bytes(32)),
+            ClassgroupElement.get_default_element(),
+            "127.0.0.1",
+            reader,
+            FakeWriter(),
+            proof_label=1,
+        )
+        # The proof is used right away, it is checked afterwards
+        assert [(c, info.number_of_iterations, label) for c, info, _, label in timelord.proofs_finished] == [
+            (chain, 1000, 1)
+        ]
+        await asyncio.gather(*timelord.verification_tasks)
+        assert timelord.proofs_verified == 1
+        assert timelord.invalid_proofs_count == 1
+        assert timelord.get_metrics()["invalid_proofs"] == 1
+        timelord.verify_executor.shutdown()
+
+    @pytest.mark.asyncio
+    async def test_verification_rate(self):
+        initial_form = ClassgroupElement.get_default_element()
+        vdf_info, vdf_proof = get_vdf_info_and_proof(
+            DEFAULT_CONSTANTS, initial_form, bytes32(token_bytes(32)), uint64(100)
+        )
+
+        timelord = make_timelord(1.0)
+        for _ in range(3):
+            timelord._schedule_proof_verification(Chain.CHALLENGE_CHAIN, initial_form, vdf_info, vdf_proof)
+        await asyncio.gather(*timelord.verification_tasks)
+        assert timelord.proofs_verified == 3
+        assert timelord.invalid_proofs_count == 0
+        timelord.verify_executor.shutdown()
+
+        timelord = make_timelord(0)
+        for _ in range(3):
+            timelord._schedule_proof_verification(Chain.CHALLENGE_CHAIN, initial_form, vdf_info, vdf_proof)
+        assert len(timelord.verification_tasks) == 0
+        assert timelord.proofs_verified == 0
+        timelord.verify_executor.shutdown()
@@ -0,0 +1,32 @@
+from chia.timelord.vdf_client_protocol import (
+    STOP_ITERATIONS,
+    decode_proof,
+    encode_discriminant,
+    encode_iterations,
+    encode_mode,
+)
+
+
+class TestVDFClientProtocol:
+    def test_text_protocol(self):
+        assert encode_mode(False, True, False) == b"N"
+        assert encode_discriminant("-0x3039", False) == b"007-0x3039"
+        assert encode_iterations(123456789, False) == b"09123456789"
+        assert encode_iterations(12345678901, False) == b"1112345678901"
+        assert encode_iterations(STOP_ITERATIONS, False) == b"010"
+
+    def test_binary_protocol(self):
+        assert encode_mode(True, False, True) == b"s"
+        disc = -((1 << 1023) + 7)
+        encoded = encode_discriminant(hex(disc), True)
+        assert int.from_bytes(encoded[:2], "big") == 128
+        assert -int.from_bytes(encoded[2:], "big") == disc
+        assert encode_iterations(1000, True) == (1000).to_bytes(8, "big")
+
+    def test_decode_proof(self):
+        y = bytes(range(100))
+        proof = bytes([7] * 50)
+        raw = (1000).to_bytes(8, "big") + len(y).to_bytes(8, "big") + y + bytes([2]) + proof
+        expected = (1000, y, 2, proof)
+        assert decode_proof(raw, True) == expected
+        assert decode_proof(raw.hex().encode(), False) == expected
@@ -21,3 +21,19 @@ class TestProofOfSpace:
                 success_count += 1
 
         assert abs((success_count * target_filter / num_trials) - 1) < 0.35
+
+    def test_plots_passing_filter_matches_single_plot_filter(self):
+        for zero_bits in (0, 4, DEFAULT_CONSTANTS.NUMBER_ZERO_BITS_PLOT_FILTER):
+            constants = DEFAULT_CONSTANTS.replace(NUMBER_ZERO_BITS_PLOT_FILTER=zero_bits)
+            challenge_hash = token_bytes(32)
+            sp_output = token_bytes(32)
+            plot_ids = [token_bytes(32) for _ in range(5000)]
+
+            expected = [
+                index
+                for index, plot_id in enumerate(plot_ids)
+                if ProofOfSpace.passes_plot_filter(constants, plot_id, challenge_hash, sp_output)
+            ]
+            assert len(expected) > 0
+            passing = ProofOfSpace.plots_passing_filter(constants, b"".join(plot_ids), challenge_hash, sp_output)
+            assert passing == expected
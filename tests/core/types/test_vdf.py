@@ -0,0 +1,40 @@
+import dataclasses
+from concurrent.futures import ProcessPoolExecutor
+from secrets import token_bytes
+
+from chia.consensus.default_constants import DEFAULT_CONSTANTS
+from chia.types.blockchain_format.classgroup import ClassgroupElement
+from chia.types.blockchain_format.sized_bytes import bytes32
+from chia.types.blockchain_format.vdf import _get_vdf_executor, batch_verify_vdfs
+from chia.util.ints import uint8, uint64
+from chia.util.vdf_prover import get_vdf_info_and_proof
+
+
+class TestBatchVerifyVDFs:
+    def test_batch_matches_single_verification(self):
+        default_el = ClassgroupElement.get_default_element()
+        challenges = [bytes32(token_bytes(32)), bytes32(token_bytes(32))]
+        proofs = []
+        for challenge in challenges:
+            for iters in (10, 25):
+                info, proof = get_vdf_info_and_proof(DEFAULT_CONSTANTS, default_el, challenge, uint64(iters))
+                proofs.append((proof, default_el, info))
+
+        wrong_iters_info = dataclasses.replace(proofs[0][2], number_of_iterations=uint64(11))
+        proofs.append((proofs[0][0], default_el, wrong_iters_info))
+        too_many_witnesses = uint8(DEFAULT_CONSTANTS.MAX_VDF_WITNESS_SIZE)
+        proofs.append((dataclasses.replace(proofs[1][0], witness_type=too_many_witnesses), default_el, proofs[1][2]))
+
+        results = batch_verify_vdfs(DEFAULT_CONSTANTS, proofs)
+        assert results == [True, True, True, True, False, False]
+        for (proof, input_el, info), valid in zip(proofs, results):
+            assert proof.is_valid(DEFAULT_CONSTANTS, input_el, info) == valid
+
+    def test_empty_batch(self):
+        assert batch_verify_vdfs(DEFAULT_CONSTANTS, []) == []
+
+    def test_thread_pool_only_in_main_process(self):
+        # Block validation workers verify on their own thread, they already use one core each
+        with ProcessPoolExecutor(max_workers=1) as pool:
+            assert pool.submit(_get_vdf_executor).result() is None
+        assert _get_vdf_executor() is not None
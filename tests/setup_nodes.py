@@ -288,6 +288,7 @@ async def setup_timelord(port, full_node_port, sanitizer, consensus_constants: C
     config["full_node_peer"]["port"] = full_node_port
     config["sanitizer_mode"] = sanitizer
     config["fast_algorithm"] = False
+    config["rpc_port"] = port + 1000
     if sanitizer:
         config["vdf_server"]["port"] = 7999
 
@@ -1,14 +1,20 @@
 # flake8: noqa: F811, F401
 import asyncio
+from secrets import token_bytes
+from typing import List
 
 import pytest
 
 from chia.consensus.block_rewards import calculate_base_farmer_reward, calculate_pool_reward
 from chia.protocols import full_node_protocol
 from chia.simulator.simulator_protocol import FarmNewBlockProtocol
+from chia.types.blockchain_format.sized_bytes import bytes32
 from chia.types.peer_info import PeerInfo
+from chia.util.hash import std_hash
 from chia.util.ints import uint16, uint32
+from chia.wallet.wallet_node import WalletNode
 from chia.wallet.wallet_state_manager import WalletStateManager
+from chia.wallet.wallet_sync_store import WalletSyncStore
 from tests.connection_utils import disconnect_all_and_reconnect
 from tests.core.fixtures import default_400_blocks, default_1000_blocks
 from tests.setup_nodes import bt, self_hostname, setup_node_and_wallet, setup_simulators_and_wallets, test_constants
@@ -22,6 +28,21 @@ def wallet_height_at_least(wallet_node, h):
     return False
 
 
+class FakeFullNodeConnection:
+    def __init__(self):
+        self.peer_node_id = bytes32(token_bytes(32))
+        self.peer_host = "1.2.3.4"
+        self.closed = False
+
+
+class FakeServer:
+    def __init__(self, connections: List[FakeFullNodeConnection]):
+        self.connections = connections
+
+    def get_full_node_connections(self):
+        return self.connections
+
+
 @pytest.fixture(scope="session")
 def event_loop():
     loop = asyncio.get_event_loop()
@@ -39,6 +60,11 @@ class TestWalletSync:
         async for _ in setup_simulators_and_wallets(1, 1, {}):
             yield _
 
+    @pytest.fixture(scope="function")
+    async def wallet_nodes_same_key(self):
+        async for _ in setup_simulators_and_wallets(1, 4, {}, key_seed=std_hash(b"sync")):
+            yield _
+
     @pytest.fixture(scope="function")
     async def wallet_node_starting_height(self):
         async for _ in setup_node_and_wallet(test_constants, starting_height=100):
@@ -196,3 +222,91 @@ class TestWalletSync:
 
         await time_out_assert(10, get_tx_count, 2, 1)
         await time_out_assert(10, wallet.get_confirmed_balance, funds)
+
+    @pytest.mark.asyncio
+    async def test_parallel_sync_matches_serial_sync(self, wallet_nodes_same_key, default_400_blocks):
+        num_blocks = 5
+        full_nodes, wallets = wallet_nodes_same_key
+        full_node_api = full_nodes[0]
+        fn_server = full_node_api.full_node.server
+        spender_node, spender_server = wallets[0]
+        wallet = spender_node.wallet_state_manager.main_wallet
+        ph = await wallet.get_new_puzzlehash()
+
+        for block in default_400_blocks:
+            await full_node_api.full_node.respond_block(full_node_protocol.RespondBlock(block))
+        await spender_server.start_client(PeerInfo(self_hostname, uint16(fn_server._port)), None)
+        await time_out_assert(100, wallet_height_at_least, True, spender_node, len(default_400_blocks) - 1)
+
+        # Rewards, and a transaction that spends some of them in a later block
+        for i in range(0, num_blocks):
+            await full_node_api.farm_new_transaction_block(FarmNewBlockProtocol(ph))
+        funds = sum(
+            [calculate_pool_reward(uint32(i)) + calculate_base_farmer_reward(uint32(i)) for i in range(1, num_blocks)]
+        )
+        await time_out_assert(10, wallet.get_confirmed_balance, funds)
+        tx = await wallet.generate_signed_transaction(10, await wallet.get_new_puzzlehash(), 0)
+        await wallet.push_transaction(tx)
+        for i in range(0, num_blocks):
+            await full_node_api.farm_new_transaction_block(FarmNewBlockProtocol(ph))
+        await time_out_assert(10, wallet.get_unconfirmed_balance, await wallet.get_confirmed_balance())
+        peak_height = full_node_api.full_node.blockchain.get_peak_height()
+        await time_out_assert(10, wallet_height_at_least, True, spender_node, peak_height)
+
+        serial_node, serial_server = wallets[1]
+        serial_node.config = dict(serial_node.config, sync_parallel_requests=1)
+        parallel_node, parallel_server = wallets[2]
+        parallel_node.config = dict(parallel_node.config, sync_parallel_requests=4)
+        # The coins of interest change during the batch, so every block with coins for us takes the fallback path
+        fallback_node, fallback_server = wallets[3]
+        fallback_node.config = dict(fallback_node.config, sync_parallel_requests=4)
+        prefetch_additions_removals = fallback_node._prefetch_additions_removals
+
+        async def prefetch_without_coins_of_interest(*args):
+            prefetched = await prefetch_additions_removals(*args)
+            for entry in prefetched.values():
+                entry.puzzle_hashes = set()
+                entry.coin_names = set()
+            return prefetched
+
+        fallback_node._prefetch_additions_removals = prefetch_without_coins_of_interest
+
+        for _, server in wallets[1:]:
+            await server.start_client(PeerInfo(self_hostname, uint16(fn_server._port)), None)
+        expected_coins = await spender_node.wallet_state_manager.coin_store.get_all_coins()
+        assert any(record.spent for record in expected_coins)
+        for node, _ in wallets[1:]:
+            await time_out_assert(100, wallet_height_at_least, True, node, peak_height)
+            synced_wallet = node.wallet_state_manager.main_wallet
+            assert await synced_wallet.get_confirmed_balance() == await wallet.get_confirmed_balance()
+            assert await node.wallet_state_manager.coin_store.get_all_coins() == expected_coins
+
+    @pytest.mark.asyncio
+    async def test_header_blocks_are_requested_from_peers_that_have_them(self):
+        behind, ahead, unknown = FakeFullNodeConnection(), FakeFullNodeConnection(), FakeFullNodeConnection()
+        wallet_node = WalletNode.__new__(WalletNode)
+        wallet_node.full_node_peer = None
+        wallet_node.server = FakeServer([behind, ahead, unknown])
+        sync_store = await WalletSyncStore.create()
+        wallet_node.wallet_state_manager = type("FakeWalletStateManager", (), {"sync_store": sync_store})()
+        # unknown never announced a peak
+        sync_store.peer_has_peak(behind.peer_node_id, uint32(100))
+        sync_store.peer_has_peak(ahead.peer_node_id, uint32(300))
+
+        async def fetch_header_blocks(peer, start_height, end_height):
+            return []
+
+        wallet_node._fetch_header_blocks = fetch_header_blocks
+        prefetch = {}
+        for index, (start_height, end_height) in enumerate([(0, 100), (100, 200), (200, 300)]):
+            wallet_node._prefetch_header_blocks(prefetch, index, uint32(start_height), uint32(end_height))
+        await asyncio.gather(*[task for _, task in prefetch.values()])
+        assert prefetch[0][0] is behind
+        assert prefetch[1][0] is ahead
+        assert prefetch[2][0] is ahead
+
+        # Nobody else has the blocks once the only peer that does disconnects
+        wallet_node.on_disconnect(ahead)
+        assert wallet_node._peers_with_blocks(uint32(200)) == []
+        wallet_node._prefetch_header_blocks(prefetch, 3, uint32(100), uint32(200))
+        assert 3 not in prefetch
@@ -1,6 +1,8 @@
 # flake8: noqa: F811, F401
 import asyncio
 import sys
+import threading
+from concurrent.futures import ThreadPoolExecutor
 from typing import Dict, List, Optional, Tuple
 
 import aiosqlite
@@ -13,6 +15,7 @@ from chia.consensus.default_constants import DEFAULT_CONSTANTS
 from chia.consensus.difficulty_adjustment import get_next_sub_slot_iters_and_difficulty
 from chia.consensus.full_block_to_block_record import block_to_block_record
 from chia.full_node.block_store import BlockStore
+from chia.full_node import weight_proof
 from chia.full_node.coin_store import CoinStore
 from chia.server.start_full_node import SERVICE_NAME
 from chia.types.blockchain_format.sized_bytes import bytes32
@@ -500,6 +503,63 @@ class TestWeightProof:
         assert valid
         assert fork_point != 0
 
+    @pytest.mark.asyncio
+    async def test_concurrent_proofs_share_caches(self, default_1000_blocks):
+        blocks = default_1000_blocks
+        header_cache, height_to_hash, sub_blocks, summaries = await load_blocks_dont_validate(blocks)
+        tips = [blocks[-1].header_hash, blocks[-1].header_hash, blocks[-101].header_hash, blocks[-1].header_hash]
+        expected = []
+        for tip in tips:
+            wpf = WeightProofHandler(test_constants, BlockCache(sub_blocks, header_cache, height_to_hash, summaries))
+            expected.append(await wpf._create_proof_of_weight(tip))
+        # One handler asked for proofs of different tips at the same time gives the same proofs
+        wpf = WeightProofHandler(test_constants, BlockCache(sub_blocks, header_cache, height_to_hash, summaries))
+        proofs = await asyncio.gather(*[wpf.get_proof_of_weight(tip) for tip in tips])
+        assert proofs == expected
+        # A request for the tip that was just built waits for it instead of building it again
+        assert proofs[1] is proofs[0]
+
+    @pytest.mark.asyncio
+    async def test_failed_segment_cancels_validation(self, default_1000_blocks, monkeypatch):
+        blocks = default_1000_blocks
+        header_cache, height_to_hash, sub_blocks, summaries = await load_blocks_dont_validate(blocks)
+        wpf_synced = WeightProofHandler(test_constants, BlockCache(sub_blocks, header_cache, height_to_hash, summaries))
+        wp = await wpf_synced.get_proof_of_weight(blocks[-1].header_hash)
+        assert wp is not None
+        # One task per sampled sub epoch, and at least one for the recent chain
+        tasks = len(weight_proof.map_segments_by_sub_epoch(wp.sub_epoch_segments)) + 1
+        assert tasks > 2
+
+        started: List[str] = []
+        release = threading.Event()
+
+        def first_fails(name, validate):
+            def wrapped(*args):
+                started.append(name)
+                if len(started) == 1:
+                    return False
+                release.wait(10)
+                return validate(*args)
+
+            return wrapped
+
+        for name in ["_validate_sub_epoch", "_validate_recent_chain_pospace", "_validate_recent_blocks"]:
+            monkeypatch.setattr(weight_proof, name, first_fails(name, getattr(weight_proof, name)))
+
+        # A single worker runs the tasks in order, the first sub epoch fails while the rest are still queued
+        executor = ThreadPoolExecutor(max_workers=1)
+        wpf = WeightProofHandler(test_constants, BlockCache(sub_blocks, header_cache, height_to_hash, {}), executor)
+        valid, _, _ = await wpf.validate_weight_proof(wp)
+        assert not valid
+        release.set()
+        executor.shutdown(wait=True)
+        # Only the task the worker picked up next still ran, the others were cancelled
+        assert started[0] == "_validate_sub_epoch"
+        assert len(started) <= 2
+        # The executor belongs to the caller
+        wpf.shut_down()
+        assert wpf.executor is executor
+
     @pytest.mark.skip("used for debugging")
     @pytest.mark.asyncio
     async def test_weight_proof_from_database(self):